@@ -8,6 +8,14 @@ enum SensorID : int16_t{
   SensorID_left_jogdial_rotaryenc,
   SensorID_left_loop_in_button,
   SensorID_left_loop_out_button,
+  SensorID_left_hot_cue_1_button,
+  SensorID_left_hot_cue_2_button,
+  SensorID_left_hot_cue_3_button,
+  SensorID_left_hot_cue_4_button,
+  SensorID_left_hot_cue_5_button,
+  SensorID_left_hot_cue_6_button,
+  SensorID_left_hot_cue_7_button,
+  SensorID_left_hot_cue_8_button,
 
   SensorID_right_playpause_button = 25,
   SensorID_right_cue_button,
@@ -15,6 +23,14 @@ enum SensorID : int16_t{
   SensorID_right_jogdial_rotaryenc,
   SensorID_right_loop_in_button,
   SensorID_right_loop_out_button,
+  SensorID_right_hot_cue_1_button,
+  SensorID_right_hot_cue_2_button,
+  SensorID_right_hot_cue_3_button,
+  SensorID_right_hot_cue_4_button,
+  SensorID_right_hot_cue_5_button,
+  SensorID_right_hot_cue_6_button,
+  SensorID_right_hot_cue_7_button,
+  SensorID_right_hot_cue_8_button,
 };
 
 #endif
\ No newline at end of file
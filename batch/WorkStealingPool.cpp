@@ -0,0 +1,94 @@
+#include "WorkStealingPool.hpp"
+
+#include <iostream>
+
+WorkStealingPool::WorkStealingPool(const std::uint32_t worker_count){
+	const std::uint32_t started_worker_count = worker_count > 0 ? worker_count : 1;
+	for(std::uint32_t i = 0; i < started_worker_count; i++)
+		this->workers.push_back(std::make_unique<Worker>());
+	for(std::uint32_t i = 0; i < started_worker_count; i++)
+		this->threads.emplace_back(&WorkStealingPool::run, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool(){
+	this->wait_until_idle();
+	{
+		std::lock_guard<std::mutex> _(this->state_mutex);
+		this->stop_requested = true;
+	}
+	this->task_condition.notify_all();
+	for(std::thread& thread : this->threads)
+		thread.join();
+}
+
+void WorkStealingPool::submit(Task task){
+	//Counted before it is queued, so a worker taking it at once never counts below 0.
+	{
+		std::lock_guard<std::mutex> _(this->state_mutex);
+		this->unfinished_tasks++;
+		this->queued_tasks++;
+	}
+	Worker& worker = *(this->workers[this->next_worker]);
+	this->next_worker = (this->next_worker + 1) % this->workers.size();
+	{
+		std::lock_guard<std::mutex> _(worker.queue_mutex);
+		worker.queue.push_back(std::move(task));
+	}
+	this->task_condition.notify_one();
+}
+
+void WorkStealingPool::wait_until_idle(){
+	std::unique_lock<std::mutex> state_lock(this->state_mutex);
+	this->idle_condition.wait(state_lock, [this]{
+		return this->unfinished_tasks == 0;
+	});
+}
+
+void WorkStealingPool::run(const std::uint32_t worker_index) noexcept{
+	while(true){
+		Task task;
+		if(not this->take_task(worker_index, task)){
+			std::unique_lock<std::mutex> state_lock(this->state_mutex);
+			this->task_condition.wait(state_lock, [this]{
+				return this->stop_requested or this->queued_tasks.load() > 0;
+			});
+			if(this->stop_requested) return;
+			continue;
+		}
+
+		try{
+			task();
+		}
+		catch(const std::exception& e){
+			std::cerr << "WorkStealingPool: task threw: " << e.what() << '\n';
+		}
+		catch(...){
+			std::cerr << "WorkStealingPool: task threw.\n";
+		}
+
+		std::lock_guard<std::mutex> _(this->state_mutex);
+		this->unfinished_tasks--;
+		if(this->unfinished_tasks == 0) this->idle_condition.notify_all();
+	}
+}
+
+bool WorkStealingPool::take_task(const std::uint32_t worker_index, Task& task){
+	for(std::uint32_t offset = 0; offset < this->workers.size(); offset++){
+		Worker& worker = *(this->workers[(worker_index + offset) % this->workers.size()]);
+		std::lock_guard<std::mutex> _(worker.queue_mutex);
+		if(worker.queue.empty()) continue;
+
+		//In the order submitted, so tasks submitted longest first run longest first; a thief takes the task its owner would run last.
+		const bool own_queue = offset == 0;
+		if(own_queue){
+			task = std::move(worker.queue.front());
+			worker.queue.pop_front();
+		}else{
+			task = std::move(worker.queue.back());
+			worker.queue.pop_back();
+		}
+		this->queued_tasks--;
+		return true;
+	}
+	return false;
+}
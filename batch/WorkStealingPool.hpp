@@ -0,0 +1,71 @@
+/**
+\file WorkStealingPool.hpp
+*/
+
+#ifndef WorkStealingPool_hpp
+#define WorkStealingPool_hpp
+
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <condition_variable>
+
+/**
+A fixed set of worker threads, each with its own queue of tasks.
+
+Tasks are handed out to the queues in turn. A worker runs the tasks of its own queue from the front, in the order they were submitted,
+and once it is empty steals from the back of the queues of the other workers,
+so a worker which drew long tasks does not hold up the rest of the pool.
+*/
+class WorkStealingPool{
+	public:
+	using Task = std::function<void()>;
+
+	///Starts *worker_count* workers, at least 1.
+	explicit WorkStealingPool(const std::uint32_t worker_count);
+	///Waits for every task submitted before stopping the workers.
+	~WorkStealingPool();
+
+	WorkStealingPool(const WorkStealingPool&) = delete;
+	WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+	void submit(Task task);
+	///Waits until every task submitted has ran.
+	void wait_until_idle();
+
+	std::uint32_t get_worker_count() const noexcept{
+		return this->workers.size();
+	}
+
+	private:
+	struct Worker{
+		std::mutex queue_mutex;
+		std::deque<Task> queue;
+	};
+
+	void run(const std::uint32_t worker_index) noexcept;
+	///Takes a task from the front of the queue of *worker_index*, or steals one from the back of another queue.
+	bool take_task(const std::uint32_t worker_index, Task& task);
+
+	std::vector<std::unique_ptr<Worker>> workers;
+	std::vector<std::thread> threads;
+	///The worker the next task submitted is queued to.
+	std::uint32_t next_worker = 0;
+
+	///Wakes idle workers when a task is submitted, and waiters once every task ran.
+	std::mutex state_mutex;
+	std::condition_variable task_condition;
+	std::condition_variable idle_condition;
+	///Tasks submitted which have not finished running.
+	std::uint64_t unfinished_tasks = 0;
+	///Tasks queued which no worker has taken yet.
+	std::atomic<std::uint64_t> queued_tasks = 0;
+	bool stop_requested = false;
+};
+
+#endif
@@ -0,0 +1,206 @@
+/*
+analyse.exe: analyses every track of a library ahead of a gig, with the decoding and analysis code of ardcont.
+
+	analyse.exe <library directory> [-j <workers>] [-f] [-c <cache file>]
+
+Every track below the library directory gets its beats and loudness written to its audio info file and its waveform to its waveform file,
+see track_analysis.hpp, and all of them stored to the TrackAnalysisCache ardcont loads tracks from, the default one unless -c says otherwise. Tracks are analysed on a WorkStealingPool of one worker per core unless -j says otherwise, the longest first.
+
+Analysed tracks are appended to a progress file in the library directory along with their size and modification time,
+so an interrupted run picks up where it stopped, and only tracks changed since are analysed again. -f analyses every track again.
+*/
+
+#include "WorkStealingPool.hpp"
+#include "../src/track_analysis.hpp"
+#include "../src/TrackAnalysisCache.hpp"
+
+#include "ntrb/aud_std_fmt.h"
+#include "ntrb/alloc.h"
+
+#include <set>
+#include <cmath>
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <optional>
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <algorithm>
+#include <filesystem>
+
+static constexpr const char* progress_filename = "ardcont_analysis_progress.txt";
+static constexpr std::array<const char*, 2> analysed_extensions{".flac", ".wav"};
+
+struct LibraryTrack{
+	std::filesystem::path path;
+	std::uintmax_t size;
+	std::int64_t modified_time;
+};
+
+///The line of *track* in the progress file.
+static std::string get_progress_entry(const LibraryTrack& track){
+	return std::to_string(track.size) + ' ' + std::to_string(track.modified_time) + ' ' + track.path.string();
+}
+
+static bool is_analysed_extension(const std::filesystem::path& path){
+	std::string extension = path.extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](const unsigned char c){ return std::tolower(c); });
+	return std::find(analysed_extensions.begin(), analysed_extensions.end(), extension) != analysed_extensions.end();
+}
+
+///Every track below *library_directory*, skipping what cannot be read.
+static std::vector<LibraryTrack> find_tracks(const std::filesystem::path& library_directory){
+	std::vector<LibraryTrack> tracks;
+	std::error_code error;
+	std::filesystem::recursive_directory_iterator entry(library_directory, std::filesystem::directory_options::skip_permission_denied, error);
+	for(; not error and entry != std::filesystem::recursive_directory_iterator(); entry.increment(error)){
+		if(not entry->is_regular_file(error) or not is_analysed_extension(entry->path())) continue;
+
+		const std::uintmax_t size = entry->file_size(error);
+		if(error){
+			error.clear();
+			continue;
+		}
+		const std::filesystem::file_time_type modified_time = entry->last_write_time(error);
+		if(error){
+			error.clear();
+			continue;
+		}
+		tracks.push_back(LibraryTrack{entry->path(), size, std::int64_t(modified_time.time_since_epoch().count())});
+	}
+	if(error) std::fprintf(stderr, "Could not walk all of %s: %s\n", library_directory.string().c_str(), error.message().c_str());
+	return tracks;
+}
+
+static std::set<std::string> read_progress(const std::filesystem::path& progress_path){
+	std::set<std::string> analysed_entries;
+	std::ifstream progress_file(progress_path);
+	std::string entry;
+	while(std::getline(progress_file, entry))
+		if(not entry.empty()) analysed_entries.insert(entry);
+	return analysed_entries;
+}
+
+static void print_usage(){
+	std::fprintf(stderr, "Usage: analyse.exe <library directory> [-j <workers>] [-f] [-c <cache file>]\n"
+						 "\t-j <workers>\tworkers analysing at once, one per core by default\n"
+						 "\t-f\t\tanalyse tracks already analysed again\n"
+						 "\t-c <cache file>\tthe analysis cache to store to, %s by default\n", TrackAnalysisCache::default_filename);
+}
+
+int main(int argc, char** argv){
+	#ifdef NTRB_MEMDEBUG
+	ntrb_memdebug_init_with_return_value();
+	#endif
+
+	std::filesystem::path library_directory;
+	std::uint32_t worker_count = std::max(1u, std::thread::hardware_concurrency());
+	bool analyse_again = false;
+	std::string cache_filename = TrackAnalysisCache::default_filename;
+	for(int i = 1; i < argc; i++){
+		const std::string argument = argv[i];
+		if(argument == "-f") analyse_again = true;
+		else if(argument == "-c" and i + 1 < argc) cache_filename = argv[++i];
+		else if(argument == "-j" and i + 1 < argc){
+			try{
+				worker_count = std::max(1, std::stoi(argv[++i]));
+			}
+			catch(const std::exception&){
+				print_usage();
+				return 1;
+			}
+		}
+		else if(library_directory.empty()) library_directory = argument;
+		else{
+			print_usage();
+			return 1;
+		}
+	}
+	if(library_directory.empty() or not std::filesystem::is_directory(library_directory)){
+		print_usage();
+		return 1;
+	}
+
+	std::vector<LibraryTrack> tracks = find_tracks(library_directory);
+	const std::filesystem::path progress_path = library_directory / progress_filename;
+	if(not analyse_again){
+		const std::set<std::string> analysed_entries = read_progress(progress_path);
+		tracks.erase(std::remove_if(tracks.begin(), tracks.end(), [&analysed_entries](const LibraryTrack& track){
+			return analysed_entries.count(get_progress_entry(track)) > 0;
+		}), tracks.end());
+	}
+	//The longest first, so the pool is not left waiting on one long mix at the end.
+	std::sort(tracks.begin(), tracks.end(), [](const LibraryTrack& a, const LibraryTrack& b){
+		return a.size > b.size;
+	});
+
+	std::ofstream progress_file(progress_path, std::ios::app);
+	if(not progress_file){
+		std::fprintf(stderr, "Could not open %s, progress will not be kept.\n", progress_path.string().c_str());
+	}
+	TrackAnalysisCache analysis_cache(cache_filename);
+	std::printf("Analysing %zu tracks with %u workers.\n", tracks.size(), worker_count);
+	std::fflush(stdout);
+
+	std::mutex report_mutex;
+	std::uint64_t finished_tracks = 0;
+	std::uint64_t failed_tracks = 0;
+	std::uint64_t analysed_frames = 0;
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	const auto get_tracks_per_minute = [&start](const std::uint64_t track_count){
+		const double minutes = std::chrono::duration<double, std::ratio<60>>(std::chrono::steady_clock::now() - start).count();
+		return minutes > 0.0 ? track_count / minutes : 0.0;
+	};
+
+	{
+		WorkStealingPool pool(worker_count);
+		for(const LibraryTrack& track : tracks){
+			pool.submit([&, track]{
+				const std::string filename = track.path.string();
+				const std::optional<TrackAnalysis> analysis = analyse_track(filename, []{ return true; });
+				//Stored last, as its record is keyed by the audio info file as written.
+				const bool written = analysis.has_value() and write_audio_info(filename, analysis.value()) and write_waveform_file(filename, analysis.value())
+										and analysis_cache.store(filename, make_track_metadata(analysis.value()));
+
+				std::lock_guard<std::mutex> _(report_mutex);
+				finished_tracks++;
+				if(not written){
+					failed_tracks++;
+					std::printf("[%llu/%zu] failed: %s\n", (unsigned long long)finished_tracks, tracks.size(), filename.c_str());
+					std::fflush(stdout);
+					return;
+				}
+
+				analysed_frames += analysis->frame_count;
+				if(progress_file){
+					progress_file << get_progress_entry(track) << '\n';
+					progress_file.flush();
+				}
+				//Beats not confident enough are printed, marked with '?', but not written.
+				const double bpm = analysis->beats.has_value() ? analysis->beats->bpm : 0.0;
+				const double confidence = analysis->beats.has_value() ? analysis->beats->confidence : 0.0;
+				const char confidence_mark = analysis->beats.has_value() and analysis->beats->is_confident() ? ' ' : '?';
+				const double loudness = analysis->integrated_loudness.value_or(-INFINITY);
+				std::printf("[%llu/%zu] %7.2f bpm%c %4.2f confidence %6.1f LUFS %6.1f tracks/min  %s\n", (unsigned long long)finished_tracks, tracks.size(),
+							bpm, confidence_mark, confidence, loudness, get_tracks_per_minute(finished_tracks), filename.c_str());
+				std::fflush(stdout);
+			});
+		}
+		pool.wait_until_idle();
+	}
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::printf("Analysed %llu tracks, %llu failed, in %.1f s: %.1f tracks/min, %.0fx realtime.\n",
+				(unsigned long long)(finished_tracks - failed_tracks), (unsigned long long)failed_tracks, seconds,
+				get_tracks_per_minute(finished_tracks - failed_tracks), seconds > 0.0 ? (analysed_frames / double(ntrb_std_samplerate)) / seconds : 0.0);
+
+	#ifdef NTRB_MEMDEBUG
+	ntrb_memdebug_uninit(true);
+	#endif
+	return failed_tracks == 0 ? 0 : 1;
+}
@@ -0,0 +1,64 @@
+#include "benchmarks.hpp"
+#include "../src/beat_analysis.hpp"
+
+#include <cmath>
+#include <vector>
+#include <cstdio>
+#include <random>
+
+///*seconds* of a synthetic 4/4 drum loop at *bpm*, with the first downbeat at *first_beat_seconds*: a kick on every beat, accented on the downbeat,
+///a hi-hat on every off-beat and a quiet pad underneath.
+static std::vector<float> synthesise_drum_loop(const double bpm, const double first_beat_seconds, const double seconds, const std::uint32_t samplerate){
+	const std::uint64_t frame_count = seconds * samplerate;
+	const double frames_per_beat = 60.0 * samplerate / bpm;
+	std::minstd_rand random_engine(0);
+	std::uniform_real_distribution<float> random_sample(-1.0, 1.0);
+
+	std::vector<float> samples(frame_count * 2);
+	for(std::uint64_t frame = 0; frame < frame_count; frame++){
+		const double time = (double)frame / samplerate;
+		float sample = 0.05 * std::sin(2 * M_PI * 220.0 * time) * std::sin(2 * M_PI * 0.1 * time);
+
+		const double beat_position = (frame - (first_beat_seconds * samplerate)) / frames_per_beat;
+		if(beat_position >= 0.0){
+			const std::uint64_t beat = beat_position;
+			const double since_beat = (beat_position - beat) * frames_per_beat / samplerate;
+			const float kick_level = beat % 4 == 0 ? 0.9 : 0.5;
+			sample += kick_level * std::exp(-since_beat * 25.0) * std::sin(2 * M_PI * 55.0 * since_beat * (1.0 + std::exp(-since_beat * 40.0)));
+
+			const double since_off_beat = since_beat - (0.5 * frames_per_beat / samplerate);
+			if(since_off_beat >= 0.0) sample += 0.2 * std::exp(-since_off_beat * 80.0) * random_sample(random_engine);
+		}
+		samples[frame*2] = sample;
+		samples[frame*2 + 1] = sample;
+	}
+	return samples;
+}
+
+void bench_beat_analysis(){
+	constexpr std::uint32_t samplerate = 48000;
+	constexpr double seconds = 120.0;
+	constexpr double first_beat_seconds = 0.37;
+
+	std::printf("OnsetDetector and estimate_beats() on %.0f seconds drum loops, first downbeat at %.3f seconds\n", seconds, first_beat_seconds);
+	std::printf("%10s %14s %22s %22s\n", "bpm", "estimated bpm", "first beat error ms", "x realtime per core");
+
+	for(const double bpm : {87.5, 124.0, 128.0, 140.0, 174.0}){
+		const std::vector<float> samples = synthesise_drum_loop(bpm, first_beat_seconds, seconds, samplerate);
+
+		std::optional<BeatEstimate> estimate;
+		const double us_per_track = time_per_call_us([&]{
+			OnsetDetector onset_detector(samplerate);
+			onset_detector.push_frames(samples.data(), samples.size() / 2);
+			estimate = estimate_beats(onset_detector);
+		});
+
+		if(not estimate.has_value()){
+			std::printf("%10.3f %14s\n", bpm, "none");
+			continue;
+		}
+		const double first_beat_error_ms = ((estimate->first_beat_frame / samplerate) - first_beat_seconds) * 1000.0;
+		std::printf("%10.3f %14.3f %22.2f %22.1f\n", bpm, estimate->bpm, first_beat_error_ms, seconds * 1e6 / us_per_track);
+	}
+	std::printf("\n");
+}
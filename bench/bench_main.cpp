@@ -0,0 +1,12 @@
+#include "benchmarks.hpp"
+
+#include <iostream>
+
+int main(){
+	std::cout << "ardcont benchmarks\n" << std::endl;
+	bench_mix_kernel();
+	bench_resampler();
+	bench_time_stretcher();
+	bench_beat_analysis();
+	return 0;
+}
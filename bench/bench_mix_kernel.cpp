@@ -0,0 +1,37 @@
+#include "benchmarks.hpp"
+#include "../src/mix_kernel.hpp"
+
+#include <vector>
+#include <cstdio>
+#include <random>
+
+void bench_mix_kernel(){
+	constexpr std::size_t frames_per_block = 4800;
+	std::minstd_rand random_engine(0);
+	std::uniform_real_distribution<float> random_sample(-1.0, 1.0);
+	
+	std::printf("mix_stereo_buffers() (dispatched to %s), %zu frames per block\n", mix_kernel_name(), frames_per_block);
+	std::printf("%8s %22s %22s\n", "decks", "dispatched frames/us", "scalar frames/us");
+	
+	for(const std::size_t deck_count : {2, 4, 8, 16}){
+		std::vector<std::vector<float>> deck_samples(deck_count, std::vector<float>(frames_per_block * 2));
+		std::vector<const float*> inputs;
+		std::vector<float> left_gains, right_gains;
+		for(std::vector<float>& samples : deck_samples){
+			for(float& sample : samples) sample = random_sample(random_engine);
+			inputs.push_back(samples.data());
+			left_gains.push_back(0.8);
+			right_gains.push_back(0.7);
+		}
+		std::vector<float> output(frames_per_block * 2);
+		
+		const double dispatched_us = time_per_call_us([&]{
+			mix_stereo_buffers(output.data(), inputs.data(), left_gains.data(), right_gains.data(), deck_count, frames_per_block);
+		});
+		const double scalar_us = time_per_call_us([&]{
+			mix_stereo_buffers_scalar(output.data(), inputs.data(), left_gains.data(), right_gains.data(), deck_count, frames_per_block);
+		});
+		std::printf("%8zu %22.1f %22.1f\n", deck_count, frames_per_block / dispatched_us, frames_per_block / scalar_us);
+	}
+	std::printf("\n");
+}
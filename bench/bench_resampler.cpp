@@ -0,0 +1,39 @@
+#include "benchmarks.hpp"
+#include "../src/resampler.hpp"
+
+#include <vector>
+#include <cstdio>
+#include <random>
+
+void bench_resampler(){
+	constexpr std::uint32_t frames_per_block = 4800;
+	//Enough source frames for a block at the fastest speed measured, plus the taps of every interpolation.
+	constexpr std::uint64_t source_frames = frames_per_block * 2;
+	std::minstd_rand random_engine(0);
+	std::uniform_real_distribution<float> random_sample(-1.0, 1.0);
+
+	std::vector<float> source_samples(source_frames * 2);
+	for(float& sample : source_samples) sample = random_sample(random_engine);
+	const SourceSpan source{source_samples.data(), 0, source_frames};
+	std::vector<float> output(frames_per_block * 2);
+
+	std::printf("resample_block() (windowed sinc dispatched to %s), %u frames per block\n", windowed_sinc_kernel_name(), frames_per_block);
+	std::printf("%16s %16s %16s %22s\n", "interpolation", "1x frames/us", "1.125x frames/us", "us per 48kHz second");
+
+	for(std::uint8_t interpolation_id = 0; interpolation_id < resampler_interpolation_names.size(); interpolation_id++){
+		const ResamplerInterpolation interpolation = ResamplerInterpolation(interpolation_id);
+		double us_per_block[2];
+		const double speeds[2] = {1.0, 1.125};
+
+		for(std::uint8_t i = 0; i < 2; i++){
+			us_per_block[i] = time_per_call_us([&]{
+				//Starts past the first frames so the padded path at the start of a track is not measured.
+				PlayheadRamp playhead{16.25, speeds[i], 0.0};
+				resample_block(source, playhead, output.data(), frames_per_block, source_frames, interpolation);
+			});
+		}
+		std::printf("%16s %16.1f %16.1f %22.1f\n", resampler_interpolation_names[interpolation_id],
+					frames_per_block / us_per_block[0], frames_per_block / us_per_block[1], us_per_block[1] * 48000.0 / frames_per_block);
+	}
+	std::printf("\n");
+}
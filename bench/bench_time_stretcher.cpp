@@ -0,0 +1,44 @@
+#include "benchmarks.hpp"
+#include "../src/TimeStretcher.hpp"
+
+#include <cmath>
+#include <vector>
+#include <cstdio>
+#include <random>
+
+void bench_time_stretcher(){
+	constexpr std::uint32_t frames_per_block = 480;
+	constexpr std::uint32_t samplerate = 48000;
+	//Long enough for a second of output at the fastest speed measured, plus a segment.
+	constexpr std::uint64_t source_frames = samplerate * 2;
+	std::minstd_rand random_engine(0);
+	std::uniform_real_distribution<float> random_sample(-0.1, 0.1);
+
+	//A chord with some noise, so the segment search does not find a trivially periodic signal.
+	std::vector<float> source_samples(source_frames * 2);
+	for(std::uint64_t frame = 0; frame < source_frames; frame++){
+		const double seconds = (double)frame / samplerate;
+		const float chord = 0.3 * (std::sin(2 * M_PI * 220.0 * seconds) + std::sin(2 * M_PI * 277.2 * seconds) + std::sin(2 * M_PI * 329.6 * seconds));
+		source_samples[frame*2] = chord + random_sample(random_engine);
+		source_samples[frame*2 + 1] = chord + random_sample(random_engine);
+	}
+	const SourceSpan source{source_samples.data(), 0, source_frames};
+	std::vector<float> output(frames_per_block * 2);
+
+	std::printf("TimeStretcher::render() (%u frame segments, latency %u frames), %u frames per block\n", 
+				TimeStretcher::segment_frames, TimeStretcher::get_latency_frames(), frames_per_block);
+	std::printf("%8s %22s %22s\n", "speed", "us per 48kHz second", "key locked decks/core");
+
+	for(const double speed : {0.875, 1.0, 1.08, 1.125}){
+		TimeStretcher time_stretcher;
+		//Renders a second of audio per call, a block at a time like a deck does.
+		const double us_per_second = time_per_call_us([&]{
+			time_stretcher.reset();
+			PlayheadRamp playhead{(double)TimeStretcher::source_frames_per_segment, speed, 0.0};
+			for(std::uint32_t block = 0; block < samplerate / frames_per_block; block++)
+				time_stretcher.render(source, playhead, output.data(), frames_per_block, source_frames);
+		});
+		std::printf("%8.3f %22.1f %22.1f\n", speed, us_per_second, 1e6 / us_per_second);
+	}
+	std::printf("\n");
+}
@@ -0,0 +1,40 @@
+/**
+\file benchmarks.hpp
+Micro-benchmarks of the audio engine hot paths, ran by bench.exe.
+*/
+
+#ifndef BENCHMARKS_HPP
+#define BENCHMARKS_HPP
+
+#include <chrono>
+#include <cstdint>
+
+/**
+Calls *run_once* until at least *minimum_duration* has passed and returns the average microseconds per call.
+The first call is a warm up and is not timed.
+*/
+template<typename Function>
+double time_per_call_us(Function&& run_once, const std::chrono::milliseconds minimum_duration = std::chrono::milliseconds(200)){
+	run_once();
+	
+	std::uint64_t calls = 0;
+	const auto begin = std::chrono::steady_clock::now();
+	auto now = begin;
+	while(now - begin < minimum_duration){
+		run_once();
+		calls++;
+		now = std::chrono::steady_clock::now();
+	}
+	return std::chrono::duration<double, std::micro>(now - begin).count() / calls;
+}
+
+///Reports the throughput of mix_stereo_buffers() in frames per microsecond, for the dispatched and scalar kernels.
+void bench_mix_kernel();
+///Reports the CPU cost of resample_block() for every ResamplerInterpolation, at 1x and at the edge of the tempo fader.
+void bench_resampler();
+///Reports the CPU cost of key lock with TimeStretcher::render() at a few tempo fader positions, as decks which fit on one core.
+void bench_time_stretcher();
+///Reports the accuracy and the speed against realtime of the beat analysis, on synthetic drum loops of a few tempos.
+void bench_beat_analysis();
+
+#endif
@@ -0,0 +1,24 @@
+#include "AlignedSampleBuffer.hpp"
+
+#include <new>
+#include <cstring>
+
+AlignedSampleBuffer::AlignedSampleBuffer(const std::size_t sample_count)
+:	samples((float*)::operator new(sample_count * sizeof(float), std::align_val_t(alignment))),
+	sample_count(sample_count)
+{
+	std::memset(this->samples, 0, this->sample_count * sizeof(float));
+}
+
+AlignedSampleBuffer::~AlignedSampleBuffer(){
+	if(this->samples)
+		::operator delete(this->samples, std::align_val_t(alignment));
+}
+
+AlignedSampleBuffer::AlignedSampleBuffer(AlignedSampleBuffer&& moved) noexcept
+:	samples(moved.samples),
+	sample_count(moved.sample_count)
+{
+	moved.samples = nullptr;
+	moved.sample_count = 0;
+}
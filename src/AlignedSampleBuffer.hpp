@@ -0,0 +1,76 @@
+/**
+\file AlignedSampleBuffer.hpp
+Fixed size, aligned sample storage for the render path, and the span type it is passed around as.
+*/
+
+#ifndef AlignedSampleBuffer_hpp
+#define AlignedSampleBuffer_hpp
+
+#include <cstddef>
+
+/**
+A non-owning view of contiguous float samples, passed by value through the render path instead of a reference to a container,
+so a stage can neither resize nor reallocate what it is given.
+*/
+struct SampleSpan{
+	float* data;
+	std::size_t size;
+
+	float& operator[](const std::size_t index) const noexcept{
+		return this->data[index];
+	}
+	float* begin() const noexcept{
+		return this->data;
+	}
+	float* end() const noexcept{
+		return this->data + this->size;
+	}
+	///The *count* samples starting at *offset*.
+	SampleSpan subspan(const std::size_t offset, const std::size_t count) const noexcept{
+		return SampleSpan{this->data + offset, count};
+	}
+};
+
+/**
+Zero initialised float samples allocated once at construction, aligned to AlignedSampleBuffer::alignment bytes,
+so SIMD kernels can load them with aligned loads and no two buffers share a cache line.
+
+The size never changes afterwards, nothing in the render path allocates through it.
+*/
+class AlignedSampleBuffer{
+	public:
+	static constexpr std::size_t alignment = 64;
+
+	AlignedSampleBuffer(const std::size_t sample_count);
+	~AlignedSampleBuffer();
+
+	AlignedSampleBuffer(const AlignedSampleBuffer&) = delete;
+	AlignedSampleBuffer& operator=(const AlignedSampleBuffer&) = delete;
+	AlignedSampleBuffer(AlignedSampleBuffer&& moved) noexcept;
+	AlignedSampleBuffer& operator=(AlignedSampleBuffer&&) = delete;
+
+	float& operator[](const std::size_t index) noexcept{
+		return this->samples[index];
+	}
+	const float& operator[](const std::size_t index) const noexcept{
+		return this->samples[index];
+	}
+	float* data() noexcept{
+		return this->samples;
+	}
+	const float* data() const noexcept{
+		return this->samples;
+	}
+	std::size_t size() const noexcept{
+		return this->sample_count;
+	}
+	SampleSpan span() noexcept{
+		return SampleSpan{this->samples, this->sample_count};
+	}
+
+	private:
+	float* samples;
+	std::size_t sample_count;
+};
+
+#endif
@@ -1,209 +1,301 @@
 #include "AudioTrack.hpp"
 #include "ui.hpp"
 #include "GlobalStates.hpp"
+#include "NoAllocationScope.hpp"
 
 #include "ntrb/aud_std_fmt.h"
-#include "ntrb/utils.h"
-
-#include <pthread.h>
 
 #include <mutex>
 #include <cmath>
+#include <limits>
+#include <algorithm>
 #include <vector>
 #include <chrono>
-#include <fstream>
 #include <cstring>
 #include <optional>
 #include <iostream>
 
-AudioTrack::AudioTrack(const std::uint32_t minimum_frames_in_buffer, const uint8_t track_id)
+///How far a beat position may be off a quantize boundary from rounding errors while still being on it.
+static constexpr double beat_position_epsilon = 1e-6;
+
+///Whether the deck plays on through the beats of its track in *play_mode*, so jumps can wait for a quantize boundary.
+static bool plays_through_beats(const AudioTrack_PlayMode play_mode) noexcept{
+	return (play_mode == AudioTrack_regular_play) or (play_mode == AudioTrack_cue_play) or (play_mode == AudioTrack_slowdown_to_halt);
+}
+
+AudioTrack::AudioTrack(const std::uint32_t minimum_frames_in_buffer, const std::uint8_t callbacks_rendered_ahead, const uint8_t track_id, TrackAnalysisCache& analysis_cache)
 :	effect_type(EffectType_None),
-	sample_access_mutex(), 
 	samples(minimum_frames_in_buffer * ntrb_std_audchannels), 
 	minimum_frames_in_buffer(minimum_frames_in_buffer),
+	callbacks_rendered_ahead(callbacks_rendered_ahead),
+	output_ring(minimum_frames_in_buffer * ntrb_std_audchannels * (callbacks_rendered_ahead + 1)),
+	track_loader(track_id, analysis_cache),
 	track_id(track_id),
 	effect_container()
 {
-}
-
-AudioTrack::~AudioTrack(){
-	if(this->initialised_stdaud_from_file)
-		ntrb_AudioBuffer_free(&(this->stdaud_from_file));
+	for(std::atomic<double>& hot_cue : this->hot_cues) hot_cue = no_hot_cue;
 }
 
 void AudioTrack::load_samples() noexcept{
 	try{
-		std::lock_guard<std::mutex> stdaud_samples_access(this->sample_access_mutex);
-		
-		this->samples.clear();
-
-		const bool not_loading_audio = (not this->initialised_stdaud_from_file) 
-										or (this->play_mode.load() == AudioTrack_no_playback)
-										or (this->stdaud_from_file.load_err == ntrb_AudioBufferLoad_EOF);
-		if(not_loading_audio){
-			this->samples.insert(this->samples.end(), this->minimum_frames_in_buffer * ntrb_std_audchannels, 0.0);
-			if(this->stdaud_from_file.load_err) this->play_mode = AudioTrack_no_playback;
-		}else{
-			const std::uint32_t minimum_samples_in_sample_buffer = this->minimum_frames_in_buffer * ntrb_std_audchannels;
-			bool sample_buffer_loaded = true;
+		//Reported after the block is rendered, as building the messages allocates.
+		bool sample_buffer_loaded = true;
+		bool track_finished = false;
+		ntrb_AudioBufferLoad_Error load_err = ntrb_AudioBufferLoad_OK;
+		{
+			NoAllocationScope no_allocation("AudioTrack::load_samples()");
+			
+			//Swapped in between blocks, so a block is never rendered from two tracks.
+			if(this->track_loader.swap_in_loaded_source(this->source)){
+				this->cue_play_begin_frame = 0;
+				this->loop_queued = false;
+				this->reached_track_end = false;
+				this->current_stdaud_frame = 0.0;
+				this->time_stretcher.reset();
+				this->loop_cache.reset();
+				const HotCues source_hot_cues = get_hot_cues(this->source->get_metadata().cue_points);
+				for(std::uint8_t hot_cue_index = 0; hot_cue_index < hot_cue_count; hot_cue_index++)
+					this->hot_cues[hot_cue_index] = source_hot_cues[hot_cue_index];
+				this->in_slip_action = false;
+				this->shadow_position = 0.0;
+				this->shadow_speed_multiplier = this->speed_multiplier.load();
+				std::lock_guard<std::mutex> scheduled_jump_access(this->scheduled_jump_mutex);
+				this->scheduled_jump.reset();
+			}
+			this->track_loader.swap_in_render_track_info(this->render_track_info);
+			const BeatGrid& beat_grid = *(this->render_track_info.beat_grid);
 			
-			if(this->loop_queued.load())
-				sample_buffer_loaded = this->fill_sample_buffer_while_in_loop(minimum_samples_in_sample_buffer);
-			else if(this->play_mode.load() == AudioTrack_beat_preview)
-				sample_buffer_loaded = this->fill_sample_buffer_while_in_beat_preview(minimum_samples_in_sample_buffer);
-			else 
-				sample_buffer_loaded = this->fill_sample_buffer(minimum_samples_in_sample_buffer);
+			//Copied once, as the sensor thread may schedule another jump during the block.
+			std::optional<ScheduledJump> block_scheduled_jump;
+			{
+				std::lock_guard<std::mutex> scheduled_jump_access(this->scheduled_jump_mutex);
+				if(not plays_through_beats(this->play_mode.load()) or this->reached_track_end.load())
+					this->scheduled_jump.reset();
+				block_scheduled_jump = this->scheduled_jump;
+			}
 			
-			if(not sample_buffer_loaded){
-				this->samples.insert(this->samples.end(), this->minimum_frames_in_buffer * ntrb_std_audchannels, 0.0);
-				const std::string msg = std::string("Error loading samples to deck") + std::to_string(this->track_id) + std::string("(ntrb_AudioBufferLoad_Error ") + std::to_string(this->stdaud_from_file.load_err) + std::string(").");
-				ui::print_to_infobar(msg, UIColorPair_Error);
+			//Once the action slip mode returns from ends, the deck carries on from the shadow playhead, jogs undone as well.
+			//Turning slip off during the action keeps the deck where the action took it.
+			const bool slip_copy = this->slip.load();
+			const bool slip_action = slip_copy and this->source and this->is_slip_action();
+			if(this->in_slip_action and slip_copy and not slip_action){
+				this->current_stdaud_frame = this->shadow_position;
+				this->speed_multiplier = this->shadow_speed_multiplier;
 			}
+			this->in_slip_action = slip_action;
+			//Whether the shadow playhead moves during the block, as the deck plays through its beats rather than an action.
+			const AudioTrack_PlayMode block_begin_play_mode = this->play_mode.load();
+			
+			//Shown by the UI, which cannot read AudioTrack::source while it may be replaced.
+			PcmCache* const pcm_cache = this->source ? this->source->get_pcm_cache() : nullptr;
+			this->pcm_cached_frames = pcm_cache ? pcm_cache->get_decoded_frames() : 0;
+			this->pcm_cache_complete = pcm_cache and pcm_cache->is_complete();
+			
+			const double loop_frame_begin_copy = this->loop_frame_begin.load();
+			const double loop_frame_end_copy = this->loop_frame_end.load();
+			const bool loop_cached = this->source and this->loop_queued.load() 
+										and this->loop_cache.update(loop_frame_begin_copy, loop_frame_end_copy, this->loop_crossfade.load(), *(this->source));
+			this->loop_cache_complete = loop_cached;
 			
-			if(this->stdaud_from_file.load_err == ntrb_AudioBufferLoad_EOF){
-				const std::string msg = std::string("Track ") + std::to_string(this->track_id) + "finished.";
-				ui::print_to_infobar(msg, UIColorPair_Info);
-				this->play_mode = AudioTrack_no_playback;
+			//Published even while paused, so the frames around a cue or beat preview are decoded before the deck jumps there.
+			if(this->source){
+				ReadAheadDecoder::JumpTargets jump_targets;
+				jump_targets.fill(ReadAheadDecoder::no_jump_target);
+				jump_targets[0] = 0;
+				jump_targets[1] = this->cue_play_begin_frame.load();
+				if(this->loop_queued.load()) jump_targets[2] = this->loop_frame_begin.load();
+				if(block_scheduled_jump.has_value() and not beat_grid.empty()){
+					const double landing_beat = block_scheduled_jump->is_beat_jump 
+												? beat_grid.get_beat_position(block_scheduled_jump->trigger_frame) + block_scheduled_jump->beats
+												: block_scheduled_jump->beats;
+					jump_targets[3] = std::max(0.0, beat_grid.get_frame_at_beat_position(landing_beat));
+				}
+				//A cached loop plays from memory, the decoder waits at its end for the loop to be left instead of decoding it again every pass.
+				const double current_frame = this->current_stdaud_frame.load();
+				const bool playing_cached_loop = loop_cached and current_frame >= loop_frame_begin_copy and current_frame < loop_frame_end_copy;
+				this->source->get_read_ahead_decoder().set_playhead(playing_cached_loop ? loop_frame_end_copy : current_frame, jump_targets);
 			}
+			
+			const bool not_loading_audio = (not this->source) 
+											or (this->play_mode.load() == AudioTrack_no_playback)
+											or this->reached_track_end.load();
+			const double phase_speed_offset = this->apply_sync(beat_grid, this->current_stdaud_frame.load(), not not_loading_audio);
+			//A paused deck neither brakes nor spins up.
+			const std::optional<SpeedRamp> speed_ramp = not_loading_audio ? std::nullopt : this->advance_speed_ramp(block_begin_play_mode);
+			if(not_loading_audio){
+				std::fill(this->samples.span().begin(), this->samples.span().end(), 0.0);
+				if(not slip_action){
+					this->shadow_position = this->current_stdaud_frame.load();
+					this->shadow_speed_multiplier = this->speed_multiplier.load();
+				}
+			}else{
+				//The playhead is read from the atomics once, rendered with locally, and published once at the end of the block.
+				const double block_begin_frame = this->current_stdaud_frame.load();
+				const double published_speed_multiplier = this->speed_multiplier.load();
+				//A brake or a spin-up follows its own curve, instead of approaching AudioTrack::destination_speed_multiplier.
+				const double block_begin_speed_multiplier = speed_ramp.has_value() ? speed_ramp->block_begin_speed_multiplier : published_speed_multiplier;
+				const double block_end_speed_multiplier = speed_ramp.has_value() 
+															? speed_ramp->block_end_speed_multiplier 
+															: this->get_block_end_speed_multiplier(block_begin_speed_multiplier);
+				
+				//The phase correction only speeds up or slows down this block, it is not published as the speed of the deck.
+				//It would fight a brake or a spin-up, which are left alone.
+				PlayheadRamp playhead;
+				playhead.position = block_begin_frame;
+				playhead.speed = block_begin_speed_multiplier + (speed_ramp.has_value() ? 0.0 : phase_speed_offset);
+				playhead.speed_step = (block_end_speed_multiplier - block_begin_speed_multiplier) / this->minimum_frames_in_buffer;
+				
+				this->block_interpolation = this->interpolation.load();
+				//Turning key lock on starts the time-stretcher from the playhead, rather than fading from whatever it played last time.
+				const bool key_lock_copy = this->key_lock.load();
+				if(key_lock_copy and not this->block_key_lock)
+					this->time_stretcher.reset();
+				this->block_key_lock = key_lock_copy;
+				
+				std::uint32_t rendered_frames = 0;
+				this->block_reached_track_end = false;
+				while(true){
+					const double jump_frame = block_scheduled_jump.has_value() ? block_scheduled_jump->trigger_frame : std::numeric_limits<double>::infinity();
+					this->block_jump_from.reset();
+					this->block_in_loop = false;
+					if(this->loop_queued.load())
+						sample_buffer_loaded = this->fill_sample_buffer_while_in_loop(playhead, rendered_frames, jump_frame);
+					else if(this->play_mode.load() == AudioTrack_beat_preview)
+						sample_buffer_loaded = this->fill_sample_buffer_while_in_beat_preview(playhead, rendered_frames);
+					else 
+						sample_buffer_loaded = this->fill_sample_buffer(playhead, rendered_frames, jump_frame);
+					if(not sample_buffer_loaded or not this->block_jump_from.has_value()) break;
+					
+					//Made at the exact frame the playhead reached the boundary, the rest of the block is rendered from where it lands.
+					this->apply_scheduled_jump(playhead, beat_grid, block_scheduled_jump.value(), this->block_jump_from.value());
+					std::lock_guard<std::mutex> scheduled_jump_access(this->scheduled_jump_mutex);
+					if(this->scheduled_jump.has_value() and this->scheduled_jump->id == block_scheduled_jump->id)
+						this->scheduled_jump.reset();
+					block_scheduled_jump.reset();
+				}
+				if(not sample_buffer_loaded) load_err = this->source->get_read_ahead_decoder().get_load_error();
+				
+				//Anything not rendered, from reaching EOF, the end of a beat preview, frames not decoded yet or a load error, is silent.
+				std::fill(this->samples.span().begin() + (rendered_frames * ntrb_std_audchannels), this->samples.span().end(), 0.0);
+				this->publish_playhead(block_begin_frame, playhead.position, published_speed_multiplier, block_end_speed_multiplier);
+				//Following the playhead as rendered, so an action starting before the next block leaves the shadow where the deck was.
+				if(not slip_action){
+					this->shadow_position = playhead.position;
+					this->shadow_speed_multiplier = block_end_speed_multiplier;
+				}
+				
+				if(speed_ramp.has_value() and speed_ramp->finished){
+					//A halted deck plays at its tempo again once played, unless it spins up.
+					//Played again during the block, the deck spins up instead of halting.
+					AudioTrack_PlayMode expected_play_mode = AudioTrack_slowdown_to_halt;
+					if(block_begin_play_mode != AudioTrack_slowdown_to_halt)
+						this->spinning_up = false;
+					else if(this->play_mode.compare_exchange_strong(expected_play_mode, AudioTrack_no_playback))
+						this->speed_multiplier = this->destination_speed_multiplier.load();
+				}
+				if(not sample_buffer_loaded)
+					this->play_mode = AudioTrack_no_playback;
+				if(this->block_reached_track_end){
+					track_finished = true;
+					this->reached_track_end = true;
+					this->play_mode = AudioTrack_no_playback;
+				}
+			}
+			if(slip_action and not this->reached_track_end.load())
+				this->advance_shadow_playhead(block_begin_play_mode, speed_ramp);
+			this->slipping = slip_action;
+			this->shadow_frame = this->shadow_position;
+			
+			this->effect_container.apply_effect(this->samples.span(), this->effect_type);
+			
+			this->output_ring.write(this->samples.data(), this->samples.size());
+			this->rendered_output_frames += this->minimum_frames_in_buffer;
+			
+			const bool playing_next_block = this->source and (this->play_mode.load() != AudioTrack_no_playback) and not this->reached_track_end.load();
+			this->publish_beat_clock(beat_grid, playing_next_block);
+		}
+		
+		if(not sample_buffer_loaded){
+			const std::string msg = std::string("Error loading samples to deck") + std::to_string(this->track_id) + std::string("(ntrb_AudioBufferLoad_Error ") + std::to_string(load_err) + std::string(").");
+			ui::print_to_infobar(msg, UIColorPair_Error);
+		}
+		if(track_finished){
+			const std::string msg = std::string("Track ") + std::to_string(this->track_id) + "finished.";
+			ui::print_to_infobar(msg, UIColorPair_Info);
 		}
-		this->effect_container.apply_effect(this->samples, this->effect_type);		
 	}
 	catch(const std::system_error& e){
 		const std::string msg = std::string("AudioTrack::load_samples(): ") + std::to_string(this->track_id) + std::string(" mutex error.");
 		ui::print_to_infobar(msg, UIColorPair_Error);
-		return;
 	}
 	catch(const std::exception& e){
 		const std::string msg = std::string("AudioTrack::load_samples(): ") + std::to_string(this->track_id) + e.what();
 		ui::print_to_infobar(msg, UIColorPair_Error);
-		return;
 	}
 	catch(...){
 		const std::string msg = std::string("AudioTrack::load_samples(): ") + std::to_string(this->track_id) + std::string(" uncaught throw.");
 		ui::print_to_infobar(msg, UIColorPair_Error);
-		return;
-	}
-}
-
-
-ntrb_AudioBufferNew_Error AudioTrack::set_file_to_load_from(const char* const filename, const std::uint32_t frames_per_callback) noexcept{
-	try{
-		std::lock_guard<std::mutex> _(this->sample_access_mutex);
-		
-		if(this->initialised_stdaud_from_file)
-			ntrb_AudioBuffer_free(&(this->stdaud_from_file));
-		
-		const ntrb_AudioBufferNew_Error new_file_aud_err = ntrb_AudioBuffer_new(&(this->stdaud_from_file), filename, frames_per_callback);
-		if(new_file_aud_err) return new_file_aud_err;
-
-		this->initialised_stdaud_from_file = true;
-		this->audfile_name = filename;
-		this->loop_queued = false;
-		this->current_stdaud_frame = 0.0;
-		return new_file_aud_err;
-	}
-	catch(const std::system_error& e){
-		return ntrb_AudioBufferNew_RwlockInitError;
 	}
 }
 
 
-void AudioTrack::load_audio_info(const std::string& aud_filename){
-	this->bpm = 0.0;
-	this->first_beat_stdaud_frame = 0;
-	
-	std::string aud_info_filename;
-	const std::size_t filetype_separator_index = aud_filename.rfind('.');
-	if(filetype_separator_index == std::string::npos)
-		aud_info_filename =  aud_filename + ".txt";
-	else{
-		const std::string before_separator = aud_filename.substr(0, filetype_separator_index);
-		aud_info_filename = before_separator + ".txt";
-	}
-	
-	std::ifstream metadata_file(aud_info_filename);
-	if(!metadata_file){
-		ui::print_to_infobar("Audio info file not found. Functionalities limited.", UIColorPair_Warning);
-		return;
-	}
-	
-	std::string keyword, value;
-	while(metadata_file >> keyword >> value){
-		try{
-			if(keyword == "bpm") this->bpm = std::stof(value);
-			else if(keyword == "first_beat"){
-				float seconds = 0.0;
-				const std::string::size_type minute_second_separator = value.find(':');
-				const std::string::size_type second_millisecond_separator = value.find('.');
-				
-				const bool has_minute_second_separator = minute_second_separator != std::string::npos;
-				const bool has_second_millisecond_separator = second_millisecond_separator != std::string::npos;
-
-				if(has_minute_second_separator){
-					const std::uint8_t minutes = std::stoi(value.substr(0, minute_second_separator));
-					seconds += (float)minutes * 60.0;
-					
-					if(has_second_millisecond_separator)
-						seconds += std::stoi(value.substr(minute_second_separator, second_millisecond_separator));
-					else
-						seconds += std::stoi(value.substr(minute_second_separator));					
-				}else{
-					if(has_second_millisecond_separator)
-						seconds += std::stoi(value.substr(0, second_millisecond_separator));
-					else
-						seconds += std::stoi(value);						
-				}
-				if(has_second_millisecond_separator){
-					const std::uint16_t milliseconds = std::stoi(value.substr(second_millisecond_separator+1));
-					seconds += (float)milliseconds / 1000.0;
-				}
-
-				this->first_beat_stdaud_frame = seconds * ntrb_std_samplerate;
-			}
-		}
-		catch(const std::invalid_argument& stox_not_a_number){
-			const std::string msg = "Audio info file: data for " + keyword + " is not a number.";
-			ui::print_to_infobar(msg, UIColorPair_Warning);
-		}
-		catch(const std::out_of_range& stox_out_of_range){
-			const std::string msg = "Audio info file: data for " + keyword + " not in range.";
-			ui::print_to_infobar(msg, UIColorPair_Warning);
-		}
-	}
+void AudioTrack::set_file_to_load_from(const std::string& filename, const PcmCacheMode pcm_cache_mode){
+	this->track_loader.request_load(filename, pcm_cache_mode);
 }
 
 bool AudioTrack::toggle_play_pause() noexcept{
-	if(this->initialised_stdaud_from_file){
-		const int stdaud_rwlock_acq_err = pthread_rwlock_rdlock(&(this->stdaud_from_file.buffer_access));
-		if(stdaud_rwlock_acq_err) return false;
-	}
-	
 	const bool user_requests_replay = (this->play_mode.load() == AudioTrack_no_playback) 
-										and (this->stdaud_from_file.load_err == ntrb_AudioBufferLoad_EOF);
+										and this->reached_track_end.load();
 	if(user_requests_replay){
 		this->current_stdaud_frame = 0;
-		this->stdaud_from_file.load_err = ntrb_AudioBufferLoad_OK;
+		this->reached_track_end = false;
 	}
 	
-	if(this->initialised_stdaud_from_file)
-		pthread_rwlock_unlock(&(this->stdaud_from_file.buffer_access));
-	
 	if (this->play_mode.load() != AudioTrack_regular_play)
-		this->play_mode = AudioTrack_regular_play;
+		this->spin_up();
 	else
-		this->play_mode = AudioTrack_no_playback;
+		this->brake();
 	return true;
 }
 
+void AudioTrack::brake() noexcept{
+	if(this->play_mode.load() != AudioTrack_regular_play) return;
+	
+	this->spinning_up = false;
+	if(this->brake_seconds.load() <= 0.0){
+		this->play_mode = AudioTrack_no_playback;
+		return;
+	}
+	this->speed_ramp_restart = true;
+	this->play_mode = AudioTrack_slowdown_to_halt;
+}
+
+void AudioTrack::spin_up() noexcept{
+	const AudioTrack_PlayMode play_mode_copy = this->play_mode.load();
+	if(play_mode_copy == AudioTrack_regular_play) return;
+	
+	if(this->spin_up_seconds.load() <= 0.0){
+		//Caught part way through a brake, the deck plays at its tempo straight away.
+		if(play_mode_copy == AudioTrack_slowdown_to_halt) this->speed_multiplier = this->destination_speed_multiplier.load();
+		this->spinning_up = false;
+	}else{
+		if(play_mode_copy != AudioTrack_slowdown_to_halt) this->speed_multiplier = 0.0;
+		this->spinning_up = true;
+		this->speed_ramp_restart = true;
+	}
+	this->play_mode = AudioTrack_regular_play;
+}
+
 AudioTrack_PlayMode AudioTrack::get_play_mode() const noexcept{
 	return this->play_mode.load();
 }
 
 bool AudioTrack::initiate_cue_play() noexcept{
-	const std::optional<std::uint32_t> earlier_cue_point = this->find_eariler_cue_point();
+	const std::shared_ptr<const BeatGrid> beat_grid = this->get_beat_grid();
+	const std::optional<double> earlier_cue_point = this->find_eariler_cue_point(*beat_grid);
 	if(not earlier_cue_point.has_value()) return false;
 	
-	const std::uint32_t current_beat = earlier_cue_point.value() + this->get_frames_per_beat(this->bpm.load());
+	const double current_beat = beat_grid->get_beat_after(earlier_cue_point.value()).value();
 	this->cue_play_begin_frame = current_beat;
 	this->current_stdaud_frame = current_beat;
 	this->play_mode = AudioTrack_cue_play;
@@ -222,14 +314,15 @@ bool AudioTrack::play_only_next_beat() noexcept{
 	const AudioTrack_PlayMode current_play_mode = this->play_mode.load();
 	
 	if((current_play_mode == AudioTrack_no_playback) or (current_play_mode == AudioTrack_cue_play)){
-		const float frames_per_beat = this->get_frames_per_beat(this->bpm.load());
-		
-		const std::optional<std::uint32_t> earlier_cue_point = this->find_eariler_cue_point();
+		const std::shared_ptr<const BeatGrid> beat_grid = this->get_beat_grid();
+		const std::optional<double> earlier_cue_point = this->find_eariler_cue_point(*beat_grid);
 		if(not earlier_cue_point.has_value()) return false;
 		
-		const std::uint32_t next_beat_at_frame = earlier_cue_point.value() + (frames_per_beat*2);
+		const double earlier_cue_point_beat = beat_grid->get_beat_position(earlier_cue_point.value());
+		const double next_beat_at_frame = beat_grid->get_frame_at_beat_position(earlier_cue_point_beat + 2);
+		this->beat_preview_begin_frame = next_beat_at_frame;
+		this->end_beat_preview_at_frame = beat_grid->get_frame_at_beat_position(earlier_cue_point_beat + 3);
 		this->current_stdaud_frame = next_beat_at_frame;
-		this->end_beat_preview_at_frame = next_beat_at_frame + frames_per_beat;
 		this->play_mode = AudioTrack_beat_preview;
 	}
 	
@@ -240,14 +333,14 @@ bool AudioTrack::play_only_prev_beat() noexcept{
 	const AudioTrack_PlayMode current_play_mode = this->play_mode.load();
 	
 	if((current_play_mode == AudioTrack_no_playback) or (current_play_mode == AudioTrack_cue_play)){
-		const std::optional<std::uint32_t> earlier_cue_point = this->find_eariler_cue_point();
+		const std::shared_ptr<const BeatGrid> beat_grid = this->get_beat_grid();
+		const std::optional<double> earlier_cue_point = this->find_eariler_cue_point(*beat_grid);
 		if(not earlier_cue_point.has_value()) return false;
 		
-		const std::uint32_t previous_beat_frame = earlier_cue_point.value();
-		const float frames_per_beat = this->get_frames_per_beat(this->bpm.load());
-		
+		const double previous_beat_frame = earlier_cue_point.value();
+		this->beat_preview_begin_frame = previous_beat_frame;
+		this->end_beat_preview_at_frame = beat_grid->get_beat_after(previous_beat_frame).value();
 		this->current_stdaud_frame = previous_beat_frame;
-		this->end_beat_preview_at_frame = previous_beat_frame + frames_per_beat;
 		this->play_mode = AudioTrack_beat_preview;
 	}
 	return true;
@@ -266,33 +359,28 @@ void AudioTrack::set_destination_speed_multiplier(const float dest_speed_multipl
 }
 
 bool AudioTrack::set_loop(){
-	if(this->bpm.load() == 0.0) return false;
-	
-	const std::optional<std::uint32_t> nearest_loop_cue_point = this->find_nearest_loop_cue_point();
+	const std::shared_ptr<const BeatGrid> beat_grid = this->get_beat_grid();
+	//A quantized loop begins at the next boundary, the playhead plays up to it before the loop first wraps.
+	const std::optional<double> quantized_frame = this->get_quantized_frame(*beat_grid, this->current_stdaud_frame.load());
+	const std::optional<double> nearest_loop_cue_point = quantized_frame.has_value() ? quantized_frame : this->find_nearest_loop_cue_point(*beat_grid);
 	if(!nearest_loop_cue_point.has_value())
 		return false;
 	
 	this->loop_frame_begin = nearest_loop_cue_point.value();
-	
-	const float frames_per_loop = get_frames_per_beat(this->bpm.load()) * this->beats_per_loop.load();
-	this->loop_frame_end = this->loop_frame_begin + frames_per_loop;
+	this->update_loop_frame_end(*beat_grid);
 	this->loop_queued = true;
 	return true;
 }
 
 float AudioTrack::increment_loop_step() noexcept{
 	this->beats_per_loop = this->beats_per_loop.load() * 2;
-
-	const float frames_per_loop = get_frames_per_beat(this->bpm.load()) * this->beats_per_loop.load();
-	this->loop_frame_end = this->loop_frame_begin + frames_per_loop;
+	this->update_loop_frame_end(*(this->get_beat_grid()));
 	return this->beats_per_loop.load();
 }
 
 float AudioTrack::decrement_loop_step() noexcept{
 	this->beats_per_loop = this->beats_per_loop.load() / 2;
-	
-	const float frames_per_loop = get_frames_per_beat(this->bpm.load()) * this->beats_per_loop.load();
-	this->loop_frame_end = this->loop_frame_begin + frames_per_loop;
+	this->update_loop_frame_end(*(this->get_beat_grid()));
 	return this->beats_per_loop.load();
 }
 
@@ -301,192 +389,368 @@ void AudioTrack::cancel_loop(){
 }
 
 bool AudioTrack::cue_to_nearest_cue_point() noexcept{
-	const std::optional<std::uint32_t> cue_point_frames = this->find_eariler_cue_point();
+	const std::shared_ptr<const BeatGrid> beat_grid = this->get_beat_grid();
+	const std::optional<double> cue_point_frames = this->find_eariler_cue_point(*beat_grid);
 	if(not cue_point_frames.has_value())
 		return false;
 	
+	const std::optional<double> quantized_frame = this->get_quantized_frame(*beat_grid, this->current_stdaud_frame.load());
+	if(quantized_frame.has_value()){
+		this->schedule_cue_jump(*beat_grid, quantized_frame.value(), cue_point_frames.value());
+		return true;
+	}
+	
 	this->current_stdaud_frame = cue_point_frames.value();
 	return true;
 }
 
-//private methods
-bool AudioTrack::load_single_frame(){
-	const float current_frame = this->current_stdaud_frame.load();
-	const std::uint32_t current_frame_floored = std::floor(current_frame);
-	const std::uint32_t current_frame_ceiled = std::ceil(current_frame);
-
-	const std::uint32_t file_stdaud_buffer_end_frame = this->stdaud_from_file.stdaud_buffer_first_frame + this->stdaud_from_file.monochannel_samples;
-	const bool frame_outside_file_stdaud = current_frame_ceiled >= file_stdaud_buffer_end_frame;
-	if(frame_outside_file_stdaud) return false;
-	
-	const std::uint32_t last_sample_index_in_file_stdaud = (this->stdaud_from_file.monochannel_samples * ntrb_std_audchannels) - 1;
-	const std::uint32_t last_left_channel_index_in_file_stdaud = last_sample_index_in_file_stdaud - 1;
-	const std::uint32_t last_right_channel_index_in_file_stdaud = last_sample_index_in_file_stdaud;
+bool AudioTrack::beat_jump(const double beats) noexcept{
+	const std::shared_ptr<const BeatGrid> beat_grid = this->get_beat_grid();
+	if(beat_grid->empty()) return false;
 	
-	/*
-	Substracting the current frame by the first frame which the file audio buffer is at,
-	yields the index to access the current frame in the file audio buffer.
-	*/
-	const std::uint32_t file_frame_index_floored = current_frame_floored - this->stdaud_from_file.stdaud_buffer_first_frame;
-	const std::uint32_t file_frame_index_ceiled = current_frame_ceiled - this->stdaud_from_file.stdaud_buffer_first_frame;
+	const double current_frame = this->current_stdaud_frame.load();
+	const std::optional<double> quantized_frame = this->get_quantized_frame(*beat_grid, current_frame);
+	if(quantized_frame.has_value()){
+		this->schedule_jump({0, quantized_frame.value(), beats, true});
+		return true;
+	}
 	
-	const std::uint32_t floored_file_sample_index = file_frame_index_floored * ntrb_std_audchannels;
-	const std::uint32_t ceiled_file_sample_index = file_frame_index_ceiled * ntrb_std_audchannels;
+	this->current_stdaud_frame = std::max(0.0, beat_grid->get_frame_at_beat_position(beat_grid->get_beat_position(current_frame) + beats));
+	if(this->loop_queued.load()) this->move_loop(*beat_grid, beats);
+	return true;
+}
 
-	const std::uint32_t floored_left_channel_index = ntrb_clamp_u64(floored_file_sample_index, 0, last_left_channel_index_in_file_stdaud);
-	const std::uint32_t ceiled_left_channel_index = ntrb_clamp_u64(ceiled_file_sample_index, 0, last_left_channel_index_in_file_stdaud);
-	
-	const std::uint32_t floored_right_channel_index = ntrb_clamp_u64(floored_file_sample_index + 1, 0, last_right_channel_index_in_file_stdaud);
-	const std::uint32_t ceiled_right_channel_index = ntrb_clamp_u64(ceiled_file_sample_index + 1, 0, last_right_channel_index_in_file_stdaud);
-	
-	const float left_channel_value = this->stdaud_from_file.datapoints[floored_left_channel_index] 
-									+ ((current_frame - current_frame_floored) * (this->stdaud_from_file.datapoints[ceiled_left_channel_index] - this->stdaud_from_file.datapoints[floored_left_channel_index]));
-	
-	const float right_channel_value = this->stdaud_from_file.datapoints[floored_right_channel_index] 
-									+ ((current_frame - current_frame_floored) * (this->stdaud_from_file.datapoints[ceiled_right_channel_index] - this->stdaud_from_file.datapoints[floored_right_channel_index]));
+bool AudioTrack::press_hot_cue(const std::uint8_t hot_cue_index) noexcept{
+	if(hot_cue_index >= hot_cue_count) return false;
+	
+	const std::shared_ptr<const BeatGrid> beat_grid = this->get_beat_grid();
+	const double current_frame = this->current_stdaud_frame.load();
+	const double hot_cue = this->hot_cues[hot_cue_index].load();
+	if(hot_cue == no_hot_cue){
+		//Snapped to whichever quantize boundary is nearer, paused or not.
+		const QuantizeMode quantize_copy = this->quantize.load();
+		double hot_cue_frame = current_frame;
+		if(quantize_copy != QuantizeMode_Off and not beat_grid->empty()){
+			const double beats_per_boundary = 1.0 / double(1 << (quantize_copy - QuantizeMode_Beat));
+			const double boundary_beat = std::round(beat_grid->get_beat_position(current_frame) / beats_per_boundary) * beats_per_boundary;
+			hot_cue_frame = std::max(0.0, beat_grid->get_frame_at_beat_position(boundary_beat));
+		}
+		this->hot_cues[hot_cue_index] = hot_cue_frame;
+		this->store_hot_cues();
+		return true;
+	}
 	
-	this->samples.push_back(left_channel_value);
-	this->samples.push_back(right_channel_value);	
-	this->current_stdaud_frame = current_frame + this->speed_multiplier.load();
+	const std::optional<double> quantized_frame = this->get_quantized_frame(*beat_grid, current_frame);
+	if(quantized_frame.has_value()){
+		this->schedule_cue_jump(*beat_grid, quantized_frame.value(), hot_cue);
+		return true;
+	}
 	
-	this->adjust_speed_multiplier();
+	this->current_stdaud_frame = hot_cue;
+	this->reached_track_end = false;
 	return true;
 }
 
-bool AudioTrack::fill_sample_buffer_while_in_loop(const std::uint32_t minimum_samples_in_sample_buffer){
-	const std::uint32_t loop_frame_end_copy = this->loop_frame_end.load();
-	if(this->current_stdaud_frame.load() >= loop_frame_end_copy){
-		this->stdaud_from_file.stdaud_next_buffer_first_frame = this->loop_frame_begin;
-		this->current_stdaud_frame = this->loop_frame_begin;
-	}else
-		this->stdaud_from_file.stdaud_next_buffer_first_frame = this->current_stdaud_frame.load();
+bool AudioTrack::delete_hot_cue(const std::uint8_t hot_cue_index) noexcept{
+	if(hot_cue_index >= hot_cue_count) return false;
 	
-	while(this->samples.size() < minimum_samples_in_sample_buffer){
-		this->stdaud_from_file.load_buffer_callback(&(this->stdaud_from_file));	
-		const ntrb_AudioBufferLoad_Error load_err = this->stdaud_from_file.load_err;
-		
-		if(load_err != ntrb_AudioBufferLoad_OK && load_err != ntrb_AudioBufferLoad_EOF)
-			return false;
-		if(load_err == ntrb_AudioBufferLoad_EOF) 
-			//ntrb will 0 fill its stdaud buffer if an eof has reached.
-			break;	
-				
-		while(this->samples.size() < minimum_samples_in_sample_buffer){
-			const bool has_next_frame_in_file_aud_buffer = this->load_single_frame();
-			if(!has_next_frame_in_file_aud_buffer || this->current_stdaud_frame.load() >= loop_frame_end_copy) 
-				break;
-		}
-	}
+	this->hot_cues[hot_cue_index] = no_hot_cue;
+	this->store_hot_cues();
 	return true;
 }
 
-bool AudioTrack::fill_sample_buffer(const std::uint32_t minimum_samples_in_sample_buffer){
-	while(this->samples.size() < minimum_samples_in_sample_buffer){
-		this->stdaud_from_file.stdaud_next_buffer_first_frame = this->current_stdaud_frame.load();
+//private methods
+AudioTrack_RenderStatus AudioTrack::render_frames(PlayheadRamp& playhead, std::uint32_t& rendered_frames, const double end_position){
+	//Whether the source was fetched for the frame at the playhead, rather than kept from rendering the frames before it.
+	bool fresh_source = true;
+	
+	while(rendered_frames < this->minimum_frames_in_buffer){
+		if(playhead.position >= end_position)
+			return AudioTrack_RenderReachedEnd;
 		
-		this->stdaud_from_file.load_buffer_callback(&(this->stdaud_from_file));
-		const ntrb_AudioBufferLoad_Error load_err = this->stdaud_from_file.load_err;
+		//The source begins early enough to hold every frame the interpolation or the next time-stretched segment reads.
+		const std::uint64_t playhead_frame = playhead.position;
+		const std::uint32_t frames_before = interpolation_frames_before(this->block_interpolation);
+		const std::uint64_t source_first_frame = this->block_key_lock 
+													? std::max<std::int64_t>(0, this->time_stretcher.next_segment_first_frame(playhead))
+													: (playhead_frame > frames_before ? playhead_frame - frames_before : 0);
+		const std::uint64_t source_minimum_frames = this->block_key_lock 
+													? TimeStretcher::source_frames_per_segment
+													: frames_before + 1 + interpolation_frames_after(this->block_interpolation);
+		
+		SourceSpan source;
+		PcmCache* const pcm_cache = this->source->get_pcm_cache();
+		ReadAheadDecoder& read_ahead_decoder = this->source->get_read_ahead_decoder();
+		const HotCueSnippets* const hot_cue_snippets = this->render_track_info.hot_cue_snippets.get();
+		const bool source_from_cache = this->loop_cache.get_span(source_first_frame, source_minimum_frames, this->block_in_loop, source)
+										or (pcm_cache and pcm_cache->get_span(source_first_frame, source_minimum_frames, source))
+										or (hot_cue_snippets and hot_cue_snippets->get_span(source_first_frame, source_minimum_frames, source));
+		if(not source_from_cache and not read_ahead_decoder.get_span(source_first_frame, source)){
+			if(read_ahead_decoder.has_failed()) return AudioTrack_RenderLoadError;
+			//The decoder is catching up with a jump, the rest of the block is silent rather than waiting for it.
+			return AudioTrack_RenderSourceNotReady;
+		}
 		
-		if(load_err != ntrb_AudioBufferLoad_OK && load_err != ntrb_AudioBufferLoad_EOF)
-			return false;
-		if(load_err == ntrb_AudioBufferLoad_EOF) 
-			//ntrb will 0 fill its stdaud buffer if an eof has reached.
-			break;
+		const std::uint32_t frames_to_render = this->minimum_frames_in_buffer - rendered_frames;
+		float* const output = this->samples.data() + (rendered_frames * ntrb_std_audchannels);
+		const std::uint32_t frames_rendered_from_source = this->block_key_lock 
+															? this->time_stretcher.render(source, playhead, output, frames_to_render, end_position)
+															: resample_block(source, playhead, output, frames_to_render, end_position, this->block_interpolation);
+		rendered_frames += frames_rendered_from_source;
 		
-		while(this->samples.size() < minimum_samples_in_sample_buffer){
-			const bool has_next_frame_in_file_aud_buffer = this->load_single_frame();
-			if(!has_next_frame_in_file_aud_buffer) break;
-		}		
+		//A source fetched for the playhead which cannot render a single frame is past the end of the track.
+		if(frames_rendered_from_source == 0 and fresh_source and playhead.position < end_position){
+			this->block_reached_track_end = true;
+			return AudioTrack_RenderReachedEOF;
+		}
+		fresh_source = frames_rendered_from_source == 0;
 	}
-	return true;
+	return AudioTrack_RenderDone;
 }
 
-bool AudioTrack::fill_sample_buffer_while_in_beat_preview(const std::uint32_t minimum_samples_in_sample_buffer){
-	while(this->samples.size() < minimum_samples_in_sample_buffer){
-		this->stdaud_from_file.stdaud_next_buffer_first_frame = this->current_stdaud_frame.load();
-		this->stdaud_from_file.load_buffer_callback(&(this->stdaud_from_file));	
-		const ntrb_AudioBufferLoad_Error load_err = this->stdaud_from_file.load_err;
-		
-		if(load_err != ntrb_AudioBufferLoad_OK && load_err != ntrb_AudioBufferLoad_EOF)
-			return false;
-		if(load_err == ntrb_AudioBufferLoad_EOF) 
-			//ntrb will 0 fill its stdaud buffer if an eof has reached.
-			break;
-		
-		while(this->samples.size() < minimum_samples_in_sample_buffer){
-			const bool has_next_frame_in_file_aud_buffer = this->load_single_frame();
-			if(!has_next_frame_in_file_aud_buffer) break;
-			if(this->current_stdaud_frame >= this->end_beat_preview_at_frame){
-				const std::uint32_t remaining_frames_for_zero_fill = minimum_samples_in_sample_buffer - this->samples.size();
-				this->samples.insert(this->samples.end(), remaining_frames_for_zero_fill, 0.0);
-				
-				this->current_stdaud_frame = this->end_beat_preview_at_frame - this->get_frames_per_beat(this->bpm.load());
-				this->play_mode = AudioTrack_no_playback;
+bool AudioTrack::fill_sample_buffer_while_in_loop(PlayheadRamp& playhead, std::uint32_t& rendered_frames, const double jump_frame){
+	const double loop_frame_begin_copy = this->loop_frame_begin.load();
+	const double loop_frame_end_copy = this->loop_frame_end.load();
+	const double loop_frames = loop_frame_end_copy - loop_frame_begin_copy;
+	if(loop_frames <= 0.0)
+		return this->fill_sample_buffer(playhead, rendered_frames, jump_frame);
+	this->block_in_loop = true;
+	
+	while(rendered_frames < this->minimum_frames_in_buffer){
+		//Wrapping keeps the fraction of a frame the playhead overshot the loop end by, so the loop stays sample accurate.
+		if(playhead.position >= loop_frame_end_copy){
+			playhead.position = loop_frame_begin_copy + (playhead.position - loop_frame_end_copy);
+			if(playhead.position >= loop_frame_end_copy)
+				playhead.position = loop_frame_begin_copy;
+			if(jump_frame >= loop_frame_end_copy){
+				this->block_jump_from = loop_frame_begin_copy;
 				return true;
 			}
 		}
+		
+		const AudioTrack_RenderStatus render_status = this->render_frames(playhead, rendered_frames, std::min(loop_frame_end_copy, jump_frame));
+		if(render_status == AudioTrack_RenderReachedEnd and jump_frame < loop_frame_end_copy){
+			this->block_jump_from = jump_frame;
+			return true;
+		}
+		if(render_status == AudioTrack_RenderLoadError) return false;
+		if(render_status == AudioTrack_RenderReachedEOF or render_status == AudioTrack_RenderSourceNotReady) break;
 	}
 	return true;
 }
 
-std::optional<std::uint32_t> AudioTrack::find_nearest_loop_cue_point() noexcept{
-	const int stdaud_rwlock_acq_err = pthread_rwlock_rdlock(&(this->stdaud_from_file.buffer_access));
-	if(stdaud_rwlock_acq_err) return std::nullopt;
-	
-	const std::uint32_t frames_per_beat = this->get_frames_per_beat(this->bpm.load());
-	const std::uint32_t current_frame = this->current_stdaud_frame.load();
+bool AudioTrack::fill_sample_buffer(PlayheadRamp& playhead, std::uint32_t& rendered_frames, const double jump_frame){
+	const AudioTrack_RenderStatus render_status = this->render_frames(playhead, rendered_frames, jump_frame);
+	if(render_status == AudioTrack_RenderReachedEnd) this->block_jump_from = jump_frame;
+	return render_status != AudioTrack_RenderLoadError;
+}
 
-	std::uint32_t later_nearest_beat_in_frames = this->first_beat_stdaud_frame.load();
-	//keep adding the frame for the next beat until exceeding current frame
-	while(later_nearest_beat_in_frames <= current_frame)
-		later_nearest_beat_in_frames += frames_per_beat;
-	
-	const std::int32_t earlier_nearest_beat_in_frames_unclamped = later_nearest_beat_in_frames - frames_per_beat;
-	//Clamp using signed integer because the substraction may result in a negative number, then clamp to a positive number.
-	const std::uint32_t earlier_nearest_beat_in_frames = ntrb_clamp_i64(earlier_nearest_beat_in_frames_unclamped, this->first_beat_stdaud_frame, INT32_MAX);
+bool AudioTrack::fill_sample_buffer_while_in_beat_preview(PlayheadRamp& playhead, std::uint32_t& rendered_frames){
+	const double end_beat_preview_at_frame_copy = this->end_beat_preview_at_frame.load();
+	const AudioTrack_RenderStatus render_status = this->render_frames(playhead, rendered_frames, end_beat_preview_at_frame_copy);
 	
-	const std::uint32_t delta_frames_earlier_nearest_beat = current_frame - earlier_nearest_beat_in_frames;
-	const std::uint32_t delta_frames_later_nearest_beat = later_nearest_beat_in_frames - current_frame;
+	if(render_status == AudioTrack_RenderReachedEnd){
+		playhead.position = this->beat_preview_begin_frame.load();
+		this->play_mode = AudioTrack_no_playback;
+	}
+	return render_status != AudioTrack_RenderLoadError;
+}
+
+std::optional<double> AudioTrack::find_nearest_loop_cue_point(const BeatGrid& beat_grid) const noexcept{
+	const std::optional<double> nearest_beat = beat_grid.get_nearest_beat(this->current_stdaud_frame.load());
+	if(not nearest_beat.has_value()) return std::nullopt;
+	//Not earlier than the first beat, as the grid extends before it.
+	return std::max(nearest_beat.value(), beat_grid.get_frame_at_beat_position(0));
+}
+
+std::optional<double> AudioTrack::find_eariler_cue_point(const BeatGrid& beat_grid) const noexcept{
+	const std::optional<double> earlier_beat = beat_grid.get_beat_before(this->current_stdaud_frame.load());
+	if(not earlier_beat.has_value()) return std::nullopt;
+	return std::max(earlier_beat.value(), beat_grid.get_frame_at_beat_position(0));
+}
+
+void AudioTrack::update_loop_frame_end(const BeatGrid& beat_grid) noexcept{
+	if(beat_grid.empty()) return;
+	const double loop_begin_beat = beat_grid.get_beat_position(this->loop_frame_begin.load());
+	this->loop_frame_end = beat_grid.get_frame_at_beat_position(loop_begin_beat + this->beats_per_loop.load());
+}
+
+void AudioTrack::move_loop(const BeatGrid& beat_grid, const double beats) noexcept{
+	if(beat_grid.empty()) return;
+	const double loop_begin_beat = beat_grid.get_beat_position(this->loop_frame_begin.load());
+	this->loop_frame_begin = std::max(0.0, beat_grid.get_frame_at_beat_position(loop_begin_beat + beats));
+	this->update_loop_frame_end(beat_grid);
+}
+
+void AudioTrack::store_hot_cues() noexcept{
+	HotCues hot_cues_copy;
+	for(std::uint8_t hot_cue_index = 0; hot_cue_index < hot_cue_count; hot_cue_index++)
+		hot_cues_copy[hot_cue_index] = this->hot_cues[hot_cue_index].load();
 	
-	pthread_rwlock_unlock(&(this->stdaud_from_file.buffer_access));
+	try{
+		this->track_loader.request_hot_cue_store(this->get_filename(), hot_cues_copy);
+	}
+	catch(const std::exception& e){
+		ui::print_to_infobar(std::string("AudioTrack::store_hot_cues(): ") + e.what(), UIColorPair_Error);
+	}
+}
+
+std::optional<double> AudioTrack::get_quantized_frame(const BeatGrid& beat_grid, const double frame) const noexcept{
+	const QuantizeMode quantize_copy = this->quantize.load();
+	if(quantize_copy == QuantizeMode_Off or beat_grid.empty() or not plays_through_beats(this->play_mode.load()))
+		return std::nullopt;
 	
-	if(delta_frames_earlier_nearest_beat <= delta_frames_later_nearest_beat)
-		return earlier_nearest_beat_in_frames;
-	else
-		return later_nearest_beat_in_frames;
+	//1, 1/2 or 1/4 beats.
+	const double beats_per_boundary = 1.0 / double(1 << (quantize_copy - QuantizeMode_Beat));
+	//A frame a rounding error past a boundary is on it, rather than waiting for the next one.
+	const double boundary_beat = std::ceil((beat_grid.get_beat_position(frame) / beats_per_boundary) - beat_position_epsilon) * beats_per_boundary;
+	return beat_grid.get_frame_at_beat_position(boundary_beat);
 }
 
-std::optional<std::uint32_t> AudioTrack::find_eariler_cue_point() noexcept{
-	const int stdaud_rwlock_acq_err = pthread_rwlock_rdlock(&(this->stdaud_from_file.buffer_access));
-	if(stdaud_rwlock_acq_err) return std::nullopt;
+void AudioTrack::schedule_jump(ScheduledJump jump) noexcept{
+	std::lock_guard<std::mutex> scheduled_jump_access(this->scheduled_jump_mutex);
+	const bool adds_to_scheduled_jump = jump.is_beat_jump and this->scheduled_jump.has_value() 
+										and this->scheduled_jump->is_beat_jump and (this->scheduled_jump->trigger_frame == jump.trigger_frame);
+	if(adds_to_scheduled_jump) jump.beats += this->scheduled_jump->beats;
+	jump.id = this->next_scheduled_jump_id++;
+	this->scheduled_jump = jump;
+}
+
+void AudioTrack::schedule_cue_jump(const BeatGrid& beat_grid, const double boundary_frame, const double cue_frame) noexcept{
+	//A cue point on a beat is landed on at the fraction of a beat the boundary is at, which keeps the deck in phase.
+	const double boundary_beat = beat_grid.get_beat_position(boundary_frame);
+	const double beat_fraction = boundary_beat - std::floor(boundary_beat + beat_position_epsilon);
+	this->schedule_jump({0, boundary_frame, beat_grid.get_beat_position(cue_frame) + beat_fraction, false});
+}
+
+void AudioTrack::apply_scheduled_jump(PlayheadRamp& playhead, const BeatGrid& beat_grid, const ScheduledJump& jump, const double jump_from) noexcept{
+	if(beat_grid.empty()) return;
 	
-	const std::uint32_t frames_per_beat = this->get_frames_per_beat(this->bpm.load());
-	const std::uint32_t current_frame = this->current_stdaud_frame.load();
+	const double playhead_beat = beat_grid.get_beat_position(playhead.position);
+	const double landing_beat = jump.is_beat_jump 
+								? playhead_beat + jump.beats 
+								: jump.beats + (playhead_beat - beat_grid.get_beat_position(jump_from));
+	playhead.position = std::max(0.0, beat_grid.get_frame_at_beat_position(landing_beat));
+	if(jump.is_beat_jump and this->loop_queued.load()) this->move_loop(beat_grid, jump.beats);
+}
 
-	std::uint32_t later_nearest_beat_in_frames = this->first_beat_stdaud_frame.load();	
-	//keep adding the frame for the next beat until exceeding current frame
-	while(later_nearest_beat_in_frames < current_frame)
-		later_nearest_beat_in_frames += frames_per_beat;
+double AudioTrack::get_block_end_speed_multiplier(const double block_begin_speed_multiplier) const noexcept{
+	const double current_destination_speed_multiplier = this->destination_speed_multiplier.load();
 	
-	const std::int32_t earlier_nearest_beat_in_frames_unclamped = later_nearest_beat_in_frames - frames_per_beat;
-	//Clamp using signed integer because the substraction may result in a negative number, then clamp to a positive number.
-	const std::uint32_t earlier_nearest_beat_in_frames = ntrb_clamp_i64(earlier_nearest_beat_in_frames_unclamped, this->first_beat_stdaud_frame, INT32_MAX);
+	//Approaching the destination by 1/speed_multiplier_recovering_frames of the remaining difference every frame,
+	//compounded over the whole block at once.
+	const double remaining_ratio = std::pow(1.0 - (1.0 / this->speed_multiplier_recovering_frames), this->minimum_frames_in_buffer);
+	const double block_end_speed_multiplier = current_destination_speed_multiplier + ((block_begin_speed_multiplier - current_destination_speed_multiplier) * remaining_ratio);
 	
-	pthread_rwlock_unlock(&(this->stdaud_from_file.buffer_access));
-	return earlier_nearest_beat_in_frames;
+	if(std::fabs(block_end_speed_multiplier - current_destination_speed_multiplier) <= 0.01)
+		return current_destination_speed_multiplier;
+	return block_end_speed_multiplier;
 }
 
-void AudioTrack::adjust_speed_multiplier() noexcept{
-	const float current_speed_multiplier = this->speed_multiplier.load();
-	const float current_destination_speed_multiplier = this->destination_speed_multiplier.load();
+double AudioTrack::apply_sync(const BeatGrid& beat_grid, const double block_begin_frame, const bool playing) noexcept{
+	const AudioTrack* const master = this->sync_master.load();
+	if(not master or beat_grid.empty()) return 0.0;
+	const std::optional<BeatClock::Reading> master_reading = master->get_beat_clock().read();
+	if(not master_reading.has_value()) return 0.0;
+	
+	//Where the block starts on the output timeline shared by every deck.
+	const std::uint64_t block_output_frame = this->rendered_output_frames + this->concealed_frames.load(std::memory_order_relaxed);
+	const std::optional<SyncCorrection> correction = get_sync_correction(master_reading.value(), block_output_frame, 
+																		beat_grid.get_beat_position(block_begin_frame), beat_grid.get_frames_per_beat(block_begin_frame), 
+																		playing, this->minimum_frames_in_buffer);
+	if(not correction.has_value()) return 0.0;
+	
+	this->destination_speed_multiplier = correction->destination_speed_multiplier;
+	return correction->phase_speed_offset;
+}
+
+void AudioTrack::publish_beat_clock(const BeatGrid& beat_grid, const bool playing) noexcept{
+	if(beat_grid.empty()){
+		this->beat_clock.publish_no_beats();
+		return;
+	}
 	
-	const float speed_multiplier_delta = current_speed_multiplier - current_destination_speed_multiplier;
-	const float speed_multiplier_recovering_per_frame = std::fabs(speed_multiplier_delta) / this->speed_multiplier_recovering_frames;
+	const double next_block_frame = this->current_stdaud_frame.load();
+	BeatClock::Reading reading;
+	reading.output_frame = this->rendered_output_frames + this->concealed_frames.load(std::memory_order_relaxed);
+	reading.beat_position = beat_grid.get_beat_position(next_block_frame);
+	reading.beats_per_frame = this->speed_multiplier.load() / beat_grid.get_frames_per_beat(next_block_frame);
+	reading.playing = playing;
+	this->beat_clock.publish(reading);
+}
+
+bool AudioTrack::is_slip_action() const noexcept{
+	const AudioTrack_PlayMode play_mode_copy = this->play_mode.load();
+	//A brake or a spin-up moves the speed away from the shadow as well, but the shadow follows those.
+	const bool jogging = (play_mode_copy == AudioTrack_regular_play) and not this->spinning_up.load() 
+							and (this->speed_multiplier.load() != this->shadow_speed_multiplier);
+	return this->loop_queued.load() or (play_mode_copy == AudioTrack_cue_play) or (play_mode_copy == AudioTrack_beat_preview) or jogging;
+}
+
+std::optional<AudioTrack::SpeedRamp> AudioTrack::advance_speed_ramp(const AudioTrack_PlayMode play_mode) noexcept{
+	const bool braking = play_mode == AudioTrack_slowdown_to_halt;
+	const bool spinning_up_copy = (play_mode == AudioTrack_regular_play) and this->spinning_up.load();
+	if(not braking and not spinning_up_copy) return std::nullopt;
+	
+	const double pi = std::acos(-1.0);
+	const double destination_speed_multiplier_copy = this->destination_speed_multiplier.load();
+	if(this->speed_ramp_restart.exchange(false)){
+		const double current_speed_multiplier = this->speed_multiplier.load();
+		if(braking){
+			this->brake_begin_speed_multiplier = current_speed_multiplier;
+			this->speed_ramp_position = 0.0;
+		}else{
+			//Spinning up part way through a brake starts from where the curve is at the current speed, rather than from a halt.
+			const double speed_ratio = destination_speed_multiplier_copy > 0.0 ? std::clamp(current_speed_multiplier / destination_speed_multiplier_copy, 0.0, 1.0) : 0.0;
+			this->speed_ramp_position = std::asin(speed_ratio) * 2.0 / pi;
+		}
+	}
 	
-	if(ntrb_float_equal(current_speed_multiplier, current_destination_speed_multiplier, 0.01))
-		this->speed_multiplier = current_destination_speed_multiplier;
-	else if(this->speed_multiplier.load() > this->destination_speed_multiplier.load())
-		this->speed_multiplier = current_speed_multiplier - speed_multiplier_recovering_per_frame;
-	else
-		this->speed_multiplier = current_speed_multiplier + speed_multiplier_recovering_per_frame;
-}
\ No newline at end of file
+	//Read every block, so changing the duration during a ramp carries on along the curve from where it is.
+	const double ramp_seconds = braking ? this->brake_seconds.load() : this->spin_up_seconds.load();
+	const double ramp_frames = std::max(1.0, ramp_seconds * ntrb_std_samplerate);
+	const double begin_position = this->speed_ramp_position;
+	const double end_position = std::min(1.0, begin_position + (this->minimum_frames_in_buffer / ramp_frames));
+	this->speed_ramp_position = end_position;
+	
+	SpeedRamp speed_ramp;
+	speed_ramp.finished = end_position >= 1.0;
+	if(braking){
+		//Like a platter left to friction, slowing gently at first and stopping decisively.
+		speed_ramp.block_begin_speed_multiplier = this->brake_begin_speed_multiplier * std::cos(begin_position * pi / 2.0);
+		speed_ramp.block_end_speed_multiplier = speed_ramp.finished ? 0.0 : this->brake_begin_speed_multiplier * std::cos(end_position * pi / 2.0);
+	}else{
+		//Like a motor, quick off the mark and easing into the tempo, which may change during the spin-up.
+		speed_ramp.block_begin_speed_multiplier = destination_speed_multiplier_copy * std::sin(begin_position * pi / 2.0);
+		speed_ramp.block_end_speed_multiplier = speed_ramp.finished ? destination_speed_multiplier_copy : destination_speed_multiplier_copy * std::sin(end_position * pi / 2.0);
+	}
+	return speed_ramp;
+}
+
+void AudioTrack::advance_shadow_playhead(const AudioTrack_PlayMode play_mode, const std::optional<SpeedRamp>& speed_ramp) noexcept{
+	//Cue play and beat previews start from a paused deck, which stays paused underneath them.
+	if(play_mode != AudioTrack_regular_play and play_mode != AudioTrack_slowdown_to_halt) return;
+	if(speed_ramp.has_value()) this->shadow_speed_multiplier = speed_ramp->block_begin_speed_multiplier;
+	
+	//The sum of the speed of every frame of a linear ramp, which resample_block() adds up frame by frame.
+	const double frames = this->minimum_frames_in_buffer;
+	const double block_end_speed_multiplier = speed_ramp.has_value() 
+												? speed_ramp->block_end_speed_multiplier 
+												: this->get_block_end_speed_multiplier(this->shadow_speed_multiplier);
+	const double speed_step = (block_end_speed_multiplier - this->shadow_speed_multiplier) / frames;
+	this->shadow_position += (frames * this->shadow_speed_multiplier) + (speed_step * frames * (frames - 1.0) / 2.0);
+	this->shadow_speed_multiplier = block_end_speed_multiplier;
+}
+
+void AudioTrack::publish_playhead(const double block_begin_frame, const double block_end_frame, 
+									const double block_begin_speed_multiplier, const double block_end_speed_multiplier) noexcept
+{
+	//A cue, loop or beat preview from another thread moved the playhead during the block, that position takes priority.
+	double expected_frame = block_begin_frame;
+	this->current_stdaud_frame.compare_exchange_strong(expected_frame, block_end_frame);
+	
+	//Jogs during the block are kept on top of the ramped speed.
+	double expected_speed_multiplier = block_begin_speed_multiplier;
+	while(not this->speed_multiplier.compare_exchange_weak(expected_speed_multiplier, 
+			block_end_speed_multiplier + (expected_speed_multiplier - block_begin_speed_multiplier)));
+}
@@ -6,12 +6,23 @@ A file containing the AudioTrack interface and its implementation AudioTrackImpl
 #ifndef AudioTrack_hpp
 #define AudioTrack_hpp
 
+#include "resampler.hpp"
+#include "SampleRing.hpp"
 #include "EffectContainer.hpp"
+#include "TimeStretcher.hpp"
+#include "PcmCache.hpp"
+#include "TrackSource.hpp"
+#include "TrackLoader.hpp"
+#include "BeatClock.hpp"
+#include "LoopCache.hpp"
+#include "HotCueSnippets.hpp"
+#include "AlignedSampleBuffer.hpp"
 
 #include "ntrb/AudioBuffer.h"
 #include "ntrb/aud_std_fmt.h"
 
 #include <mutex>
+#include <array>
 #include <atomic>
 #include <vector>
 #include <optional>
@@ -28,10 +39,40 @@ enum AudioTrack_PlayMode{
 	AudioTrack_cue_play,
 	///Play for only one beat.
 	AudioTrack_beat_preview,
-	///Keep playing while slowing down the playback speed to a halt.
+	///Keep playing while slowing down the playback speed to a halt along the brake curve, then AudioTrack_no_playback.
 	AudioTrack_slowdown_to_halt
 };
 
+///Which beat boundaries the jumps of a playing deck wait for, so they land in time with the beats of the track.
+enum QuantizeMode : std::uint8_t{
+	///Jumps are made at the next block.
+	QuantizeMode_Off,
+	QuantizeMode_Beat,
+	QuantizeMode_HalfBeat,
+	QuantizeMode_QuarterBeat
+};
+
+constexpr std::array<const char*, (int)QuantizeMode_QuarterBeat+1> quantize_mode_names{
+	"Off",
+	"1 beat",
+	"1/2 beat",
+	"1/4 beat",
+};
+
+///The reason AudioTrack::render_frames() stopped rendering.
+enum AudioTrack_RenderStatus{
+	///Every frame of the block was rendered.
+	AudioTrack_RenderDone,
+	///The playhead reached the end position given to AudioTrack::render_frames().
+	AudioTrack_RenderReachedEnd,
+	///The playhead went past the last frame of the track.
+	AudioTrack_RenderReachedEOF,
+	///The file of the track failed to load.
+	AudioTrack_RenderLoadError,
+	///The frames to render next are not decoded yet, the playhead is left where it is.
+	AudioTrack_RenderSourceNotReady
+};
+
 /**
 A representation of a turntable deck.
 \todo
@@ -40,49 +81,61 @@ A representation of a turntable deck.
 class AudioTrack{
 	public:
 	/**
-	Initialises AudioTrack::sample_access_mutex, AudioTrack::samples; 
-	sets AudioTrack::minimum_frames_in_buffer and AudioTrack::track_id.
+	Initialises AudioTrack::samples and AudioTrack::output_ring; 
+	sets AudioTrack::minimum_frames_in_buffer, AudioTrack::callbacks_rendered_ahead and AudioTrack::track_id,
+	and starts the AudioTrack::track_loader thread, which looks tracks up in *analysis_cache*.
 	
 	\param[in] minimum_frames_in_buffer The exact amount of stdaud frames which the audio engine reads per callback.
+	\param[in] callbacks_rendered_ahead The amount of callbacks worth of frames the deck keeps rendered ahead of the audio engine.
 	\param[in] track_id track id which the interface represents.
+	\param[in] analysis_cache The cache of track metadata shared by every deck, which must outlive the deck.
 	*/
-	AudioTrack(const std::uint32_t minimum_frames_in_buffer, const uint8_t track_id);
-	
-	///Frees AudioTrack::stdaud_from_file if AudioTrack::initialised_stdaud_from_file is true.
-	~AudioTrack();
+	AudioTrack(const std::uint32_t minimum_frames_in_buffer, const std::uint8_t callbacks_rendered_ahead, const uint8_t track_id, TrackAnalysisCache& analysis_cache);
 	
+
 	/**
-	Loads the final audio of the deck to be played in an audio engine callback to AudioTrack::samples.
+	Loads the final audio of the deck to be played in an audio engine callback to AudioTrack::samples,
+	then publishes it to AudioTrack::output_ring for the Mixer.
 	
-	This function is used as a detached thread, any errors are reported through standard streams.
+	This function is called from the persistent RenderWorker of the deck, any errors are reported through standard streams.
 	
 	Errors and information are reported through standard streams such as:
 	- the underlying pure stdaud read from ntrb_AudioBuffer failing to read its audio file, reported through std::cerr
-	- AudioTrack::stdaud_from_file reaching EOF, reported through std::cout
+	- the track reaching EOF, reported through std::cout
+	
+	A track loaded by AudioTrack::track_loader is swapped in before the block is rendered.
+	Frames are only read from the PcmCache or the ReadAheadDecoder of AudioTrack::source, the file itself is never read from this thread.
 	*/
 	void load_samples() noexcept;
 	/**	
-	Sets the file which the deck will play (frees the previous audio file if needed).
-	Error from initialising an ntrb_AudioBuffer for the file is returned.
-	
-	///\todo cant have incorrect audio loaded
-	*/
-	ntrb_AudioBufferNew_Error set_file_to_load_from(const char* const filename, const std::uint32_t frames_per_callback) noexcept;
-	/**
-	Loads audio info file from aud_filename, usually by reading from a file which has the extension of aud_filename replaced with .txt.
+	Asks AudioTrack::track_loader to open the file which the deck will play, predecode its first seconds and look up its metadata,
+	returning without waiting for any of it. The deck keeps playing its current track until the new one is swapped in,
+	then plays it from the start. Errors from opening the file are reported through the infobar by the loader thread.
 	
-	Errors are displayed through std::cerr.
+	Unless *pcm_cache_mode* is PcmCacheMode_Off, the whole file is also decoded to a PcmCache in the background,
+	which the deck plays from wherever it is decoded, instead of decoding from the file again.
 	*/
-	void load_audio_info(const std::string& aud_filename);
+	void set_file_to_load_from(const std::string& filename, const PcmCacheMode pcm_cache_mode);
 	///Displays the details of the deck through std::cout.
 	void display_deck_info();
 	
 	/**
 	If play, pauses; if pause, plays :D
+	Pausing brakes and playing spins up, over AudioTrack::brake_seconds and AudioTrack::spin_up_seconds.
 	
 	Returns false if errors occurred while toggling.
 	*/
 	bool toggle_play_pause() noexcept;
+	/**
+	Slows a playing deck down to a halt over AudioTrack::brake_seconds as a turntable switched off would, then pauses it.
+	Pauses straight away if AudioTrack::brake_seconds is 0.
+	*/
+	void brake() noexcept;
+	/**
+	Plays a deck which is not playing, speeding up from a halt to its tempo over AudioTrack::spin_up_seconds as a turntable switched on would.
+	A deck braking spins up from the speed it slowed down to. Plays straight away if AudioTrack::spin_up_seconds is 0.
+	*/
+	void spin_up() noexcept;
 	
 	AudioTrack_PlayMode get_play_mode() const noexcept;
 	
@@ -92,7 +145,7 @@ class AudioTrack{
 	
 	This function should be called when the deck is in AudioTrack_no_playback.
 	
-	Returns false if could not find the nearest cue point due to rwlock error.
+	Returns false if could not find the nearest cue point as the track has no bpm.
 	*/
 	bool initiate_cue_play() noexcept;
 	
@@ -107,22 +160,40 @@ class AudioTrack{
 	/**
 	Sets AudioTrack::current_stdaud_frame to the beat after it and sets AudioTrack::play_mode to AudioTrack_beat_preview.
 	
-	Returns false if could not find the next beat due to rwlock error.
+	Returns false if could not find the next beat as the track has no bpm.
 	*/
 	bool play_only_next_beat() noexcept;
 	
 	/**
 	Sets AudioTrack::current_stdaud_frame to the beat before it and sets AudioTrack::play_mode to AudioTrack_beat_preview.
 	
-	Returns false if could not find the previous beat due to rwlock error.
+	Returns false if could not find the previous beat as the track has no bpm.
 	*/
 	bool play_only_prev_beat() noexcept;
 
 	///Get a const reference to AudioTrack::samples.
-	const std::vector<float>& get_samples() const noexcept{
+	const AlignedSampleBuffer& get_samples() const noexcept{
 		return this->samples;
 	}
 	
+	///Get the ring which the Mixer drains rendered samples of the deck from, the deck is its only producer and the Mixer its only consumer.
+	SampleRing& get_output_ring() noexcept{
+		return this->output_ring;
+	}
+	///Returns true if the output ring has less than AudioTrack::callbacks_rendered_ahead blocks waiting to be mixed.
+	bool needs_rendering() const noexcept{
+		const std::size_t samples_per_block = this->minimum_frames_in_buffer * ntrb_std_audchannels;
+		return this->output_ring.readable_samples() < samples_per_block * callbacks_rendered_ahead;
+	}
+	///Called by the Mixer when the output ring could not provide a full block of samples, *concealed_frames* of it concealed instead.
+	void report_underrun(const std::uint64_t concealed_frames) noexcept{
+		this->underrun_count.fetch_add(1, std::memory_order_relaxed);
+		this->concealed_frames.fetch_add(concealed_frames, std::memory_order_relaxed);
+	}
+	std::uint32_t get_underrun_count() const noexcept{
+		return this->underrun_count.load(std::memory_order_relaxed);
+	}
+	
 	///Jogs the deck to play at a slightly slower speed temporarily.
 	void fine_step_backward() noexcept;
 	///Jogs the deck to play at a slightly faster speed temporarily.
@@ -143,6 +214,7 @@ class AudioTrack{
 	
 	/**
 	Set the nearest cue point as the loop begin point and enters the loop with AudioTrack::beats_per_loop as the loop length. 
+	With AudioTrack::quantize on while the deck plays, the loop begins at the next quantize boundary instead.
 	
 	This implies setting AudioTrack::loop_frame_begin, AudioTrack::loop_frame_end, 
 	with the latter being AudioTrack::beats_per_loop after the former.
@@ -156,22 +228,59 @@ class AudioTrack{
 	Moves the next loading frame to the nearest earlier cue point. Returns false if couldn't find a nearby cue point.
 	
 	Makes more sense to move to earlier cue point because the user will press cue after hearing the beat of the cue.
+	With AudioTrack::quantize on while the deck plays, the jump is scheduled for the next quantize boundary instead,
+	landing on the cue point at the same position within the beat as the boundary.
 	*/
 	bool cue_to_nearest_cue_point() noexcept;
+	/**
+	Jumps the playhead by *beats* beats, keeping its position within the beat. A loop being played moves along with it.
+	
+	With AudioTrack::quantize on while the deck plays, the jump is scheduled for the next quantize boundary,
+	and jumps scheduled for the same boundary add up. Otherwise the playhead jumps at the next block.
+	Returns false if the track has no bpm.
+	*/
+	bool beat_jump(const double beats) noexcept;
+	/**
+	Sets hot cue *hot_cue_index* at the playhead if it is not set, on the nearest quantize boundary with AudioTrack::quantize on,
+	and stores it to the record of the track. Otherwise jumps to it, at the next quantize boundary with AudioTrack::quantize on while the deck plays,
+	landing on the hot cue at the same position within the beat as the boundary.
+	
+	The jump plays from the snippet of the hot cue, decoded once it is set, so it does not wait for the decoder.
+	Returns false if *hot_cue_index* is not below hot_cue_count.
+	*/
+	bool press_hot_cue(const std::uint8_t hot_cue_index) noexcept;
+	///Deletes hot cue *hot_cue_index* from the deck and the record of the track. Returns false if *hot_cue_index* is not below hot_cue_count.
+	bool delete_hot_cue(const std::uint8_t hot_cue_index) noexcept;
+	///The frame of hot cue *hot_cue_index*, below hot_cue_count, no_hot_cue if it is not set.
+	double get_hot_cue(const std::uint8_t hot_cue_index) const noexcept{
+		return this->hot_cues[hot_cue_index].load();
+	}
 	
 	std::uint8_t get_track_id() const noexcept{
 		return this->track_id;		
 	}
+	/**
+	The beats of the track the deck plays, never nullptr. Read without locking the deck, and can be kept while another track is loaded.
+	Not for the render thread, as dropping the last copy frees the BeatGrid.
+	*/
+	std::shared_ptr<const BeatGrid> get_beat_grid() const noexcept{
+		return this->track_loader.get_loaded_beat_grid();
+	}
+	///The waveform of the track the deck plays, nullptr until it is analysed. Read without locking the deck, not for the render thread either.
+	std::shared_ptr<const WaveformPyramid> get_waveform() const noexcept{
+		return this->track_loader.get_loaded_waveform();
+	}
+	///The tempo at the playhead, 0 if the track has no bpm.
 	float get_bpm() const noexcept{
-		return this->bpm.load();		
+		return this->get_beat_grid()->get_bpm(this->current_stdaud_frame.load());
 	}
 	double get_current_stdaud_frame() const noexcept{
 		return this->current_stdaud_frame.load();
 	}
-	std::uint32_t get_loop_frame_begin() const noexcept{
+	double get_loop_frame_begin() const noexcept{
 		return this->loop_frame_begin.load();
 	}
-	std::uint32_t get_loop_frame_end() const noexcept{
+	double get_loop_frame_end() const noexcept{
 		return this->loop_frame_end.load();
 	}
 	float get_beats_per_loop() const noexcept{
@@ -180,8 +289,26 @@ class AudioTrack{
 	bool is_loop_queued() const noexcept{
 		return this->loop_queued.load();
 	}
-	const std::string& get_filename() const noexcept{
-		return this->audfile_name;
+	///Whether the deck plays an action slip mode returns from, as of the last block.
+	bool is_slipping() const noexcept{
+		return this->slipping.load();
+	}
+	///Where the shadow playhead of slip mode is as of the last block, which the deck returns to once the action ends.
+	double get_shadow_frame() const noexcept{
+		return this->shadow_frame.load();
+	}
+	///Where the deck is in its beats, published by its render thread after every block for the decks synced to it.
+	const BeatClock& get_beat_clock() const noexcept{
+		return this->beat_clock;
+	}
+	std::string get_filename() const{
+		return this->track_loader.get_loaded_filename();
+	}
+	bool is_loading_track() const noexcept{
+		return this->track_loader.is_loading();
+	}
+	bool is_analysing_track() const noexcept{
+		return this->track_loader.is_analysing();
 	}
 	
 	enum EffectType effect_type;
@@ -190,80 +317,252 @@ class AudioTrack{
 		return this->effect_container;
 	}
 
-	///Mutex for accessing AudioTrack::samples.
-	std::mutex sample_access_mutex;
 	std::atomic_bool output_to_monitor = false;
 	std::atomic<double> destination_speed_multiplier = 1.0;
+	///The channel fader of the deck, applied by the Mixer to both the master and the cue bus.
+	std::atomic<float> gain = 1.0;
+	///How frames in between the frames of the track are computed when the deck is not playing at 1x.
+	std::atomic<ResamplerInterpolation> interpolation = ResamplerInterpolation_Linear;
+	/**
+	Whether the deck plays through AudioTrack::time_stretcher, so the tempo knob and jogs change the tempo without changing the pitch.
+	AudioTrack::interpolation is not used while key lock is on, as the time-stretcher does not resample.
+	*/
+	std::atomic_bool key_lock = false;
+	/**
+	Whether cue jumps, beat jumps and loops made while the deck plays wait for the next beat boundary of the mode.
+	The render thread makes a scheduled jump at the exact frame the playhead reaches the boundary, inside whichever block that is.
+	*/
+	std::atomic<QuantizeMode> quantize = QuantizeMode_Off;
+	///Whether the loop of the deck is crossfaded at its seam once it plays from AudioTrack::loop_cache.
+	std::atomic_bool loop_crossfade = true;
+	/**
+	Whether loops, cue play, beat previews and jogs play from a temporary playhead, while a shadow playhead moves on through the track
+	as the deck would have played without them. Once the action ends, the deck carries on from the shadow playhead.
+	
+	The shadow playhead is advanced by the render thread once per block, by exactly the frames the playhead would have moved along the same speed ramp,
+	so it costs no decoding. The deck returning to it plays from the PcmCache if it has decoded there, otherwise waits for the decoder as a cue jump does.
+	*/
+	std::atomic_bool slip = false;
+	///How long AudioTrack::brake() takes the deck to halt, 0 to pause straight away.
+	std::atomic<double> brake_seconds = 0.0;
+	///How long AudioTrack::spin_up() takes the deck to reach its tempo, 0 to play straight away.
+	std::atomic<double> spin_up_seconds = 0.0;
 	
-	private:
 	/**
-	Append a single frame (both left and right samples) to AudioTrack::samples while taking playback speed into account,
-	increment AudioTrack::current_stdaud_frame by AudioTrack::speed_multiplier 
-	and call AudioTrack::adjust_speed_multiplier.
+	The deck this deck is synced to, nullptr if it is not synced. Never this deck, and the master must outlive the sync.
 	
-	If the frame to load is not within the boundary of the underlying AudioTrack::ntrb_AudioBuffer, the function returns false, notifying to the caller to load the ntrb_AudioBuffer and call this function again to append to AudioTrack::samples.
+	While synced, the render thread sets AudioTrack::destination_speed_multiplier every block so the tempo of the deck matches the master,
+	and while both decks are playing, nudges the speed of each block to pull the beats of the deck into phase with the master.
+	Only applied while both tracks have beats.
+	*/
+	std::atomic<AudioTrack*> sync_master = nullptr;
+	
+	///The frames of the track decoded to the PcmCache of the deck as of the last block, 0 without a cache.
+	std::atomic<std::uint64_t> pcm_cached_frames = 0;
+	///Whether the PcmCache of the deck held the whole track as of the last block.
+	std::atomic_bool pcm_cache_complete = false;
+	///Whether the loop of the deck played from AudioTrack::loop_cache as of the last block.
+	std::atomic_bool loop_cache_complete = false;
+	
+	private:
+	/**
+	Resamples, or time-stretches with key lock on, frames of the track with *playhead* to AudioTrack::samples, starting from *rendered_frames*,
+	until AudioTrack::samples has AudioTrack::minimum_frames_in_buffer frames or the playhead reaches *end_position*.
+	*rendered_frames* is advanced by the amount of frames rendered.
 	
-	This function assumes the caller has acquired at least a read lock of AudioTrack::stdaud_from_file.
+	Frames are read from AudioTrack::loop_cache wherever it holds them, then from the PcmCache of AudioTrack::source wherever it has decoded them,
+	then from the HotCueSnippets of the track, otherwise from its ReadAheadDecoder.
 	*/
-	bool load_single_frame();
+	AudioTrack_RenderStatus render_frames(PlayheadRamp& playhead, std::uint32_t& rendered_frames, const double end_position);
 	/**
 	Fills AudioTrack::samples for looping, 
 	and guaranteeing no garbage is in AudioTrack::samples by 0 filling AudioTrack::samples
-	if AudioTrack::in_pause_state is true or the underlying AudioTrack::stdaud_from_file encounters any errors.
+	if AudioTrack::in_pause_state is true or the file of the track encounters any errors.
 	
-	The function keeps AudioTrack::current_stdaud_frame to be within 
-	AudioTrack::loop_frame_begin and AudioTrack::loop_frame_end at all times to create an audio loop.
+	The function keeps *playhead* to be within 
+	AudioTrack::loop_frame_begin and AudioTrack::loop_frame_end at all times to create an audio loop,
+	wrapping it at the exact fractional frame it passes the loop end.
 	
-	\return false for any errors from loading AudioTrack::stdaud_from_file but not for ntrb_AudioBufferLoad_EOF.
-	\return true if no errors occurred or AudioTrack::stdaud_from_file returns ntrb_AudioBufferLoad_EOF.
+	Rendering stops early once the playhead reaches *jump_frame*, setting AudioTrack::block_jump_from, as AudioTrack::fill_sample_buffer() does.
+	A *jump_frame* at or past the loop end is reached where the playhead wraps, as the playhead never gets there.
+	
+	\return false for any errors from loading the file of the track but not for ntrb_AudioBufferLoad_EOF.
+	\return true if no errors occurred or the file of the track returns ntrb_AudioBufferLoad_EOF.
 	*/
-	bool fill_sample_buffer_while_in_loop(const std::uint32_t minimum_samples_in_sample_buffer);
+	bool fill_sample_buffer_while_in_loop(PlayheadRamp& playhead, std::uint32_t& rendered_frames, const double jump_frame);
 	
 	/**
 	Fills AudioTrack::samples for regular playback, 
 	and guaranteeing no garbage is in AudioTrack::samples by 0 filling AudioTrack::samples
-	if AudioTrack::in_pause_state is true or the underlying AudioTrack::stdaud_from_file encounters any errors.
+	if AudioTrack::in_pause_state is true or the file of the track encounters any errors.
+	
+	Rendering stops early once the playhead reaches *jump_frame*, setting AudioTrack::block_jump_from, so the caller can make the scheduled jump.
 	
-	\return false for any errors from loading AudioTrack::stdaud_from_file but not for ntrb_AudioBufferLoad_EOF.
-	\return true if no errors occurred or AudioTrack::stdaud_from_file returns ntrb_AudioBufferLoad_EOF.	
+	\return false for any errors from loading the file of the track but not for ntrb_AudioBufferLoad_EOF.
+	\return true if no errors occurred or the file of the track returns ntrb_AudioBufferLoad_EOF.	
+	*/
+	bool fill_sample_buffer(PlayheadRamp& playhead, std::uint32_t& rendered_frames, const double jump_frame);
+	
+	/**
+	Return a stdaud frame number representing the nearest beat (or cue point) of *beat_grid* to AudioTrack::current_stdaud_frame. 
+	Returns a std::nullopt if the track has no bpm.
 	*/
-	bool fill_sample_buffer(const std::uint32_t minimum_samples_in_sample_buffer);
+	std::optional<double> find_nearest_loop_cue_point(const BeatGrid& beat_grid) const noexcept;
 	
 	/**
-	Return a stdaud frame number representing the nearest beat (or cue point) to AudioTrack::current_stdaud_frame. 
-	Returns a std::nullopt if couldn't acquire a rdlock of AudioTrack::stdaud_from_file.
+	Return a stdaud frame number representing the beat (or cue point) of *beat_grid* prior to AudioTrack::current_stdaud_frame.
+	Returns a std::nullopt if the track has no bpm.
 	*/
-	std::optional<std::uint32_t> find_nearest_loop_cue_point() noexcept;
+	std::optional<double> find_eariler_cue_point(const BeatGrid& beat_grid) const noexcept;
+	///Sets AudioTrack::loop_frame_end AudioTrack::beats_per_loop beats of *beat_grid* after AudioTrack::loop_frame_begin.
+	void update_loop_frame_end(const BeatGrid& beat_grid) noexcept;
+	///Moves AudioTrack::loop_frame_begin and AudioTrack::loop_frame_end by *beats* beats of *beat_grid*.
+	void move_loop(const BeatGrid& beat_grid, const double beats) noexcept;
+	///Hands AudioTrack::hot_cues to AudioTrack::track_loader to be stored and their snippets decoded.
+	void store_hot_cues() noexcept;
+	
+	///A jump of the playhead made by the render thread once the playhead reaches a quantize boundary.
+	struct ScheduledJump{
+		///Set from AudioTrack::next_scheduled_jump_id, so the render thread only clears the jump it made.
+		std::uint32_t id;
+		///The frame of the track the playhead jumps from once it reaches it.
+		double trigger_frame;
+		///The beats the playhead jumps by for a beat jump, otherwise the beat position it lands on from the trigger frame.
+		double beats;
+		///Whether the jump is relative to the playhead, and moves a loop being played along with it.
+		bool is_beat_jump;
+	};
+	/**
+	The first quantize boundary of *beat_grid* at or after *frame*.
+	Returns std::nullopt if AudioTrack::quantize is off, the deck is not playing or the track has no bpm, as nothing is to be waited for.
+	*/
+	std::optional<double> get_quantized_frame(const BeatGrid& beat_grid, const double frame) const noexcept;
+	///Replaces the jump scheduled for the render thread with *jump*, adding up beat jumps scheduled for the same boundary.
+	void schedule_jump(ScheduledJump jump) noexcept;
+	///Schedules a jump from the quantize boundary *boundary_frame* of *beat_grid* to *cue_frame*, at the same position within the beat as the boundary.
+	void schedule_cue_jump(const BeatGrid& beat_grid, const double boundary_frame, const double cue_frame) noexcept;
+	/**
+	Makes *jump* of *beat_grid* from *playhead*, which reached the trigger frame of the jump at *jump_from*, or wrapped a loop to it.
+	The fraction of a beat the playhead passed *jump_from* by is kept, so the jump is sample accurate. Render thread only.
+	*/
+	void apply_scheduled_jump(PlayheadRamp& playhead, const BeatGrid& beat_grid, const ScheduledJump& jump, const double jump_from) noexcept;
 	
 	/**
-	Return a stdaud frame number representing the beat (or cue point) prior to AudioTrack::current_stdaud_frame.
-	Returns a std::nullopt if couldn't acquire a rdlock of AudioTrack::stdaud_from_file.
+	Returns the speed multiplier a block starting at *block_begin_speed_multiplier* ends at while approaching AudioTrack::destination_speed_multiplier.
+	The block is rendered with a linear ramp between the two, instead of adjusting AudioTrack::speed_multiplier in between frames.
+	*/
+	double get_block_end_speed_multiplier(const double block_begin_speed_multiplier) const noexcept;
+	/**
+	Sets AudioTrack::destination_speed_multiplier to the tempo of AudioTrack::sync_master, if the deck is synced and both tracks have beats,
+	and returns the speed to add to the block starting at *block_begin_frame* to pull it into phase with the master, 0 if there is none.
+	*/
+	double apply_sync(const BeatGrid& beat_grid, const double block_begin_frame, const bool playing) noexcept;
+	/**
+	Publishes where the deck is in its beats as of the start of the next block to AudioTrack::beat_clock,
+	after AudioTrack::current_stdaud_frame and AudioTrack::speed_multiplier are published for it. *playing* is whether the deck moves at all.
 	*/
-	std::optional<std::uint32_t> find_eariler_cue_point() noexcept;
+	void publish_beat_clock(const BeatGrid& beat_grid, const bool playing) noexcept;
+	/**
+	Stores the playhead at the end of a block to AudioTrack::current_stdaud_frame and AudioTrack::speed_multiplier, once per block.
 	
-	///Adjust AudioTrack::speed_multiplier to approach AudioTrack::destination_speed_multiplier in between frames.
-	void adjust_speed_multiplier() noexcept;
+	If AudioTrack::current_stdaud_frame was changed from another thread since the block began (cue, loop or beat preview), it is kept.
+	If AudioTrack::speed_multiplier was changed from another thread (a jog), the change is added on top of the block end speed.
+	*/
+	void publish_playhead(const double block_begin_frame, const double block_end_frame, 
+							const double block_begin_speed_multiplier, const double block_end_speed_multiplier) noexcept;
+	///The speeds a block of a brake or a spin-up is rendered with, a linear ramp between two points of the curve.
+	struct SpeedRamp{
+		double block_begin_speed_multiplier;
+		double block_end_speed_multiplier;
+		///Whether the block ends the brake at a halt, or the spin-up at the tempo of the deck.
+		bool finished;
+	};
+	/**
+	The speeds the block is rendered with if the deck brakes or spins up in *play_mode*, std::nullopt if it does neither.
+	Moves the brake or the spin-up along its curve by a block, the curve computed once per block rather than for every frame. Render thread only.
+	*/
+	std::optional<SpeedRamp> advance_speed_ramp(const AudioTrack_PlayMode play_mode) noexcept;
+	/**
+	Whether the deck is on an action slip mode returns from: a loop, cue play, a beat preview, 
+	or a jog which AudioTrack::speed_multiplier has not recovered from. Render thread only.
+	*/
+	bool is_slip_action() const noexcept;
+	/**
+	Moves AudioTrack::shadow_position through a block, along the speed ramp the playhead would have had from AudioTrack::shadow_speed_multiplier
+	without any jog, if the deck plays through its beats in *play_mode*. Render thread only.
+	*/
+	void advance_shadow_playhead(const AudioTrack_PlayMode play_mode, const std::optional<SpeedRamp>& speed_ramp) noexcept;
 	
-	///A vector containing the final stdaud frames of the deck for an audio engine callback.
-	std::vector<float> samples;
+	///The final stdaud frames of the deck for an audio engine callback, sized to AudioTrack::minimum_frames_in_buffer frames at construction.
+	AlignedSampleBuffer samples;
 	///The number of frames to be in AudioTrack::samples which an AudioTrack must provide for the audio engine callback.
 	const std::uint32_t minimum_frames_in_buffer;
 	
+	///The amount of blocks the deck keeps waiting in the output ring.
+	const std::uint8_t callbacks_rendered_ahead;
+	///Rendered samples waiting to be drained by the Mixer, with room for one more block than AudioTrack::callbacks_rendered_ahead.
+	SampleRing output_ring;
+	///The amount of times the Mixer found the output ring of the deck without a full block of samples.
+	std::atomic<std::uint32_t> underrun_count = 0;
+	///The frames the Mixer concealed in place of frames from the output ring of the deck.
+	std::atomic<std::uint64_t> concealed_frames = 0;
+	///The frames the deck wrote to its output ring, only accessed from the render thread of the deck.
+	std::uint64_t rendered_output_frames = 0;
+	/**
+	The beats and the hot cue snippets of the track of AudioTrack::source, swapped in from AudioTrack::track_loader.
+	Only accessed from the render thread of the deck, which never drops the last copy of either.
+	*/
+	RenderTrackInfo render_track_info;
+	BeatClock beat_clock;
+	
 	std::atomic<AudioTrack_PlayMode> play_mode = AudioTrack_no_playback;
 	
 	/**
 	 * The stdaud frame which an AudioTrack is at. 
 	 * This has to be incremented by AudioTrack::speed_multiplier.
-	 * This can be used to set the start of AudioTrack::stdaud_from_file.
 	 * */
 	std::atomic<double> current_stdaud_frame;
-	/**
-	 * The underlying object which contains a buffer of stdaud frames of an audio file to play from.  
-	 */
-	ntrb_AudioBuffer stdaud_from_file;
-	///Used to determine whether to ntrb_AudioBuffer_free AudioTrack::stdaud_from_file or not,
-	///since the function does not allow for uninitialised objects to be freed.
-	bool initialised_stdaud_from_file = false;
+	///The track the deck plays from, nullptr until one is loaded. Only accessed from the render thread of the deck.
+	std::unique_ptr<TrackSource> source;
+	///Loads tracks into TrackSources off the render thread, which AudioTrack::load_samples() swaps AudioTrack::source with.
+	TrackLoader track_loader;
+	///AudioTrack::interpolation copied at the beginning of every block, so a whole block is rendered with the same interpolation.
+	ResamplerInterpolation block_interpolation = ResamplerInterpolation_Linear;
+	///AudioTrack::key_lock copied at the beginning of every block.
+	bool block_key_lock = false;
+	///Whether AudioTrack::render_frames() went past the end of the track during the current block.
+	bool block_reached_track_end = false;
+	///Whether AudioTrack::samples is being filled by AudioTrack::fill_sample_buffer_while_in_loop(), so the seam of AudioTrack::loop_cache may be played.
+	bool block_in_loop = false;
+	///The loop being played, copied from AudioTrack::source so the decoder does not decode it every pass. Only accessed from the render thread.
+	LoopCache loop_cache;
+	///Whether the playhead was on an action slip mode returns from during the last block. Only accessed from the render thread.
+	bool in_slip_action = false;
+	///The shadow playhead of slip mode, following the playhead outside of an action and moving on by itself during one. Render thread only.
+	double shadow_position = 0.0;
+	double shadow_speed_multiplier = 1.0;
+	///Set by AudioTrack::brake() and AudioTrack::spin_up(), so the render thread starts the curve over.
+	std::atomic_bool speed_ramp_restart = false;
+	///Whether AudioTrack::spin_up() is bringing the deck up to its tempo.
+	std::atomic_bool spinning_up = false;
+	///How far along its curve the brake or spin-up is, from 0 to 1. Render thread only.
+	double speed_ramp_position = 0.0;
+	///The speed the brake began from. Render thread only.
+	double brake_begin_speed_multiplier = 1.0;
+	///AudioTrack::in_slip_action and AudioTrack::shadow_position published for the UI.
+	std::atomic_bool slipping = false;
+	std::atomic<double> shadow_frame = 0.0;
+	///Where the playhead reached the scheduled jump during the current fill of AudioTrack::samples, std::nullopt if it did not.
+	std::optional<double> block_jump_from;
+	
+	///Guards AudioTrack::scheduled_jump, which is only held to copy it.
+	std::mutex scheduled_jump_mutex;
+	///The jump waiting for the playhead to reach its quantize boundary. Dropped when the deck stops playing or loads another track.
+	std::optional<ScheduledJump> scheduled_jump;
+	std::uint32_t next_scheduled_jump_id = 0;
+	///Whether the track played to its end, so playing again replays it from the start.
+	std::atomic_bool reached_track_end = false;
+	TimeStretcher time_stretcher;
 	
 	/**
 	 The ratio of speed at which the AudioTrack plays at.
@@ -272,7 +571,7 @@ class AudioTrack{
 	 as 1x means incrementing one frame after another, 0.5 is play the same frame twice 
 	 and 2x means skip every other frame, etc.
 
-	 This value differs from AudioTrack::destination_speed_multiplier which can only be changed by the tempo knob and changes instantly; while speed_multiplier needs time to catch up with the former to simulate turntable rotational speed acceleration/deceleration. It can be changed from the tempo knob or jogging, and should be changed for every frame applied to AudioTrack::samples to simulate smooth turntable rotational acceleration. 
+	 This value differs from AudioTrack::destination_speed_multiplier which can only be changed by the tempo knob and changes instantly; while speed_multiplier needs time to catch up with the former to simulate turntable rotational speed acceleration/deceleration. It can be changed from the tempo knob or jogging, and is ramped across every block rendered to AudioTrack::samples to simulate smooth turntable rotational acceleration. 
 	 */
 	std::atomic<double> speed_multiplier = 1.0;
 	///The playback speed ratio to theoretically play at.
@@ -282,38 +581,31 @@ class AudioTrack{
 	 * The amount of time for AudioTrack::speed_multiplier to reach AudioTrack::destination_speed_multiplier, regardless of the difference between the two.
 	 */
 	static constexpr float speed_multiplier_recovering_seconds = 0.5;
-	///AudioTrack::speed_multiplier_recovering_seconds but as stdaud frame count actual calculations in AudioTrack::adjust_speed_multiplier.
+	///AudioTrack::speed_multiplier_recovering_seconds but as stdaud frame count actual calculations in AudioTrack::get_block_end_speed_multiplier.
 	static constexpr float speed_multiplier_recovering_frames = speed_multiplier_recovering_seconds * 48000.0;
 	///The speed multiplier change for a jog click.
 	static constexpr float fine_step_speed_multiplier_delta = 0.025;
 	
 	///The frame which cue play started from, used for returning back after cue play has stopped.
-	std::atomic<std::uint32_t> cue_play_begin_frame;
+	std::atomic<double> cue_play_begin_frame = 0.0;
 	///The frame to end playback if the deck is previewing a beat.
-	std::atomic<std::uint32_t> end_beat_preview_at_frame;
+	std::atomic<double> end_beat_preview_at_frame;
+	///The frame the beat being previewed starts from, which the deck returns to after the preview.
+	std::atomic<double> beat_preview_begin_frame;
 
 	//Looping
-	std::atomic<std::uint32_t> loop_frame_begin;
-	std::atomic<std::uint32_t> loop_frame_end;
+	std::atomic<double> loop_frame_begin;
+	std::atomic<double> loop_frame_end;
 	std::atomic<float> beats_per_loop = 4;
 	std::atomic<bool> loop_queued = false;
-	///The stdaud frame at which the first beat is at.
-	///This is used in calculating loops and cue points.
-	std::atomic<std::uint32_t> first_beat_stdaud_frame;
+	
+	///The frames of the hot cues of the track, no_hot_cue for those not set. Set from the track by the render thread as it is swapped in.
+	std::array<std::atomic<double>, hot_cue_count> hot_cues;
 
 	//Track data
-	std::string audfile_name = "Track not loaded.";
-	std::atomic<float> bpm = 0.0;		
 	std::uint8_t track_id;
 
-	bool fill_sample_buffer_while_in_beat_preview(const std::uint32_t minimum_samples_in_sample_buffer);
-	
-	static float get_seconds_per_beat(const float bpm) noexcept{
-		return 60.0 / bpm;
-	}
-	static float get_frames_per_beat(const float bpm) noexcept{
-		return (float)ntrb_std_samplerate * get_seconds_per_beat(bpm);
-	}
+	bool fill_sample_buffer_while_in_beat_preview(PlayheadRamp& playhead, std::uint32_t& rendered_frames);
 	
 	EffectContainer effect_container;
 };
@@ -0,0 +1,71 @@
+#include "BeatClock.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+void BeatClock::publish(const Reading& reading) noexcept{
+	const std::uint32_t sequence_copy = this->sequence.load(std::memory_order_relaxed);
+	this->sequence.store(sequence_copy + 1, std::memory_order_relaxed);
+	//Every store below becomes visible after the odd sequence.
+	std::atomic_thread_fence(std::memory_order_release);
+
+	this->has_beats.store(true, std::memory_order_relaxed);
+	this->output_frame.store(reading.output_frame, std::memory_order_relaxed);
+	this->beat_position.store(reading.beat_position, std::memory_order_relaxed);
+	this->beats_per_frame.store(reading.beats_per_frame, std::memory_order_relaxed);
+	this->playing.store(reading.playing, std::memory_order_relaxed);
+
+	this->sequence.store(sequence_copy + 2, std::memory_order_release);
+}
+
+void BeatClock::publish_no_beats() noexcept{
+	this->has_beats.store(false, std::memory_order_release);
+}
+
+std::optional<BeatClock::Reading> BeatClock::read() const noexcept{
+	while(true){
+		const std::uint32_t sequence_before = this->sequence.load(std::memory_order_acquire);
+		if(sequence_before % 2 != 0) continue;
+
+		const bool has_beats_copy = this->has_beats.load(std::memory_order_relaxed);
+		const Reading reading{
+			this->output_frame.load(std::memory_order_relaxed),
+			this->beat_position.load(std::memory_order_relaxed),
+			this->beats_per_frame.load(std::memory_order_relaxed),
+			this->playing.load(std::memory_order_relaxed)
+		};
+
+		//Every load above completes before the sequence is read again.
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if(this->sequence.load(std::memory_order_relaxed) != sequence_before) continue;
+		if(not has_beats_copy) return std::nullopt;
+		return reading;
+	}
+}
+
+std::optional<SyncCorrection> get_sync_correction(const BeatClock::Reading& master, const std::uint64_t follower_output_frame, const double follower_beat_position,
+									const double follower_frames_per_beat, const bool follower_playing, const std::uint32_t frames_per_block) noexcept
+{
+	const double matching_speed_multiplier = master.beats_per_frame * follower_frames_per_beat;
+	if(not (matching_speed_multiplier > 0.0) or not std::isfinite(matching_speed_multiplier)) return std::nullopt;
+
+	//Follower beats per master beat, a power of 2 keeping the speed within half an octave of 1x.
+	const double half_octave = std::sqrt(2.0);
+	double beats_per_master_beat = 1.0;
+	while(matching_speed_multiplier * beats_per_master_beat > half_octave) beats_per_master_beat /= 2.0;
+	while(matching_speed_multiplier * beats_per_master_beat < 1.0 / half_octave) beats_per_master_beat *= 2.0;
+
+	SyncCorrection correction{matching_speed_multiplier * beats_per_master_beat, 0.0};
+	if(not (master.playing and follower_playing) or frames_per_block == 0) return correction;
+
+	//The master may have rendered ahead of or behind the follower.
+	const double frames_since_master_reading = double(std::int64_t(follower_output_frame - master.output_frame));
+	const double master_beat_position = master.beat_position + (frames_since_master_reading * master.beats_per_frame);
+	//Wrapped to the nearest beat, from half a beat behind to half a beat ahead.
+	const double beat_error = (master_beat_position * beats_per_master_beat) - follower_beat_position;
+	const double phase_error = beat_error - std::round(beat_error);
+
+	const double correction_frames = phase_error * follower_frames_per_beat * sync_phase_correction_per_block;
+	correction.phase_speed_offset = std::clamp(correction_frames / frames_per_block, -max_sync_phase_speed_offset, max_sync_phase_speed_offset);
+	return correction;
+}
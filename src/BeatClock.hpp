@@ -0,0 +1,79 @@
+/**
+\file BeatClock.hpp
+Publishing where a deck is in its beats, and locking another deck's tempo and phase to it.
+*/
+
+#ifndef BeatClock_hpp
+#define BeatClock_hpp
+
+#include <atomic>
+#include <cstdint>
+#include <optional>
+
+/**
+The beat a deck is at and how fast it moves through its beats, as of the start of the next block it renders,
+published by the render thread of the deck after every block for the decks synced to it.
+
+The reading is published and read as a whole through a sequence lock, so a reader never sees half of one reading and half of the next.
+Neither side locks or allocates; a reader only retries while a reading is being published.
+*/
+class BeatClock{
+	public:
+	struct Reading{
+		/**
+		The frame of the output devices the reading is at, counting every frame the deck rendered and the Mixer concealed,
+		so readings of decks rendered at different times can be compared.
+		*/
+		std::uint64_t output_frame;
+		double beat_position;
+		///The tempo of the track at the playhead times the speed of the deck, in beats per stdaud frame of output.
+		double beats_per_frame;
+		///Whether the deck is moving through its beats at BeatClock::Reading::beats_per_frame, rather than paused.
+		bool playing;
+	};
+
+	///Publishes *reading*. Only called from the render thread of the deck.
+	void publish(const Reading& reading) noexcept;
+	///Publishes that the track of the deck has no beats to sync to. Only called from the render thread of the deck.
+	void publish_no_beats() noexcept;
+	///The last reading published, std::nullopt if none was or the track has no beats.
+	std::optional<Reading> read() const noexcept;
+
+	private:
+	///Odd while a reading is being published.
+	std::atomic<std::uint32_t> sequence = 0;
+	std::atomic_bool has_beats = false;
+	std::atomic<std::uint64_t> output_frame = 0;
+	std::atomic<double> beat_position = 0.0;
+	std::atomic<double> beats_per_frame = 0.0;
+	std::atomic_bool playing = false;
+};
+
+///How a deck synced to another plays its next block.
+struct SyncCorrection{
+	///The speed multiplier which plays the follower at the tempo of the master.
+	double destination_speed_multiplier;
+	///Added to the speed of the follower for one block only, to pull its beats towards the beats of the master.
+	double phase_speed_offset;
+};
+
+///The phase error a synced deck removes every block, as a ratio of the error.
+inline constexpr double sync_phase_correction_per_block = 0.5;
+///The largest speed change a synced deck makes to correct its phase, so a large error is corrected over several blocks instead of audibly jumping.
+inline constexpr double max_sync_phase_speed_offset = 0.1;
+
+/**
+The correction for a follower deck starting a block of *frames_per_block* frames at *follower_output_frame*, on *follower_beat_position*
+with *follower_frames_per_beat* frames per beat, to lock it to *master*:
+its tempo matches the master, and unless either deck is paused its beats are pulled into phase with the beats of the master, as extrapolated to the block.
+
+A follower more than half or double the tempo of the master is matched to half or double the tempo instead, as a DJ would,
+and locked to every other beat of the faster deck.
+Only the position within the beat is matched, so the decks stay locked through loops of whole beats on either deck.
+
+Returns std::nullopt if the master is not moving through its beats at all.
+*/
+std::optional<SyncCorrection> get_sync_correction(const BeatClock::Reading& master, const std::uint64_t follower_output_frame, const double follower_beat_position,
+									const double follower_frames_per_beat, const bool follower_playing, const std::uint32_t frames_per_block) noexcept;
+
+#endif
@@ -0,0 +1,107 @@
+#include "BeatGrid.hpp"
+
+#include "ntrb/aud_std_fmt.h"
+
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+BeatGrid::BeatGrid(const double first_beat_frame, const double bpm)
+:	BeatGrid(std::vector<Segment>{Segment{first_beat_frame, (60.0 * ntrb_std_samplerate) / bpm}})
+{
+}
+
+BeatGrid::BeatGrid(std::vector<Segment> segments)
+:	segments(std::move(segments))
+{
+	if(this->segments.empty())
+		throw std::invalid_argument("BeatGrid: no segments.");
+
+	for(std::size_t i = 0; i < this->segments.size(); i++){
+		if(not (this->segments[i].frames_per_beat > 0.0) or not std::isfinite(this->segments[i].frames_per_beat))
+			throw std::invalid_argument("BeatGrid: segment without a positive tempo.");
+		if(i > 0 and this->segments[i].first_beat_frame <= this->segments[i-1].first_beat_frame)
+			throw std::invalid_argument("BeatGrid: segments not sorted.");
+	}
+
+	//Every segment but the last holds a whole number of beats, its tempo is adjusted to fit them, so the first beat of every segment is a beat.
+	this->segment_first_beat_positions.reserve(this->segments.size());
+	double first_beat_position = 0.0;
+	for(std::size_t i = 0; i < this->segments.size(); i++){
+		this->segment_first_beat_positions.push_back(first_beat_position);
+		if(i + 1 == this->segments.size()) break;
+
+		Segment& segment = this->segments[i];
+		const double segment_frames = this->segments[i+1].first_beat_frame - segment.first_beat_frame;
+		const double segment_beats = std::max(1.0, std::round(segment_frames / segment.frames_per_beat));
+		segment.frames_per_beat = segment_frames / segment_beats;
+		first_beat_position += segment_beats;
+	}
+}
+
+std::size_t BeatGrid::find_segment_at_frame(const double frame) const noexcept{
+	const auto after = std::upper_bound(this->segments.begin(), this->segments.end(), frame, [](const double frame, const Segment& segment){
+		return frame < segment.first_beat_frame;
+	});
+	return after == this->segments.begin() ? 0 : (after - this->segments.begin()) - 1;
+}
+
+std::size_t BeatGrid::find_segment_at_beat_position(const double beat_position) const noexcept{
+	const auto after = std::upper_bound(this->segment_first_beat_positions.begin(), this->segment_first_beat_positions.end(), beat_position);
+	return after == this->segment_first_beat_positions.begin() ? 0 : (after - this->segment_first_beat_positions.begin()) - 1;
+}
+
+double BeatGrid::get_beat_position(const double frame) const noexcept{
+	const std::size_t segment_index = this->find_segment_at_frame(frame);
+	const Segment& segment = this->segments[segment_index];
+	return this->segment_first_beat_positions[segment_index] + ((frame - segment.first_beat_frame) / segment.frames_per_beat);
+}
+
+double BeatGrid::get_frame_at_beat_position(const double beat_position) const noexcept{
+	const std::size_t segment_index = this->find_segment_at_beat_position(beat_position);
+	const Segment& segment = this->segments[segment_index];
+	return segment.first_beat_frame + ((beat_position - this->segment_first_beat_positions[segment_index]) * segment.frames_per_beat);
+}
+
+double BeatGrid::get_frames_per_beat(const double frame) const noexcept{
+	if(this->empty()) return 0.0;
+	return this->segments[this->find_segment_at_frame(frame)].frames_per_beat;
+}
+
+double BeatGrid::get_bpm(const double frame) const noexcept{
+	if(this->empty()) return 0.0;
+	return (60.0 * ntrb_std_samplerate) / this->get_frames_per_beat(frame);
+}
+
+std::int64_t BeatGrid::get_beat_index_at_or_before(const double frame) const noexcept{
+	std::int64_t beat_index = std::floor(this->get_beat_position(frame));
+	//The division may land just either side of a whole beat which the frame is exactly on.
+	if(this->get_frame_at_beat_position(beat_index + 1) <= frame) beat_index++;
+	else if(this->get_frame_at_beat_position(beat_index) > frame) beat_index--;
+	return beat_index;
+}
+
+std::optional<double> BeatGrid::get_beat_at_or_before(const double frame) const noexcept{
+	if(this->empty()) return std::nullopt;
+	return this->get_frame_at_beat_position(this->get_beat_index_at_or_before(frame));
+}
+
+std::optional<double> BeatGrid::get_beat_before(const double frame) const noexcept{
+	if(this->empty()) return std::nullopt;
+	std::int64_t beat_index = this->get_beat_index_at_or_before(frame);
+	if(this->get_frame_at_beat_position(beat_index) == frame) beat_index--;
+	return this->get_frame_at_beat_position(beat_index);
+}
+
+std::optional<double> BeatGrid::get_beat_after(const double frame) const noexcept{
+	if(this->empty()) return std::nullopt;
+	return this->get_frame_at_beat_position(this->get_beat_index_at_or_before(frame) + 1);
+}
+
+std::optional<double> BeatGrid::get_nearest_beat(const double frame) const noexcept{
+	if(this->empty()) return std::nullopt;
+	const std::int64_t beat_index = this->get_beat_index_at_or_before(frame);
+	const double earlier_beat = this->get_frame_at_beat_position(beat_index);
+	const double later_beat = this->get_frame_at_beat_position(beat_index + 1);
+	return (frame - earlier_beat) <= (later_beat - frame) ? earlier_beat : later_beat;
+}
@@ -0,0 +1,81 @@
+/**
+\file BeatGrid.hpp
+*/
+
+#ifndef BeatGrid_hpp
+#define BeatGrid_hpp
+
+#include <vector>
+#include <cstdint>
+#include <optional>
+
+/**
+The beats of a track, as one or more segments of constant tempo, looked up in double precision without walking from the first beat.
+
+Beats are numbered by their beat position, 0 being the first beat of the track and fractions lying in between beats.
+Every segment continues counting from the beat position the previous segment reached at its start,
+and the first segment extends before the first beat with negative beat positions.
+
+A BeatGrid is never changed after construction, so it can be read from any thread.
+*/
+class BeatGrid{
+	public:
+	///A part of the track with a constant tempo.
+	struct Segment{
+		///The stdaud frame of the first beat of the segment.
+		double first_beat_frame;
+		double frames_per_beat;
+	};
+
+	///A grid without beats, for tracks with no bpm.
+	BeatGrid() = default;
+	///A grid with a constant tempo of *bpm*, with the first beat at *first_beat_frame*.
+	BeatGrid(const double first_beat_frame, const double bpm);
+	/**
+	A grid changing tempo at the first beat of every segment.
+	The tempo of every segment but the last is adjusted to the nearest which fits a whole number of beats before the next segment.
+
+	Throws std::invalid_argument if *segments* is empty, not sorted by their first beats, or has a segment without a positive tempo.
+	*/
+	explicit BeatGrid(std::vector<Segment> segments);
+
+	bool empty() const noexcept{
+		return this->segments.empty();
+	}
+	const std::vector<Segment>& get_segments() const noexcept{
+		return this->segments;
+	}
+
+	///The beat position of stdaud frame *frame*. Must not be called on an empty grid.
+	double get_beat_position(const double frame) const noexcept;
+	///The stdaud frame of *beat_position*. Must not be called on an empty grid.
+	double get_frame_at_beat_position(const double beat_position) const noexcept;
+
+	///The tempo at *frame* as frames per beat, 0 on an empty grid.
+	double get_frames_per_beat(const double frame) const noexcept;
+	///The tempo at *frame* in beats per minute, 0 on an empty grid.
+	double get_bpm(const double frame) const noexcept;
+
+	///The last beat at or before *frame*, std::nullopt on an empty grid.
+	std::optional<double> get_beat_at_or_before(const double frame) const noexcept;
+	///The last beat before *frame*, std::nullopt on an empty grid.
+	std::optional<double> get_beat_before(const double frame) const noexcept;
+	///The first beat after *frame*, std::nullopt on an empty grid.
+	std::optional<double> get_beat_after(const double frame) const noexcept;
+	///The beat nearest to *frame*, the earlier one if *frame* is halfway in between, std::nullopt on an empty grid.
+	std::optional<double> get_nearest_beat(const double frame) const noexcept;
+
+	private:
+	///The segment holding *frame*, found with a binary search.
+	std::size_t find_segment_at_frame(const double frame) const noexcept;
+	///The segment holding *beat_position*, found with a binary search.
+	std::size_t find_segment_at_beat_position(const double beat_position) const noexcept;
+	///The whole beat at or before *frame*, corrected for the rounding of the division.
+	std::int64_t get_beat_index_at_or_before(const double frame) const noexcept;
+
+	std::vector<Segment> segments;
+	///The beat position of the first beat of every segment.
+	std::vector<double> segment_first_beat_positions;
+};
+
+#endif
@@ -13,7 +13,7 @@ void EffectContainer::clear_buffer(){
 	memset(this->echo_buffer.get(), 0, this->echo_buffer_datapoints * sizeof(float));	
 }
 
-void EffectContainer::apply_effect(std::vector<float>& samples, EffectType effect_type){
+void EffectContainer::apply_effect(const SampleSpan samples, EffectType effect_type) noexcept{
 	switch(effect_type){
 		case EffectType_None:
 		return;
@@ -30,8 +30,8 @@ void EffectContainer::apply_effect(std::vector<float>& samples, EffectType effec
 	}
 }
 
-void EffectContainer::apply_echo_effect(std::vector<float>& samples){
-	const std::size_t sample_count = samples.size();
+void EffectContainer::apply_echo_effect(const SampleSpan samples) noexcept{
+	const std::size_t sample_count = samples.size;
 	const std::size_t delay_samples = std::size_t(this->param_value) * ntrb_std_audchannels;
 	
 	for(std::size_t i = 0; i < sample_count; i++){
@@ -45,8 +45,8 @@ void EffectContainer::apply_echo_effect(std::vector<float>& samples){
 	this->current_echo_index %= this->echo_buffer_datapoints;
 }
 
-void EffectContainer::apply_low_samplerate_effect(std::vector<float>& samples){
-	const std::size_t sample_count = samples.size();
+void EffectContainer::apply_low_samplerate_effect(const SampleSpan samples) noexcept{
+	const std::size_t sample_count = samples.size;
 	const std::size_t interval = std::size_t(this->param_value) * 2;
 	
 	float duplicating_sample = samples[0];
@@ -64,7 +64,7 @@ void EffectContainer::apply_low_samplerate_effect(std::vector<float>& samples){
 	}
 }
 
-void EffectContainer::apply_bitcrush(std::vector<float>& samples){
+void EffectContainer::apply_bitcrush(const SampleSpan samples) noexcept{
 	const std::uint32_t bit_depth = this->param_value;
 	const float bit_range = (bit_depth * bit_depth) - 1;
 	for(auto& sample : samples){
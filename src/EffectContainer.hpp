@@ -1,6 +1,8 @@
 #ifndef EffectContainer_hpp
 #define EffectContainer_hpp
 
+#include "AlignedSampleBuffer.hpp"
+
 #include "ntrb/aud_std_fmt.h"
 #include <array>
 #include <vector>
@@ -24,15 +26,15 @@ class EffectContainer{
 	public:
 	EffectContainer();
 	void clear_buffer();
-	void apply_effect(std::vector<float>& samples, EffectType effect_type);
+	void apply_effect(const SampleSpan samples, EffectType effect_type) noexcept;
 
 	float effect_mix_ratio = 0.25;
 	float param_value = 1.00;
 
 	private:
-	void apply_echo_effect(std::vector<float>& samples);
-	void apply_low_samplerate_effect(std::vector<float>& samples);
-	void apply_bitcrush(std::vector<float>& samples);
+	void apply_echo_effect(const SampleSpan samples) noexcept;
+	void apply_low_samplerate_effect(const SampleSpan samples) noexcept;
+	void apply_bitcrush(const SampleSpan samples) noexcept;
 	
 	
 	const std::size_t echo_buffer_datapoints = 2 * ntrb_std_samplerate * ntrb_std_audchannels;
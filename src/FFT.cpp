@@ -0,0 +1,58 @@
+#include "FFT.hpp"
+
+#include <cmath>
+#include <utility>
+#include <stdexcept>
+
+FFT::FFT(const std::size_t size)
+:	transform_size(size)
+{
+	if(size < 2 or (size & (size - 1)) != 0)
+		throw std::invalid_argument("FFT: size is not a power of 2.");
+
+	const double pi = std::acos(-1.0);
+	this->twiddles.resize(size / 2);
+	for(std::size_t k = 0; k < size / 2; k++){
+		const double angle = -2.0 * pi * double(k) / double(size);
+		this->twiddles[k] = std::complex<float>(std::cos(angle), std::sin(angle));
+	}
+
+	std::size_t reversed = 0;
+	for(std::size_t i = 1; i < size; i++){
+		std::size_t bit = size >> 1;
+		for(; reversed & bit; bit >>= 1) reversed ^= bit;
+		reversed ^= bit;
+		if(i < reversed) this->bit_reversal_swaps.emplace_back(i, reversed);
+	}
+}
+
+void FFT::forward(std::complex<float>* const values) const noexcept{
+	this->transform(values, false);
+}
+
+void FFT::inverse(std::complex<float>* const values) const noexcept{
+	this->transform(values, true);
+	const float scale = 1.0f / float(this->transform_size);
+	for(std::size_t i = 0; i < this->transform_size; i++) values[i] *= scale;
+}
+
+void FFT::transform(std::complex<float>* const values, const bool is_inverse) const noexcept{
+	for(const std::pair<std::size_t, std::size_t>& swap : this->bit_reversal_swaps)
+		std::swap(values[swap.first], values[swap.second]);
+
+	for(std::size_t half_span = 1; half_span < this->transform_size; half_span <<= 1){
+		const std::size_t twiddle_stride = this->transform_size / (half_span * 2);
+		for(std::size_t span_begin = 0; span_begin < this->transform_size; span_begin += half_span * 2){
+			for(std::size_t k = 0; k < half_span; k++){
+				const std::complex<float> twiddle = is_inverse ? std::conj(this->twiddles[k * twiddle_stride]) : this->twiddles[k * twiddle_stride];
+				std::complex<float>& even = values[span_begin + k];
+				std::complex<float>& odd = values[span_begin + k + half_span];
+				//Written out, as std::complex multiplication checks for infinities.
+				const std::complex<float> twiddled_odd(odd.real() * twiddle.real() - odd.imag() * twiddle.imag(),
+													   odd.real() * twiddle.imag() + odd.imag() * twiddle.real());
+				odd = even - twiddled_odd;
+				even += twiddled_odd;
+			}
+		}
+	}
+}
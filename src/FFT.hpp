@@ -0,0 +1,41 @@
+/**
+\file FFT.hpp
+*/
+
+#ifndef FFT_hpp
+#define FFT_hpp
+
+#include <vector>
+#include <complex>
+#include <cstddef>
+#include <utility>
+
+/**
+An in-place radix-2 fast Fourier transform of one power of 2 size,
+with its twiddle factors and bit reversal permutation computed once at construction so they are shared by every transform.
+*/
+class FFT{
+	public:
+	///Throws std::invalid_argument if *size* is not a power of 2 of at least 2.
+	explicit FFT(const std::size_t size);
+
+	std::size_t size() const noexcept{
+		return this->transform_size;
+	}
+
+	///Transforms the FFT::size() values of *values* to the frequency domain, unscaled.
+	void forward(std::complex<float>* const values) const noexcept;
+	///Transforms the FFT::size() values of *values* back to the time domain, scaled by 1/FFT::size().
+	void inverse(std::complex<float>* const values) const noexcept;
+
+	private:
+	void transform(std::complex<float>* const values, const bool is_inverse) const noexcept;
+
+	std::size_t transform_size;
+	///e^(-2*pi*i*k/size) for the first half of the size.
+	std::vector<std::complex<float>> twiddles;
+	///Pairs of indices swapped before the butterflies.
+	std::vector<std::pair<std::size_t, std::size_t>> bit_reversal_swaps;
+};
+
+#endif
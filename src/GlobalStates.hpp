@@ -6,48 +6,99 @@
 #define GLOBALSTATES_HPP
 
 #include "AudioTrack.hpp"
+#include "UnderrunConcealer.hpp"
+#include "PcmCache.hpp"
+#include "TrackAnalysisCache.hpp"
 
 #include "ntrb/aud_std_fmt.h"
 
 #include <memory>
 #include <vector>
 #include <atomic>
+#include <chrono>
 #include <cstdint>
 
-enum AudioTrackAccess_Status : std::uint8_t{
-	AudioTrackAccess_ReadingBlocked,
-	AudioTrackAccess_ReadyForReading,
-	AudioTrackAccess_BeingRead,
-	AudioTrackAccess_FinishedReading,
-};
-
 /**
 A struct containing states and constants shared between different threads of this program,
 passed by reference to the threads.
 */
 
 struct GlobalStates{
-	GlobalStates(){
+	///\param[in] frames_per_callback The period chosen at startup, see GlobalStates::is_valid_frames_per_callback().
+	GlobalStates(const std::uint32_t frames_per_callback)
+	:	frames_per_callback(frames_per_callback)
+	{
 		this->requested_exit = false;	
 	}
 
-	static constexpr std::uint16_t msecs_per_callback = 100;
+	///The shortest period selectable at startup.
+	static constexpr std::uint32_t min_frames_per_callback = 64;
+	///The longest period selectable at startup, 200 ms.
+	static constexpr std::uint32_t max_frames_per_callback = 9600;
+	///Periods at or under this length have decks rendering 2 periods ahead instead of 1.
+	static constexpr std::uint32_t max_frames_per_callback_for_short_period = 256;
+	
+	static bool is_valid_frames_per_callback(const std::uint32_t frames_per_callback) noexcept{
+		return frames_per_callback >= min_frames_per_callback and frames_per_callback <= max_frames_per_callback;
+	}
+	///The 100 ms period used when the user does not pick one.
+	static std::uint32_t default_frames_per_callback() noexcept{
+		return ntrb_std_samplerate / 10;
+	}
+	
+	///The fewest decks selectable at startup, one for each side of the controller.
+	static constexpr std::uint8_t min_deck_count = 2;
+	///The most decks selectable at startup.
+	static constexpr std::uint8_t max_deck_count = 8;
+	
+	///The metadata of every track analysed before, shared by the decks, which are destroyed before it.
+	TrackAnalysisCache analysis_cache;
+	
+	///The decks, created at startup before any other thread runs and never added to or removed from afterwards.
 	std::vector<std::unique_ptr<AudioTrack>> audio_tracks;
 	
+	///The index in GlobalStates::audio_tracks which the left side of the controller controls.
+	std::atomic<std::uint8_t> left_controlled_deck = 0;
+	///The index in GlobalStates::audio_tracks which the right side of the controller controls.
+	std::atomic<std::uint8_t> right_controlled_deck = 1;
+	
 	//A flag used by any thread to notify the other threads to prepare for exiting as soon as possible.
 	std::atomic_bool requested_exit;
 	
+	///The crossfader position, from -1 (only the decks on the left) to 1 (only the decks on the right).
+	std::atomic<float> crossfader = 0.0;
+	///The gain applied to the master bus.
+	std::atomic<float> master_level = 1.0;
+	///Where tracks loaded from now on are decoded to in the background, see AudioTrack::set_file_to_load_from().
+	std::atomic<PcmCacheMode> pcm_cache_mode = PcmCacheMode_Off;
+	
+	///What the output device callbacks play when a deck has not rendered its block in time.
+	std::atomic<UnderrunPolicy> underrun_policy = UnderrunPolicy_Fade;
+	///The amount of times the audience output device callback found the master bus without a full callback of samples.
+	std::atomic<std::uint32_t> audience_underrun_count = 0;
+	///The amount of times the monitor output device callback found the cue bus without a full callback of samples.
+	std::atomic<std::uint32_t> monitor_underrun_count = 0;
+	
 	///A const function for accessing the GlobalStates::frames_per_callback,
 	///since C extern const is not considered as C++ const.
 	std::uint32_t get_frames_per_callback() const{
 		return this->frames_per_callback;
 	}
-
-	std::atomic_uint8_t audience_output_device_status = AudioTrackAccess_FinishedReading;
-	std::atomic_uint8_t monitor_output_device_status = AudioTrackAccess_FinishedReading;
+	std::chrono::microseconds get_callback_period() const{
+		return std::chrono::microseconds(((std::uint64_t)this->frames_per_callback * 1000000) / ntrb_std_samplerate);
+	}
+	/**
+	The amount of periods each deck keeps rendered and waiting to be played.
+	Short periods leave little time for a late render, so they are rendered 2 periods ahead.
+	*/
+	std::uint8_t get_callbacks_rendered_ahead() const{
+		if(this->frames_per_callback <= max_frames_per_callback_for_short_period)
+			return 2;
+		return 1;
+	}
 	
 	private:
-	std::uint32_t frames_per_callback = (ntrb_std_samplerate * msecs_per_callback) / 1000;
+	const std::uint32_t frames_per_callback;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,72 @@
+#include "HotCueSnippets.hpp"
+
+#include "ntrb/AudioBuffer.h"
+#include "ntrb/aud_std_fmt.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+
+HotCues get_hot_cues(const std::vector<double>& cue_points) noexcept{
+	HotCues hot_cues;
+	hot_cues.fill(no_hot_cue);
+	std::copy_n(cue_points.begin(), std::min<std::size_t>(cue_points.size(), hot_cue_count), hot_cues.begin());
+	return hot_cues;
+}
+
+std::vector<double> get_cue_points(const HotCues& hot_cues){
+	std::vector<double> cue_points(hot_cues.begin(), hot_cues.end());
+	while(not cue_points.empty() and cue_points.back() == no_hot_cue)
+		cue_points.pop_back();
+	return cue_points;
+}
+
+///Whether *hot_cue* is the frame of a hot cue which is set.
+static bool is_set(const double hot_cue) noexcept{
+	return hot_cue >= 0.0;
+}
+
+HotCueSnippets::HotCueSnippets(const std::string& filename, const HotCues& hot_cues)
+:	samples(std::count_if(hot_cues.begin(), hot_cues.end(), is_set) * frames_per_snippet * ntrb_std_audchannels)
+{
+	ntrb_AudioBuffer decoding_buffer;
+	if(ntrb_AudioBuffer_new(&decoding_buffer, filename.c_str(), frames_per_snippet) != ntrb_AudioBufferNew_OK)
+		throw std::runtime_error("HotCueSnippets: could not open " + filename + ".");
+
+	std::size_t next_sample = 0;
+	for(std::uint8_t hot_cue_index = 0; hot_cue_index < hot_cue_count; hot_cue_index++){
+		if(not is_set(hot_cues[hot_cue_index])) continue;
+
+		const std::uint64_t hot_cue_frame = hot_cues[hot_cue_index];
+		Snippet& snippet = this->snippets[hot_cue_index];
+		snippet.first_frame = hot_cue_frame > margin_frames ? hot_cue_frame - margin_frames : 0;
+		snippet.first_sample = next_sample;
+		next_sample += frames_per_snippet * ntrb_std_audchannels;
+
+		decoding_buffer.stdaud_next_buffer_first_frame = snippet.first_frame;
+		decoding_buffer.load_buffer_callback(&decoding_buffer);
+		const ntrb_AudioBufferLoad_Error load_err = decoding_buffer.load_err;
+		if(load_err != ntrb_AudioBufferLoad_OK and load_err != ntrb_AudioBufferLoad_EOF){
+			ntrb_AudioBuffer_free(&decoding_buffer);
+			throw std::runtime_error("HotCueSnippets: could not decode " + filename + ".");
+		}
+
+		//A hot cue past the end of the track has an empty snippet, and plays from the decoder as before.
+		snippet.frame_count = std::min<std::uint64_t>(decoding_buffer.monochannel_samples, frames_per_snippet);
+		std::memcpy(this->samples.data() + snippet.first_sample, decoding_buffer.datapoints, snippet.frame_count * ntrb_std_audchannels * sizeof(float));
+	}
+	ntrb_AudioBuffer_free(&decoding_buffer);
+}
+
+bool HotCueSnippets::get_span(const std::uint64_t first_frame, const std::uint64_t minimum_frames, SourceSpan& span) const noexcept{
+	for(const Snippet& snippet : this->snippets){
+		const bool holds_frames = first_frame >= snippet.first_frame and first_frame + minimum_frames <= snippet.first_frame + snippet.frame_count;
+		if(not holds_frames) continue;
+
+		span.datapoints = this->samples.data() + snippet.first_sample;
+		span.first_frame = snippet.first_frame;
+		span.frame_count = snippet.frame_count;
+		return true;
+	}
+	return false;
+}
@@ -0,0 +1,79 @@
+/**
+\file HotCueSnippets.hpp
+*/
+
+#ifndef HotCueSnippets_hpp
+#define HotCueSnippets_hpp
+
+#include "resampler.hpp"
+#include "TimeStretcher.hpp"
+#include "AlignedSampleBuffer.hpp"
+
+#include <array>
+#include <string>
+#include <cstddef>
+#include <vector>
+#include <cstdint>
+
+inline constexpr std::uint8_t hot_cue_count = 8;
+///The frame of a hot cue which is not set.
+inline constexpr double no_hot_cue = -1.0;
+
+///The frame of every hot cue of a track, no_hot_cue for those not set.
+using HotCues = std::array<double, hot_cue_count>;
+
+/**
+The hot cues kept in TrackMetadata::cue_points, which holds the frame of every hot cue in order,
+no_hot_cue for a hot cue not set and nothing for the hot cues after the last one set.
+*/
+HotCues get_hot_cues(const std::vector<double>& cue_points) noexcept;
+///*hot_cues* as kept in TrackMetadata::cue_points.
+std::vector<double> get_cue_points(const HotCues& hot_cues);
+
+/**
+The first HotCueSnippets::snippet_frames frames from every hot cue of a track, decoded on the loader thread of the deck,
+so a hot cue jump plays from memory on the very next block while the ReadAheadDecoder of the deck catches up behind it.
+
+A snippet also holds HotCueSnippets::margin_frames frames before its hot cue, so the interpolation and the time-stretcher can read there.
+Immutable once constructed, the render thread reads it without locking, and a new one is made whenever a hot cue is set or deleted.
+*/
+class HotCueSnippets{
+	public:
+	///0.5s from the hot cue, longer than the decoder takes to decode the chunk there.
+	static constexpr std::uint64_t snippet_frames = 24000;
+	static constexpr std::uint64_t margin_frames = TimeStretcher::source_frames_per_segment;
+
+	/**
+	Decodes the snippet of every hot cue set in *hot_cues* from *filename*.
+
+	Throws std::runtime_error if the file could not be opened or decoded.
+	*/
+	HotCueSnippets(const std::string& filename, const HotCues& hot_cues);
+
+	HotCueSnippets(const HotCueSnippets&) = delete;
+	HotCueSnippets& operator=(const HotCueSnippets&) = delete;
+
+	/**
+	Sets *span* to the snippet holding *minimum_frames* frames from *first_frame*, returning false if no snippet holds them.
+	A snippet cut short by the end of the track only holds the frames up to it, the decoder tells the deck where the track ends.
+	*/
+	bool get_span(const std::uint64_t first_frame, const std::uint64_t minimum_frames, SourceSpan& span) const noexcept;
+
+	private:
+	static constexpr std::uint64_t frames_per_snippet = margin_frames + snippet_frames;
+
+	struct Snippet{
+		///The frame of the track the first frame of the snippet is.
+		std::uint64_t first_frame = 0;
+		///0 for a hot cue which is not set.
+		std::uint64_t frame_count = 0;
+		///Where the snippet begins in HotCueSnippets::samples.
+		std::size_t first_sample = 0;
+	};
+
+	std::array<Snippet, hot_cue_count> snippets;
+	///HotCueSnippets::frames_per_snippet frames for every hot cue set, in the order of the hot cues.
+	AlignedSampleBuffer samples;
+};
+
+#endif
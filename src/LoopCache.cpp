@@ -0,0 +1,100 @@
+#include "LoopCache.hpp"
+
+#include "ntrb/aud_std_fmt.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+LoopCache::LoopCache()
+:	samples(capacity_frames * ntrb_std_audchannels)
+{
+}
+
+bool LoopCache::update(const double loop_begin, const double loop_end, const bool crossfade, TrackSource& source) noexcept{
+	const bool same_loop = (loop_begin == this->loop_begin) and (loop_end == this->loop_end) and (crossfade == this->crossfade);
+	if(not same_loop){
+		this->loop_begin = loop_begin;
+		this->loop_end = loop_end;
+		this->crossfade = crossfade;
+		this->complete = false;
+		this->copied_frames = 0;
+
+		const std::uint64_t loop_begin_frame = std::max(0.0, loop_begin);
+		const std::uint64_t loop_end_frame = std::max(0.0, std::ceil(loop_end));
+		this->first_frame = loop_begin_frame > margin_frames ? loop_begin_frame - margin_frames : 0;
+		this->frame_count = (loop_end_frame + margin_frames) - this->first_frame;
+		this->uncacheable = (loop_end <= loop_begin) or (this->frame_count > capacity_frames);
+	}
+	if(this->complete or this->uncacheable) return this->complete;
+
+	PcmCache* const pcm_cache = source.get_pcm_cache();
+	ReadAheadDecoder& read_ahead_decoder = source.get_read_ahead_decoder();
+	while(this->copied_frames < this->frame_count){
+		const std::uint64_t frame = this->first_frame + this->copied_frames;
+		SourceSpan span;
+		const bool span_from_pcm_cache = pcm_cache and pcm_cache->get_span(frame, 1, span);
+		//The rest is copied in later blocks, once the decoder gets to it.
+		if(not span_from_pcm_cache and not read_ahead_decoder.get_span(frame, span)) return false;
+		if(frame >= span.end_frame()){
+			//The loop runs into the end of the track, where the deck stops rather than looping.
+			this->uncacheable = true;
+			return false;
+		}
+
+		const std::uint64_t frames_to_copy = std::min(span.end_frame() - frame, this->frame_count - this->copied_frames);
+		std::memcpy(this->samples.data() + (this->copied_frames * ntrb_std_audchannels),
+					span.datapoints + ((frame - span.first_frame) * ntrb_std_audchannels),
+					frames_to_copy * ntrb_std_audchannels * sizeof(float));
+		this->copied_frames += frames_to_copy;
+	}
+
+	if(this->crossfade) this->crossfade_seam();
+	else this->unfaded_frames = this->frame_count;
+	this->complete = true;
+	return true;
+}
+
+void LoopCache::reset() noexcept{
+	this->loop_begin = -1.0;
+	this->loop_end = -1.0;
+	this->complete = false;
+	this->uncacheable = false;
+	this->copied_frames = 0;
+}
+
+bool LoopCache::get_span(const std::uint64_t first_frame, const std::uint64_t minimum_frames, const bool in_loop, SourceSpan& span) const noexcept{
+	if(not this->complete) return false;
+
+	const std::uint64_t held_frames = in_loop ? this->frame_count : this->unfaded_frames;
+	if(first_frame < this->first_frame or first_frame + minimum_frames > this->first_frame + held_frames) return false;
+
+	span.datapoints = this->samples.data();
+	span.first_frame = this->first_frame;
+	span.frame_count = held_frames;
+	return true;
+}
+
+void LoopCache::crossfade_seam() noexcept{
+	//Frames after the seam repeat the frame a whole loop earlier, to the nearest frame.
+	const std::uint64_t loop_frames = std::llround(this->loop_end - this->loop_begin);
+	//The frames faded into must be held before the loop begin.
+	const std::uint64_t fade_frames = std::min({max_crossfade_frames, loop_frames / 4, std::uint64_t(this->loop_begin) - this->first_frame});
+	const double fade_begin = (this->loop_end - this->first_frame) - fade_frames;
+	const double pi = std::acos(-1.0);
+
+	this->unfaded_frames = std::max(0.0, std::ceil(fade_begin));
+	//In order, so frames past the seam of a loop shorter than the margin repeat frames which are already faded.
+	for(std::uint64_t frame = this->unfaded_frames; frame < this->frame_count; frame++){
+		if(frame < loop_frames) continue;
+
+		const double fade_position = fade_frames > 0 ? std::clamp((frame - fade_begin) / fade_frames, 0.0, 1.0) : 1.0;
+		const float fade_out_gain = std::cos(fade_position * pi / 2.0);
+		const float fade_in_gain = std::sin(fade_position * pi / 2.0);
+
+		float* const faded_frame = this->samples.data() + (frame * ntrb_std_audchannels);
+		const float* const repeated_frame = this->samples.data() + ((frame - loop_frames) * ntrb_std_audchannels);
+		for(std::uint8_t channel = 0; channel < ntrb_std_audchannels; channel++)
+			faded_frame[channel] = (faded_frame[channel] * fade_out_gain) + (repeated_frame[channel] * fade_in_gain);
+	}
+}
@@ -0,0 +1,83 @@
+/**
+\file LoopCache.hpp
+*/
+
+#ifndef LoopCache_hpp
+#define LoopCache_hpp
+
+#include "resampler.hpp"
+#include "TrackSource.hpp"
+#include "TimeStretcher.hpp"
+#include "AlignedSampleBuffer.hpp"
+
+#include <cstdint>
+
+/**
+The frames of the loop a deck plays, copied once from its PcmCache or ReadAheadDecoder, so every pass through the loop plays from memory
+without the decoder decoding the loop again, however long or short the loop is.
+
+The copy holds the loop along with LoopCache::margin_frames frames on either side, so the interpolation and the time-stretcher can read across the seam.
+With the crossfade on, the last LoopCache::max_crossfade_frames frames of the loop are faded with equal power into the frames before the loop begin,
+which the playhead continues from after wrapping, and the frames after the loop end are the frames after the loop begin,
+so the seam is continuous whatever the audio at either end of the loop.
+
+The buffer is allocated at construction, long enough for a loop of LoopCache::max_loop_seconds. A longer loop plays from the decoder as before.
+Only accessed from the render thread of the deck, nothing allocates, locks or decodes.
+*/
+class LoopCache{
+	public:
+	static constexpr std::uint64_t max_loop_seconds = 16;
+	///Frames kept on either side of the loop, enough for a segment of the time-stretcher.
+	static constexpr std::uint64_t margin_frames = TimeStretcher::source_frames_per_segment;
+	///The length of the crossfade at the seam, 10ms, or a quarter of the loop for shorter loops.
+	static constexpr std::uint64_t max_crossfade_frames = 480;
+	static constexpr std::uint64_t capacity_frames = (max_loop_seconds * 48000) + (margin_frames * 2) + 2;
+
+	LoopCache();
+
+	LoopCache(const LoopCache&) = delete;
+	LoopCache& operator=(const LoopCache&) = delete;
+
+	/**
+	Makes the cache hold the loop from *loop_begin* to *loop_end* of *source*, crossfaded at the seam if *crossfade* is true,
+	starting over if it held another loop. Copies every frame of it which *source* has decoded and the cache is still missing.
+
+	Returns true once the whole loop is held.
+	*/
+	bool update(const double loop_begin, const double loop_end, const bool crossfade, TrackSource& source) noexcept;
+	///Forgets the loop held, as the track it was copied from is replaced.
+	void reset() noexcept;
+
+	/**
+	Sets *span* to the frames held, if the whole loop is held and they include *minimum_frames* frames from *first_frame*.
+	Unless *in_loop* is true, only frames which are the same as the track are given, so the playhead can play through the loop region
+	before the loop is entered and after it is left, but never hears the crossfade there.
+	*/
+	bool get_span(const std::uint64_t first_frame, const std::uint64_t minimum_frames, const bool in_loop, SourceSpan& span) const noexcept;
+
+	bool is_complete() const noexcept{
+		return this->complete;
+	}
+
+	private:
+	///Applies the crossfade to the frames copied, once all of them are.
+	void crossfade_seam() noexcept;
+
+	AlignedSampleBuffer samples;
+
+	double loop_begin = -1.0;
+	double loop_end = -1.0;
+	bool crossfade = false;
+	///Set if the loop cannot be cached, as it is too long or runs past the end of the track.
+	bool uncacheable = false;
+	bool complete = false;
+
+	///The frame of the track the first frame held is.
+	std::uint64_t first_frame = 0;
+	std::uint64_t frame_count = 0;
+	std::uint64_t copied_frames = 0;
+	///The frames from the first frame held which are the same as the track, before the crossfade.
+	std::uint64_t unfaded_frames = 0;
+};
+
+#endif
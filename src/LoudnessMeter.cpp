@@ -0,0 +1,91 @@
+#include "LoudnessMeter.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+///400 ms gating blocks are 4 steps of 100 ms, each block overlapping the next by 3 steps.
+static constexpr std::uint32_t steps_per_second = 10;
+static constexpr std::uint32_t steps_per_block = 4;
+static constexpr double absolute_gate_lufs = -70.0;
+static constexpr double relative_gate_lu = -10.0;
+
+static double mean_square_to_lufs(const double mean_square) noexcept{
+	return -0.691 + (10.0 * std::log10(mean_square));
+}
+
+LoudnessMeter::LoudnessMeter(const std::uint32_t samplerate)
+:	frames_per_step(samplerate / steps_per_second)
+{
+	//Designed from the analogue prototypes of the BS.1770 filters, so they are right at any samplerate and match the published 48 kHz coefficients.
+	const double pi = std::acos(-1.0);
+	{
+		constexpr double gain_db = 3.999843853973347, q = 0.7071752369554196, centre_hz = 1681.974450955533;
+		const double k = std::tan(pi * centre_hz / samplerate);
+		const double high_gain = std::pow(10.0, gain_db / 20.0);
+		const double band_gain = std::pow(high_gain, 0.4996667741545416);
+		const double a0 = 1.0 + (k / q) + (k * k);
+		this->head_shelf.b0 = (high_gain + (band_gain * k / q) + (k * k)) / a0;
+		this->head_shelf.b1 = 2.0 * ((k * k) - high_gain) / a0;
+		this->head_shelf.b2 = (high_gain - (band_gain * k / q) + (k * k)) / a0;
+		this->head_shelf.a1 = 2.0 * ((k * k) - 1.0) / a0;
+		this->head_shelf.a2 = (1.0 - (k / q) + (k * k)) / a0;
+	}
+	{
+		constexpr double q = 0.5003270373238773, cutoff_hz = 38.13547087602444;
+		const double k = std::tan(pi * cutoff_hz / samplerate);
+		const double a0 = 1.0 + (k / q) + (k * k);
+		//Left unnormalised, as the published coefficients are.
+		this->high_pass.b0 = 1.0;
+		this->high_pass.b1 = -2.0;
+		this->high_pass.b2 = 1.0;
+		this->high_pass.a1 = 2.0 * ((k * k) - 1.0) / a0;
+		this->high_pass.a2 = (1.0 - (k / q) + (k * k)) / a0;
+	}
+}
+
+void LoudnessMeter::push_frames(const float* const stdaud_frames, const std::uint64_t frame_count) noexcept{
+	for(std::uint64_t frame = 0; frame < frame_count; frame++){
+		for(std::uint8_t channel = 0; channel < 2; channel++){
+			const double weighted = this->high_pass.process(this->head_shelf.process(stdaud_frames[(frame * 2) + channel], channel), channel);
+			this->step_square_sum += weighted * weighted;
+		}
+
+		this->step_frames++;
+		if(this->step_frames == this->frames_per_step){
+			this->step_mean_squares.push_back(this->step_square_sum / this->frames_per_step);
+			this->step_square_sum = 0.0;
+			this->step_frames = 0;
+		}
+	}
+}
+
+std::optional<double> LoudnessMeter::get_integrated_loudness() const{
+	if(this->step_mean_squares.size() < steps_per_block) return std::nullopt;
+
+	std::vector<double> block_mean_squares;
+	block_mean_squares.reserve(this->step_mean_squares.size());
+	for(std::size_t first_step = 0; first_step + steps_per_block <= this->step_mean_squares.size(); first_step++){
+		double block_sum = 0.0;
+		for(std::size_t step = first_step; step < first_step + steps_per_block; step++) block_sum += this->step_mean_squares[step];
+		block_mean_squares.push_back(block_sum / steps_per_block);
+	}
+
+	const auto gated_mean = [&block_mean_squares](const double gate_lufs) -> std::optional<double>{
+		double sum = 0.0;
+		std::size_t count = 0;
+		for(const double mean_square : block_mean_squares){
+			if(mean_square > 0.0 and mean_square_to_lufs(mean_square) > gate_lufs){
+				sum += mean_square;
+				count++;
+			}
+		}
+		if(count == 0) return std::nullopt;
+		return sum / count;
+	};
+
+	const std::optional<double> absolute_gated_mean = gated_mean(absolute_gate_lufs);
+	if(not absolute_gated_mean.has_value()) return std::nullopt;
+	const std::optional<double> relative_gated_mean = gated_mean(std::max(absolute_gate_lufs, mean_square_to_lufs(absolute_gated_mean.value()) + relative_gate_lu));
+	if(not relative_gated_mean.has_value()) return std::nullopt;
+	return mean_square_to_lufs(relative_gated_mean.value());
+}
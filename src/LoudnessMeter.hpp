@@ -0,0 +1,57 @@
+/**
+\file LoudnessMeter.hpp
+*/
+
+#ifndef LoudnessMeter_hpp
+#define LoudnessMeter_hpp
+
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <optional>
+
+/**
+Measures the integrated loudness of stdaud frames pushed in order, as ITU-R BS.1770 / EBU R128 define it:
+K-weighted mean square power of both channels over 400 ms blocks overlapping by 75%,
+averaged over the blocks above an absolute gate of -70 LUFS and a relative gate 10 LU below the loudness of those.
+
+Only the mean square of every 100 ms is kept, so a track of any length is measured in little memory.
+*/
+class LoudnessMeter{
+	public:
+	///*samplerate* is the samplerate of the stdaud frames pushed.
+	explicit LoudnessMeter(const std::uint32_t samplerate);
+
+	///Pushes the next *frame_count* interleaved stereo stdaud frames of the track.
+	void push_frames(const float* const stdaud_frames, const std::uint64_t frame_count) noexcept;
+
+	///The integrated loudness in LUFS of the frames pushed, std::nullopt if every block is gated out, as silence is.
+	std::optional<double> get_integrated_loudness() const;
+
+	private:
+	///A biquad filter in transposed direct form II, with the state of both channels.
+	struct Biquad{
+		double b0, b1, b2, a1, a2;
+		std::array<double, 2> z1{}, z2{};
+
+		double process(const double input, const std::uint8_t channel) noexcept{
+			const double output = (this->b0 * input) + this->z1[channel];
+			this->z1[channel] = (this->b1 * input) - (this->a1 * output) + this->z2[channel];
+			this->z2[channel] = (this->b2 * input) - (this->a2 * output);
+			return output;
+		}
+	};
+
+	///The first stage of the K-weighting, a high shelf modelling the head.
+	Biquad head_shelf;
+	///The second stage of the K-weighting, the RLB high pass.
+	Biquad high_pass;
+
+	const std::uint32_t frames_per_step;
+	double step_square_sum = 0.0;
+	std::uint32_t step_frames = 0;
+	///The K-weighted mean square of both channels summed, of every complete 100 ms step.
+	std::vector<float> step_mean_squares;
+};
+
+#endif
@@ -0,0 +1,90 @@
+#include "Mixer.hpp"
+#include "NoAllocationScope.hpp"
+
+#include <algorithm>
+
+Mixer::Mixer(GlobalStates& global_states)
+:	global_states(global_states),
+	samples_per_block(global_states.get_frames_per_callback() * ntrb_std_audchannels),
+	deck_underrun_concealers(global_states.audio_tracks.size(), UnderrunConcealer(this->samples_per_block)),
+	deck_samples(),
+	master_inputs(global_states.audio_tracks.size()),
+	master_left_gains(global_states.audio_tracks.size()),
+	master_right_gains(global_states.audio_tracks.size()),
+	cue_inputs(global_states.audio_tracks.size()),
+	cue_gains(global_states.audio_tracks.size()),
+	master_samples(this->samples_per_block),
+	cue_samples(this->samples_per_block),
+	master_ring(this->samples_per_block * (global_states.get_callbacks_rendered_ahead() + spare_callbacks_per_bus_ring)),
+	cue_ring(this->samples_per_block * (global_states.get_callbacks_rendered_ahead() + spare_callbacks_per_bus_ring))
+{
+	this->deck_samples.reserve(global_states.audio_tracks.size());
+	for(std::size_t deck_index = 0; deck_index < global_states.audio_tracks.size(); deck_index++)
+		this->deck_samples.emplace_back(this->samples_per_block);
+}
+
+bool Mixer::render_block() noexcept{
+	NoAllocationScope no_allocation("Mixer::render_block()");
+	if(not this->needs_rendering())
+		return false;
+
+	const bool master_ring_running_dry = this->master_ring.readable_samples() < this->samples_per_block;
+	if(not (master_ring_running_dry or this->every_deck_has_block_ready()))
+		return false;
+
+	const UnderrunPolicy underrun_policy = this->global_states.underrun_policy.load();
+	const float crossfader_position = this->global_states.crossfader.load();
+	const float master_level = this->global_states.master_level.load();
+	const std::size_t frames_per_block = this->samples_per_block / ntrb_std_audchannels;
+	std::size_t cue_input_count = 0;
+
+	for(std::size_t deck_index = 0; deck_index < this->global_states.audio_tracks.size(); deck_index++){
+		const std::unique_ptr<AudioTrack>& deck = this->global_states.audio_tracks[deck_index];
+		float* const deck_block = this->deck_samples[deck_index].data();
+
+		const std::size_t concealed_samples = this->deck_underrun_concealers[deck_index].read(deck->get_output_ring(), deck_block, this->samples_per_block, underrun_policy);
+		if(concealed_samples > 0)
+			deck->report_underrun(concealed_samples / ntrb_std_audchannels);
+
+		const float deck_gain = deck->gain.load();
+		//Even decks are on the left of the crossfader, odd decks on the right.
+		const float master_gain = deck_gain * crossfader_gain(crossfader_position, deck_index % 2 == 0) * master_level;
+		this->master_inputs[deck_index] = deck_block;
+		this->master_left_gains[deck_index] = master_gain;
+		this->master_right_gains[deck_index] = master_gain;
+
+		if(deck->output_to_monitor.load()){
+			this->cue_inputs[cue_input_count] = deck_block;
+			this->cue_gains[cue_input_count] = deck_gain;
+			cue_input_count++;
+		}
+	}
+
+	mix_stereo_buffers(this->master_samples.data(), this->master_inputs.data(), this->master_left_gains.data(), this->master_right_gains.data(), 
+						this->global_states.audio_tracks.size(), frames_per_block);
+	mix_stereo_buffers(this->cue_samples.data(), this->cue_inputs.data(), this->cue_gains.data(), this->cue_gains.data(), 
+						cue_input_count, frames_per_block);
+
+	this->master_ring.write(this->master_samples.data(), this->samples_per_block);
+	//The cue ring is not drained without a monitor output device, a full ring just drops the block.
+	this->cue_ring.write(this->cue_samples.data(), this->samples_per_block);
+	return true;
+}
+
+float Mixer::crossfader_gain(const float crossfader_position, const bool deck_on_left_side) noexcept{
+	if(deck_on_left_side)
+		return std::clamp(1.0f - crossfader_position, 0.0f, 1.0f);
+	return std::clamp(1.0f + crossfader_position, 0.0f, 1.0f);
+}
+
+bool Mixer::needs_rendering() const noexcept{
+	return this->master_ring.readable_samples() < this->samples_per_block * this->global_states.get_callbacks_rendered_ahead();
+}
+
+bool Mixer::every_deck_has_block_ready() const noexcept{
+	for(const std::unique_ptr<AudioTrack>& deck : this->global_states.audio_tracks){
+		if(deck->get_output_ring().readable_samples() < this->samples_per_block)
+			return false;
+	}
+	return true;
+}
@@ -0,0 +1,95 @@
+/**
+\file Mixer.hpp
+*/
+
+#ifndef Mixer_hpp
+#define Mixer_hpp
+
+#include "GlobalStates.hpp"
+#include "SampleRing.hpp"
+#include "mix_kernel.hpp"
+#include "UnderrunConcealer.hpp"
+#include "AlignedSampleBuffer.hpp"
+
+#include <vector>
+#include <cstdint>
+
+/**
+The mixing stage between the decks and the output devices.
+
+Every block, the Mixer drains one block from the output ring of each deck exactly once,
+sums the master bus (every deck, after AudioTrack::gain, the crossfader and GlobalStates::master_level)
+and the cue bus (decks with AudioTrack::output_to_monitor set, after AudioTrack::gain only) with mix_stereo_buffers(),
+and publishes both buses to their own SampleRing.
+The audience output device callback copies from the master ring and the monitor output device callback from the cue ring,
+so adding an output device does not add any mixing work.
+
+Mixer::render_block() is meant to be called from a single RenderWorker.
+*/
+class Mixer{
+	public:
+	///Allocates every bus, ring and scratch buffer for the decks already in *global_states*, Mixer::render_block() does not allocate.
+	Mixer(GlobalStates& global_states);
+
+	Mixer(const Mixer&) = delete;
+	Mixer& operator=(const Mixer&) = delete;
+
+	/**
+	Mixes a block from every deck into the master and cue buses, if the master ring is running low.
+
+	The Mixer waits for every deck to have a block ready, unless the master ring is about to run dry,
+	in which case the late decks are concealed with GlobalStates::underrun_policy and counted as an underrun of the deck.
+
+	Returns false if no block was mixed.
+	*/
+	bool render_block() noexcept;
+
+	///Returns true if the master ring has less than GlobalStates::get_callbacks_rendered_ahead() blocks waiting to be played.
+	bool needs_rendering() const noexcept;
+
+	///The ring which the audience output device callback copies from.
+	SampleRing& get_master_ring() noexcept{
+		return this->master_ring;
+	}
+	///The ring which the monitor output device callback copies from.
+	SampleRing& get_cue_ring() noexcept{
+		return this->cue_ring;
+	}
+
+	/**
+	The gain the crossfader at *crossfader_position* applies to a deck on the left (*deck_on_left_side*) or the right side.
+	
+	*crossfader_position* ranges from -1 (only the left side) to 1 (only the right side).
+	Both sides are at full gain in the centre, so moving the crossfader away from the centre only fades out the far side.
+	*/
+	static float crossfader_gain(const float crossfader_position, const bool deck_on_left_side) noexcept;
+
+	private:
+	bool every_deck_has_block_ready() const noexcept;
+
+	GlobalStates& global_states;
+	const std::size_t samples_per_block;
+
+	///One UnderrunConcealer for each deck, indexed the same as GlobalStates::audio_tracks.
+	std::vector<UnderrunConcealer> deck_underrun_concealers;
+
+	///The block drained from each deck, indexed the same as GlobalStates::audio_tracks.
+	std::vector<AlignedSampleBuffer> deck_samples;
+	std::vector<const float*> master_inputs;
+	std::vector<float> master_left_gains;
+	std::vector<float> master_right_gains;
+	std::vector<const float*> cue_inputs;
+	std::vector<float> cue_gains;
+
+	AlignedSampleBuffer master_samples;
+	AlignedSampleBuffer cue_samples;
+
+	SampleRing master_ring;
+	SampleRing cue_ring;
+
+	///The amount of callbacks worth of samples each bus ring holds on top of GlobalStates::get_callbacks_rendered_ahead(),
+	///leaving headroom for the monitor device drifting from the audience device.
+	static constexpr std::uint8_t spare_callbacks_per_bus_ring = 3;
+};
+
+#endif
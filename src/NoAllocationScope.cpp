@@ -0,0 +1,103 @@
+#include "NoAllocationScope.hpp"
+
+#ifdef ARDCONT_ALLOC_DEBUG
+
+#include <new>
+#include <cstdio>
+#include <cstdlib>
+
+///The innermost NoAllocationScope the thread is in, nullptr outside of any.
+static thread_local const char* current_scope_name = nullptr;
+
+NoAllocationScope::NoAllocationScope(const char* const scope_name) noexcept
+:	outer_scope_name(current_scope_name)
+{
+	current_scope_name = scope_name;
+}
+
+NoAllocationScope::~NoAllocationScope() noexcept{
+	current_scope_name = this->outer_scope_name;
+}
+
+static void check_allocation_allowed(const std::size_t size) noexcept{
+	if(current_scope_name == nullptr) return;
+	std::fprintf(stderr, "ARDCONT_ALLOC_DEBUG: %zu byte heap allocation in %s\n", size, current_scope_name);
+	std::abort();
+}
+
+static void* checked_allocate(const std::size_t size){
+	check_allocation_allowed(size);
+	void* const allocated = std::malloc(size ? size : 1);
+	if(allocated == nullptr) throw std::bad_alloc();
+	return allocated;
+}
+
+static void* checked_aligned_allocate(const std::size_t size, const std::align_val_t alignment){
+	check_allocation_allowed(size);
+	//aligned_alloc() requires the size to be a multiple of the alignment.
+	const std::size_t alignment_bytes = static_cast<std::size_t>(alignment);
+	const std::size_t rounded_size = ((size ? size : 1) + alignment_bytes - 1) & ~(alignment_bytes - 1);
+	#ifdef _WIN32
+	void* const allocated = _aligned_malloc(rounded_size, alignment_bytes);
+	#else
+	void* const allocated = std::aligned_alloc(alignment_bytes, rounded_size);
+	#endif
+	if(allocated == nullptr) throw std::bad_alloc();
+	return allocated;
+}
+
+static void checked_aligned_free(void* const allocated) noexcept{
+	#ifdef _WIN32
+	_aligned_free(allocated);
+	#else
+	std::free(allocated);
+	#endif
+}
+
+void* operator new(const std::size_t size){
+	return checked_allocate(size);
+}
+void* operator new[](const std::size_t size){
+	return checked_allocate(size);
+}
+void* operator new(const std::size_t size, const std::nothrow_t&) noexcept{
+	try{ return checked_allocate(size); }
+	catch(...){ return nullptr; }
+}
+void* operator new[](const std::size_t size, const std::nothrow_t&) noexcept{
+	try{ return checked_allocate(size); }
+	catch(...){ return nullptr; }
+}
+void* operator new(const std::size_t size, const std::align_val_t alignment){
+	return checked_aligned_allocate(size, alignment);
+}
+void* operator new[](const std::size_t size, const std::align_val_t alignment){
+	return checked_aligned_allocate(size, alignment);
+}
+
+void operator delete(void* const allocated) noexcept{
+	std::free(allocated);
+}
+void operator delete[](void* const allocated) noexcept{
+	std::free(allocated);
+}
+void operator delete(void* const allocated, std::size_t) noexcept{
+	std::free(allocated);
+}
+void operator delete[](void* const allocated, std::size_t) noexcept{
+	std::free(allocated);
+}
+void operator delete(void* const allocated, const std::align_val_t) noexcept{
+	checked_aligned_free(allocated);
+}
+void operator delete[](void* const allocated, const std::align_val_t) noexcept{
+	checked_aligned_free(allocated);
+}
+void operator delete(void* const allocated, std::size_t, const std::align_val_t) noexcept{
+	checked_aligned_free(allocated);
+}
+void operator delete[](void* const allocated, std::size_t, const std::align_val_t) noexcept{
+	checked_aligned_free(allocated);
+}
+
+#endif
@@ -0,0 +1,40 @@
+/**
+\file NoAllocationScope.hpp
+A debug check that the real-time render path never allocates from the heap.
+*/
+
+#ifndef NoAllocationScope_hpp
+#define NoAllocationScope_hpp
+
+/**
+Marks the lifetime of the object as a region of the current thread which must not allocate from the heap,
+such as AudioTrack::load_samples(), the effects and the output device callback.
+
+When built with ARDCONT_ALLOC_DEBUG defined (make ALLOC_DEBUG=1), the global operator new is replaced,
+and any allocation on a thread inside a NoAllocationScope prints the name of the innermost scope and aborts.
+Otherwise a NoAllocationScope does nothing and costs nothing.
+
+Only allocations through operator new are caught, not ones the C libraries make with malloc().
+*/
+class NoAllocationScope{
+	public:
+	///\param[in] scope_name A string literal naming the region, printed if it allocates.
+	NoAllocationScope(const char* const scope_name) noexcept;
+	~NoAllocationScope() noexcept;
+
+	NoAllocationScope(const NoAllocationScope&) = delete;
+	NoAllocationScope& operator=(const NoAllocationScope&) = delete;
+
+	#ifdef ARDCONT_ALLOC_DEBUG
+	private:
+	///The scope the thread was in before this one, restored on destruction.
+	const char* const outer_scope_name;
+	#endif
+};
+
+#ifndef ARDCONT_ALLOC_DEBUG
+inline NoAllocationScope::NoAllocationScope(const char* const) noexcept{}
+inline NoAllocationScope::~NoAllocationScope() noexcept{}
+#endif
+
+#endif
@@ -0,0 +1,68 @@
+#include "OnsetDetector.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+///How strongly magnitudes are log compressed, so quiet onsets count next to loud ones.
+static constexpr float log_compression = 1000.0;
+
+OnsetDetector::OnsetDetector(const std::uint32_t samplerate)
+:	samplerate(samplerate),
+	fft(window_frames),
+	hann_window(window_frames),
+	mono_window(window_frames, 0.0),
+	//The first window is padded with silence before the track, so it is centred on frame 0.
+	mono_window_samples(window_frames - hop_frames),
+	spectrum(window_frames),
+	previous_log_magnitudes(window_frames / 2, 0.0)
+{
+	const double pi = std::acos(-1.0);
+	double window_sum = 0.0;
+	for(std::uint32_t frame = 0; frame < window_frames; frame++){
+		this->hann_window[frame] = 0.5 - (0.5 * std::cos(2.0 * pi * frame / window_frames));
+		window_sum += this->hann_window[frame];
+	}
+	//Scaled so a full scale sine has a magnitude of about 0.5 regardless of the window size.
+	for(float& window_value : this->hann_window) window_value /= window_sum;
+
+	this->low_band_bins = std::max<std::uint32_t>(1, low_band_max_hz * window_frames / samplerate);
+}
+
+void OnsetDetector::push_frames(const float* const stdaud_frames, const std::uint64_t frame_count){
+	std::uint64_t frame = 0;
+	while(frame < frame_count){
+		const std::uint64_t frames_to_copy = std::min<std::uint64_t>(frame_count - frame, window_frames - this->mono_window_samples);
+		for(std::uint64_t i = 0; i < frames_to_copy; i++){
+			const float* const stdaud_frame = stdaud_frames + ((frame + i) * 2);
+			this->mono_window[this->mono_window_samples + i] = 0.5f * (stdaud_frame[0] + stdaud_frame[1]);
+		}
+		frame += frames_to_copy;
+		this->mono_window_samples += frames_to_copy;
+
+		if(this->mono_window_samples == window_frames){
+			this->analyse_window();
+			std::copy(this->mono_window.begin() + hop_frames, this->mono_window.end(), this->mono_window.begin());
+			this->mono_window_samples -= hop_frames;
+		}
+	}
+}
+
+void OnsetDetector::analyse_window() noexcept{
+	for(std::uint32_t frame = 0; frame < window_frames; frame++)
+		this->spectrum[frame] = std::complex<float>(this->mono_window[frame] * this->hann_window[frame], 0.0f);
+	this->fft.forward(this->spectrum.data());
+
+	float flux = 0.0;
+	float low_band_flux = 0.0;
+	//The DC bin is left out, it holds no onsets.
+	for(std::uint32_t bin = 1; bin < window_frames / 2; bin++){
+		const float log_magnitude = std::log1p(log_compression * std::sqrt(std::norm(this->spectrum[bin])));
+		const float increase = std::max(0.0f, log_magnitude - this->previous_log_magnitudes[bin]);
+		this->previous_log_magnitudes[bin] = log_magnitude;
+
+		flux += increase;
+		if(bin <= this->low_band_bins) low_band_flux += increase;
+	}
+	this->onset_strengths.push_back(flux);
+	this->low_band_onset_strengths.push_back(low_band_flux);
+}
@@ -0,0 +1,72 @@
+/**
+\file OnsetDetector.hpp
+*/
+
+#ifndef OnsetDetector_hpp
+#define OnsetDetector_hpp
+
+#include "FFT.hpp"
+
+#include <vector>
+#include <complex>
+#include <cstdint>
+
+/**
+Turns stdaud frames pushed in order into an onset detection function, how strongly new notes or hits begin over time,
+which the tempo and the beats of a track are estimated from, see estimate_beats().
+
+The frames are downmixed to mono and cut into Hann windowed frames of OnsetDetector::window_frames frames,
+one every OnsetDetector::hop_frames frames. The onset strength of a window is its spectral flux:
+the sum of the increases of its log compressed magnitude spectrum from the previous window.
+A second onset strength only sums the bins below OnsetDetector::low_band_max_hz, where kick drums mark the downbeats.
+
+Onset strength *i* is centred on stdaud frame *i* * OnsetDetector::hop_frames.
+*/
+class OnsetDetector{
+	public:
+	static constexpr std::uint32_t window_frames = 1024;
+	static constexpr std::uint32_t hop_frames = window_frames / 2;
+	static constexpr double low_band_max_hz = 200.0;
+
+	///*samplerate* is the samplerate of the stdaud frames pushed.
+	explicit OnsetDetector(const std::uint32_t samplerate);
+
+	///Pushes the next *frame_count* interleaved stereo stdaud frames of the track.
+	void push_frames(const float* const stdaud_frames, const std::uint64_t frame_count);
+
+	const std::vector<float>& get_onset_strengths() const noexcept{
+		return this->onset_strengths;
+	}
+	const std::vector<float>& get_low_band_onset_strengths() const noexcept{
+		return this->low_band_onset_strengths;
+	}
+	///The amount of onset strengths per second.
+	double get_onset_rate() const noexcept{
+		return double(this->samplerate) / hop_frames;
+	}
+	std::uint32_t get_samplerate() const noexcept{
+		return this->samplerate;
+	}
+
+	private:
+	///Appends the onset strengths of the full window in OnsetDetector::mono_window.
+	void analyse_window() noexcept;
+
+	const std::uint32_t samplerate;
+	const FFT fft;
+	std::vector<float> hann_window;
+	///The frequency bins summed into the low band onset strengths, from bin 1.
+	std::uint32_t low_band_bins;
+
+	///The mono samples of the current window, filled up to OnsetDetector::mono_window_samples.
+	std::vector<float> mono_window;
+	std::uint32_t mono_window_samples;
+	std::vector<std::complex<float>> spectrum;
+	///The log compressed magnitudes of the bins of the previous window.
+	std::vector<float> previous_log_magnitudes;
+
+	std::vector<float> onset_strengths;
+	std::vector<float> low_band_onset_strengths;
+};
+
+#endif
@@ -1,14 +1,17 @@
 #ifndef OutputDeviceData_hpp
 #define OutputDeviceData_hpp
 
+#include "Mixer.hpp"
 #include "GlobalStates.hpp"
 #include "portaudio.h"
 
 struct OutputDeviceData{
-	OutputDeviceData(GlobalStates& global_states, const PaDeviceIndex device_index, const PaTime output_latency, bool is_monitor_device)
+	OutputDeviceData(GlobalStates& global_states, Mixer& mixer, const PaDeviceIndex device_index, const PaTime output_latency, bool is_monitor_device)
 	: 	global_states(global_states), 
+		mixer(mixer),
 		device_index(device_index), 
-		is_monitor_device(is_monitor_device)
+		is_monitor_device(is_monitor_device),
+		underrun_concealer(global_states.get_frames_per_callback() * ntrb_std_audchannels)
 	{
 		this->stream_parameters.device = device_index;
 		this->stream_parameters.suggestedLatency = output_latency;
@@ -18,9 +21,12 @@ struct OutputDeviceData{
 	}
 
 	GlobalStates& global_states;
+	Mixer& mixer;
 	PaDeviceIndex device_index;
 	PaStreamParameters stream_parameters;
 	bool is_monitor_device;
+	///Conceals the bus ring of the device running dry.
+	UnderrunConcealer underrun_concealer;
 };
 
 #endif
\ No newline at end of file
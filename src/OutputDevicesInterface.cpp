@@ -5,83 +5,62 @@
 
 #include <chrono>
 #include <iostream>
+#include <algorithm>
 
 OutputDevicesInterface::OutputDevicesInterface(
 	const PaDeviceIndex audience_output_device_index, 
 	const PaDeviceIndex monitor_output_device_index,
 	GlobalStates& global_states
 )
-:	global_states(global_states)
+:	global_states(global_states),
+	mixer(global_states)
 {
+	const std::chrono::microseconds render_idle_timeout = global_states.get_callback_period();
+	for(const std::unique_ptr<AudioTrack>& deck : global_states.audio_tracks){
+		AudioTrack* const deck_ptr = deck.get();
+		this->deck_render_workers.emplace_back(std::make_unique<RenderWorker>([deck_ptr]{
+			if(not deck_ptr->needs_rendering()) return false;
+			deck_ptr->load_samples();
+			return true;
+		}, render_idle_timeout));
+	}
+	this->mixer_render_worker = std::make_unique<RenderWorker>([this]{
+		return this->mixer.render_block();
+	}, render_idle_timeout);
+	
 	const PaTime audience_output_latency = Pa_GetDeviceInfo(audience_output_device_index)->defaultLowOutputLatency;
 	const PaTime monitor_output_latency = Pa_GetDeviceInfo(monitor_output_device_index)->defaultLowOutputLatency;
 	PaTime agreed_latency = audience_output_latency;
 	if(audience_output_latency < monitor_output_latency) 
 		agreed_latency = monitor_output_latency;
 	
-	const OutputDeviceData audience_data(global_states, audience_output_device_index, agreed_latency, false);
+	const OutputDeviceData audience_data(global_states, this->mixer, audience_output_device_index, agreed_latency, false);
 	this->audience_output_device_thread = std::thread(run_output_device, audience_data);
 	this->audience_output_device_thread.detach();
 
 	const bool has_one_output_device = audience_output_device_index == monitor_output_device_index;
 	if(not has_one_output_device){	
-		const OutputDeviceData monitor_data(global_states, monitor_output_device_index, agreed_latency, true);
+		const OutputDeviceData monitor_data(global_states, this->mixer, monitor_output_device_index, agreed_latency, true);
 		this->monitor_output_device_thread = std::thread(run_output_device, monitor_data);
 		this->monitor_output_device_thread.detach();
 	}
 }
 
 void OutputDevicesInterface::run() noexcept{
+	//Polling at half a period lets a short period be refilled before it runs dry.
+	const std::chrono::microseconds scheduler_poll_interval = std::min<std::chrono::microseconds>(
+		this->global_states.get_callback_period() / 2, std::chrono::milliseconds(5)
+	);
+	
 	while(this->global_states.requested_exit.load() == false){
 		try{
-			const std::unique_ptr<AudioTrack>& left_deck = this->global_states.audio_tracks[0];
-			const std::unique_ptr<AudioTrack>& right_deck = this->global_states.audio_tracks[1];
-			
-			const uint8_t audience_device_status = global_states.audience_output_device_status.load();
-			switch(audience_device_status){
-				case AudioTrackAccess_ReadingBlocked:{
-					if(not left_deck->sample_access_mutex.try_lock())
-						break;
-					if(not right_deck->sample_access_mutex.try_lock()){
-						left_deck->sample_access_mutex.unlock();
-						break;
-					}
-		
-					global_states.audience_output_device_status = AudioTrackAccess_ReadyForReading;
-					global_states.monitor_output_device_status = AudioTrackAccess_ReadyForReading;
-					break;
-				}
-				case AudioTrackAccess_ReadyForReading:
-				break;
-				
-				case AudioTrackAccess_BeingRead:
-				break;
-				
-				case AudioTrackAccess_FinishedReading:{
-					if(global_states.monitor_output_device_status.load() == AudioTrackAccess_BeingRead)
-						break;
-
-					left_deck->sample_access_mutex.unlock();
-					right_deck->sample_access_mutex.unlock();
-					
-					try{
-						std::thread left_deck_load_thread = std::thread(left_deck->load_samples, left_deck.get());
-						std::thread right_deck_load_thread = std::thread(right_deck->load_samples, right_deck.get());
-						left_deck_load_thread.detach();
-						right_deck_load_thread.detach();
-						
-						global_states.audience_output_device_status = AudioTrackAccess_ReadingBlocked;
-						global_states.monitor_output_device_status = AudioTrackAccess_ReadingBlocked;
-					}
-					catch(const std::system_error& thread_spawn_failed){
-						ui::print_to_infobar("Failed to spawn thread for loading samples.", UIColorPair_Error);
-					}
-					break;
-				}
-				default:
-				ui::print_to_infobar("Invalid audience device status.", UIColorPair_Error);
+			for(std::size_t deck_index = 0; deck_index < this->deck_render_workers.size(); deck_index++){
+				if(this->global_states.audio_tracks[deck_index]->needs_rendering())
+					this->deck_render_workers[deck_index]->wake();
 			}
-			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+			if(this->mixer.needs_rendering())
+				this->mixer_render_worker->wake();
+			std::this_thread::sleep_for(scheduler_poll_interval);
 		}
 		catch(const std::exception& excp){
 			ui::print_to_infobar(std::string("OutputDevicesInterface::run(): ") + excp.what(), UIColorPair_Error);
@@ -90,4 +69,8 @@ void OutputDevicesInterface::run() noexcept{
 			ui::print_to_infobar("OutputDevicesInterface::run(): uncaught throw.", UIColorPair_Error);
 		}
 	}
+	
+	this->mixer_render_worker->stop();
+	for(std::unique_ptr<RenderWorker>& worker : this->deck_render_workers)
+		worker->stop();
 }
\ No newline at end of file
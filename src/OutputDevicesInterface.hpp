@@ -1,10 +1,14 @@
 #ifndef OutputDevicesInterface_hpp
 #define OutputDevicesInterface_hpp
 
+#include "Mixer.hpp"
 #include "GlobalStates.hpp"
+#include "RenderWorker.hpp"
 #include "portaudio.h"
 
+#include <memory>
 #include <thread>
+#include <vector>
 
 class OutputDevicesInterface{
 	public:
@@ -13,12 +17,21 @@ class OutputDevicesInterface{
 		const PaDeviceIndex monitor_output_device_index,
 		GlobalStates& global_states
 	);
+	/**
+	Wakes the RenderWorker of every deck, and of the Mixer, which has run low on rendered blocks, until GlobalStates::requested_exit is set.
+	The workers are stopped before returning, so the decks can be destroyed afterwards.
+	*/
 	void run() noexcept;
 	
 	private:
+	///One persistent render thread per deck, indexed the same as GlobalStates::audio_tracks.
+	std::vector<std::unique_ptr<RenderWorker>> deck_render_workers;
 	std::thread monitor_output_device_thread;
 	std::thread audience_output_device_thread;
 	GlobalStates& global_states;
+	///Mixes the decks once for both output devices.
+	Mixer mixer;
+	std::unique_ptr<RenderWorker> mixer_render_worker;
 };
 
 #endif
\ No newline at end of file
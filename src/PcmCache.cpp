@@ -0,0 +1,188 @@
+#include "PcmCache.hpp"
+
+#include "ntrb/aud_std_fmt.h"
+
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <cstdio>
+	#include <unistd.h>
+	#include <sys/mman.h>
+#endif
+
+///The amount of frames decoded at a time, which is also the most silence ntrb pads the end of the track with.
+static constexpr std::uint32_t frames_per_decode = 8192;
+
+static constexpr std::uint64_t chunk_samples = (PcmCache::chunk_frames + PcmCache::chunk_margin_frames) * 2;
+//Each chunk is mapped at its own offset of the temporary file, which must be a multiple of the allocation granularity (64KiB on Windows).
+static_assert((chunk_samples * sizeof(float)) % 65536 == 0, "PcmCache chunks must be a multiple of 64KiB to be mapped individually.");
+
+PcmCache::PcmCache(const std::string& filename, const PcmCacheMode mode)
+:	mode(mode),
+	chunks(new std::atomic<float*>[max_chunk_count])
+{
+	for(std::uint64_t chunk_index = 0; chunk_index < max_chunk_count; chunk_index++)
+		this->chunks[chunk_index] = nullptr;
+
+	if(this->mode == PcmCacheMode_MappedFile){
+		#ifdef _WIN32
+		char temp_directory[MAX_PATH+1], temp_filename[MAX_PATH+1];
+		const bool temp_filename_created = GetTempPathA(sizeof(temp_directory), temp_directory) != 0
+											and GetTempFileNameA(temp_directory, "ard", 0, temp_filename) != 0;
+		if(temp_filename_created)
+			this->mapped_file_handle = CreateFileA(temp_filename, GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+													FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, NULL);
+		if(not temp_filename_created or this->mapped_file_handle == INVALID_HANDLE_VALUE){
+			this->mapped_file_handle = nullptr;
+			throw std::runtime_error("PcmCache: could not create the temporary file.");
+		}
+		#else
+		//Deleted as soon as it is closed.
+		std::FILE* const temp_file = std::tmpfile();
+		if(temp_file == nullptr) throw std::runtime_error("PcmCache: could not create the temporary file.");
+		this->mapped_file_descriptor = dup(fileno(temp_file));
+		std::fclose(temp_file);
+		if(this->mapped_file_descriptor == -1) throw std::runtime_error("PcmCache: could not create the temporary file.");
+		#endif
+	}
+
+	if(ntrb_AudioBuffer_new(&(this->decoding_buffer), filename.c_str(), frames_per_decode) != ntrb_AudioBufferNew_OK){
+		#ifdef _WIN32
+		if(this->mapped_file_handle) CloseHandle(this->mapped_file_handle);
+		#else
+		if(this->mapped_file_descriptor != -1) close(this->mapped_file_descriptor);
+		#endif
+		throw std::runtime_error("PcmCache: could not open " + filename + ".");
+	}
+
+	this->decoding_thread = std::thread(&PcmCache::decode_track, this);
+}
+
+PcmCache::~PcmCache(){
+	this->stop_decoding = true;
+	if(this->decoding_thread.joinable())
+		this->decoding_thread.join();
+	ntrb_AudioBuffer_free(&(this->decoding_buffer));
+
+	for(std::uint64_t chunk_index = 0; chunk_index < max_chunk_count; chunk_index++){
+		float* const chunk = this->chunks[chunk_index].load();
+		if(chunk == nullptr) continue;
+
+		if(this->mode == PcmCacheMode_MappedFile){
+			#ifdef _WIN32
+			UnmapViewOfFile(chunk);
+			#else
+			munmap(chunk, chunk_samples * sizeof(float));
+			#endif
+		}
+		else delete[] chunk;
+	}
+
+	#ifdef _WIN32
+	if(this->mapped_file_handle) CloseHandle(this->mapped_file_handle);
+	#else
+	if(this->mapped_file_descriptor != -1) close(this->mapped_file_descriptor);
+	#endif
+}
+
+bool PcmCache::get_span(const std::uint64_t first_frame, const std::uint64_t minimum_frames, SourceSpan& span) const noexcept{
+	//Read before the chunks, so every chunk holding a decoded frame is visible.
+	const std::uint64_t decoded_frames_copy = this->decoded_frames.load(std::memory_order_acquire);
+	const bool complete_copy = this->complete.load(std::memory_order_acquire);
+
+	const std::uint64_t chunk_index = first_frame / chunk_frames;
+	if(chunk_index >= max_chunk_count) return false;
+	const std::uint64_t chunk_first_frame = chunk_index * chunk_frames;
+	const std::uint64_t chunk_end_frame = std::min(chunk_first_frame + chunk_frames + chunk_margin_frames, std::max(decoded_frames_copy, chunk_first_frame));
+
+	const bool holds_minimum_frames = first_frame + minimum_frames <= chunk_end_frame;
+	if(not holds_minimum_frames and not complete_copy) return false;
+
+	span.datapoints = this->chunks[chunk_index].load(std::memory_order_acquire);
+	span.first_frame = chunk_first_frame;
+	//Past the end of a complete track, an empty span tells the deck it has reached the end.
+	span.frame_count = span.datapoints ? chunk_end_frame - chunk_first_frame : 0;
+	return true;
+}
+
+void PcmCache::decode_track() noexcept{
+	std::uint64_t next_frame = 0;
+	while(not this->stop_decoding.load() and next_frame < max_track_frames){
+		this->decoding_buffer.stdaud_next_buffer_first_frame = next_frame;
+		this->decoding_buffer.load_buffer_callback(&(this->decoding_buffer));
+		const ntrb_AudioBufferLoad_Error load_err = this->decoding_buffer.load_err;
+
+		if(load_err != ntrb_AudioBufferLoad_OK and load_err != ntrb_AudioBufferLoad_EOF){
+			this->failed.store(true, std::memory_order_release);
+			return;
+		}
+
+		const std::uint64_t frame_count = std::min<std::uint64_t>(this->decoding_buffer.monochannel_samples, max_track_frames - next_frame);
+		if(not this->store_frames(this->decoding_buffer.datapoints, next_frame, frame_count)){
+			this->failed.store(true, std::memory_order_release);
+			return;
+		}
+		next_frame += frame_count;
+		this->decoded_frames.store(next_frame, std::memory_order_release);
+
+		//ntrb will 0 fill its stdaud buffer past the EOF, which is kept as the end of the track.
+		if(load_err == ntrb_AudioBufferLoad_EOF or frame_count == 0)
+			break;
+	}
+	this->complete.store(true, std::memory_order_release);
+}
+
+bool PcmCache::store_frames(const float* const frames, const std::uint64_t first_frame, const std::uint64_t frame_count) noexcept{
+	const std::uint64_t end_frame = first_frame + frame_count;
+	//The chunk before the one holding first_frame may also hold it in its margin.
+	const std::uint64_t first_chunk_index = first_frame >= chunk_frames + chunk_margin_frames
+											? (first_frame - chunk_margin_frames) / chunk_frames
+											: 0;
+	for(std::uint64_t chunk_index = first_chunk_index; chunk_index * chunk_frames < end_frame and chunk_index < max_chunk_count; chunk_index++){
+		const std::uint64_t chunk_first_frame = chunk_index * chunk_frames;
+		const std::uint64_t copy_first_frame = std::max(first_frame, chunk_first_frame);
+		const std::uint64_t copy_end_frame = std::min(end_frame, chunk_first_frame + chunk_frames + chunk_margin_frames);
+		if(copy_first_frame >= copy_end_frame) continue;
+
+		float* const chunk = this->get_or_allocate_chunk(chunk_index);
+		if(chunk == nullptr) return false;
+		std::memcpy(chunk + ((copy_first_frame - chunk_first_frame) * 2), frames + ((copy_first_frame - first_frame) * 2),
+					(copy_end_frame - copy_first_frame) * 2 * sizeof(float));
+	}
+	return true;
+}
+
+float* PcmCache::get_or_allocate_chunk(const std::uint64_t chunk_index) noexcept{
+	float* chunk = this->chunks[chunk_index].load(std::memory_order_relaxed);
+	if(chunk) return chunk;
+
+	if(this->mode == PcmCacheMode_MappedFile){
+		const std::uint64_t chunk_bytes = chunk_samples * sizeof(float);
+		const std::uint64_t file_offset = chunk_index * chunk_bytes;
+		#ifdef _WIN32
+		//Mapping past the end of the file grows it, the view keeps the mapping alive after its handle is closed.
+		const std::uint64_t file_size = file_offset + chunk_bytes;
+		HANDLE mapping = CreateFileMappingA(this->mapped_file_handle, NULL, PAGE_READWRITE, DWORD(file_size >> 32), DWORD(file_size), NULL);
+		if(mapping == NULL) return nullptr;
+		chunk = (float*)MapViewOfFile(mapping, FILE_MAP_WRITE, DWORD(file_offset >> 32), DWORD(file_offset), chunk_bytes);
+		CloseHandle(mapping);
+		if(chunk == NULL) return nullptr;
+		#else
+		if(ftruncate(this->mapped_file_descriptor, file_offset + chunk_bytes) != 0) return nullptr;
+		void* const mapped = mmap(nullptr, chunk_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, this->mapped_file_descriptor, file_offset);
+		if(mapped == MAP_FAILED) return nullptr;
+		chunk = (float*)mapped;
+		#endif
+	}else{
+		chunk = new(std::nothrow) float[chunk_samples];
+		if(chunk == nullptr) return nullptr;
+	}
+
+	//Published before PcmCache::decoded_frames covers the chunk.
+	this->chunks[chunk_index].store(chunk, std::memory_order_release);
+	return chunk;
+}
@@ -0,0 +1,112 @@
+/**
+\file PcmCache.hpp
+*/
+
+#ifndef PcmCache_hpp
+#define PcmCache_hpp
+
+#include "resampler.hpp"
+
+#include "ntrb/AudioBuffer.h"
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <string>
+#include <cstdint>
+
+///Where a PcmCache keeps the decoded track.
+enum PcmCacheMode : std::uint8_t{
+	///No cache, decks decode from the file every time the playhead leaves their ntrb_AudioBuffer.
+	PcmCacheMode_Off,
+	///Decoded to memory.
+	PcmCacheMode_Ram,
+	///Decoded to a memory-mapped temporary file, so the operating system can page out what is not played.
+	PcmCacheMode_MappedFile
+};
+
+constexpr std::array<const char*, (int)PcmCacheMode_MappedFile+1> pcm_cache_mode_names{
+	"Off",
+	"RAM",
+	"Memory-mapped file",
+};
+
+/**
+A whole track decoded once to stdaud frames by a background thread, which decks read from without copying or decoding.
+
+The track is stored in chunks of PcmCache::chunk_frames frames, each followed by the first PcmCache::chunk_margin_frames frames
+of the next chunk, so any PcmCache::chunk_margin_frames frames of the track are contiguous in one chunk.
+A chunk is never moved or freed until the cache is destroyed, so spans of it stay valid while the rest of the track is decoded.
+
+Decoding happens on a thread owned by the cache, frames are published as they are decoded,
+so a deck can play from the cache before the whole track is decoded.
+*/
+class PcmCache{
+	public:
+	static constexpr std::uint64_t chunk_frames = 65536;
+	static constexpr std::uint64_t chunk_margin_frames = 8192;
+	///The longest track which can be cached, longer tracks are only cached up to this length.
+	static constexpr std::uint64_t max_track_frames = std::uint64_t(4) * 60 * 60 * 48000;
+
+	/**
+	Starts decoding *filename* on a background thread, to RAM or a temporary file depending on *mode*.
+
+	Throws std::runtime_error if the file could not be opened or the temporary file could not be created.
+	*/
+	PcmCache(const std::string& filename, const PcmCacheMode mode);
+	///Stops decoding and frees every chunk, along with the temporary file.
+	~PcmCache();
+
+	PcmCache(const PcmCache&) = delete;
+	PcmCache& operator=(const PcmCache&) = delete;
+
+	/**
+	Sets *span* to the decoded frames of the chunk holding *first_frame*,
+	if they include *minimum_frames* frames from *first_frame*, or the cache is completely decoded.
+	*minimum_frames* must not exceed PcmCache::chunk_margin_frames.
+
+	Returns false if those frames have not been decoded yet, the deck should decode them itself in the meantime.
+	*/
+	bool get_span(const std::uint64_t first_frame, const std::uint64_t minimum_frames, SourceSpan& span) const noexcept;
+
+	std::uint64_t get_decoded_frames() const noexcept{
+		return this->decoded_frames.load(std::memory_order_acquire);
+	}
+	///Whether the whole track is decoded, after which the cache never decodes again.
+	bool is_complete() const noexcept{
+		return this->complete.load(std::memory_order_acquire);
+	}
+	///Whether decoding stopped on an error before the end of the track.
+	bool has_failed() const noexcept{
+		return this->failed.load(std::memory_order_acquire);
+	}
+
+	private:
+	void decode_track() noexcept;
+	///Copies *frame_count* frames beginning at *first_frame* of the track to every chunk holding them.
+	bool store_frames(const float* const frames, const std::uint64_t first_frame, const std::uint64_t frame_count) noexcept;
+	///Returns the samples of chunk *chunk_index*, mapping or allocating it first if needed. nullptr on failure.
+	float* get_or_allocate_chunk(const std::uint64_t chunk_index) noexcept;
+
+	const PcmCacheMode mode;
+	ntrb_AudioBuffer decoding_buffer;
+
+	static constexpr std::uint64_t max_chunk_count = (max_track_frames / chunk_frames) + 1;
+	///The samples of each chunk, published with release ordering before PcmCache::decoded_frames covers any of them.
+	std::unique_ptr<std::atomic<float*>[]> chunks;
+	std::atomic<std::uint64_t> decoded_frames = 0;
+	std::atomic_bool complete = false;
+	std::atomic_bool failed = false;
+	std::atomic_bool stop_decoding = false;
+
+	#ifdef _WIN32
+	void* mapped_file_handle = nullptr;
+	#else
+	int mapped_file_descriptor = -1;
+	#endif
+
+	std::thread decoding_thread;
+};
+
+#endif
@@ -0,0 +1,199 @@
+#include "ReadAheadDecoder.hpp"
+
+#include "ntrb/aud_std_fmt.h"
+
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+
+static constexpr std::uint64_t frames_per_chunk_slot = ReadAheadDecoder::chunk_frames + ReadAheadDecoder::chunk_margin_frames;
+static constexpr std::uint64_t samples_per_chunk_slot = frames_per_chunk_slot * 2;
+
+///How long the decoding thread sleeps when every wanted chunk is decoded, unless the render thread wakes it earlier.
+static constexpr std::chrono::milliseconds idle_wait(10);
+
+ReadAheadDecoder::ReadAheadDecoder(ntrb_AudioBuffer& file_buffer)
+:	file_buffer(file_buffer),
+	slots(new ChunkSlot[slot_count]),
+	slot_samples(slot_count * samples_per_chunk_slot)
+{
+	for(std::atomic<std::int64_t>& jump_target_chunk : this->jump_target_chunks)
+		jump_target_chunk = no_jump_target;
+	this->decoding_thread = std::thread(&ReadAheadDecoder::decode_chunks, this);
+}
+
+ReadAheadDecoder::~ReadAheadDecoder(){
+	{
+		std::lock_guard<std::mutex> _(this->wake_mutex);
+		this->stop_decoding = true;
+	}
+	this->wake_condition.notify_one();
+	if(this->decoding_thread.joinable())
+		this->decoding_thread.join();
+}
+
+void ReadAheadDecoder::set_playhead(const std::uint64_t playhead_frame, const JumpTargets& jump_targets) noexcept{
+	bool wanted_chunks_changed = false;
+
+	const std::uint64_t playhead_chunk_copy = first_chunk_rendering(playhead_frame);
+	if(this->playhead_chunk.exchange(playhead_chunk_copy, std::memory_order_relaxed) != playhead_chunk_copy)
+		wanted_chunks_changed = true;
+
+	for(std::uint8_t i = 0; i < max_jump_targets; i++){
+		const std::int64_t jump_target_chunk = jump_targets[i] == no_jump_target ? no_jump_target : (std::int64_t)first_chunk_rendering(jump_targets[i]);
+		if(this->jump_target_chunks[i].exchange(jump_target_chunk, std::memory_order_relaxed) != jump_target_chunk)
+			wanted_chunks_changed = true;
+	}
+
+	//Only ready slots belong to this thread, so only they can be freed, and only here, so spans stay valid throughout a block.
+	for(std::uint32_t slot_index = 0; slot_index < slot_count; slot_index++){
+		ChunkSlot& slot = this->slots[slot_index];
+		if(slot.state.load(std::memory_order_acquire) != SlotState_Ready) continue;
+		if(not this->is_chunk_wanted(slot.chunk_index)){
+			slot.state.store(SlotState_Free, std::memory_order_release);
+			wanted_chunks_changed = true;
+		}
+	}
+
+	if(wanted_chunks_changed)
+		this->wake_condition.notify_one();
+}
+
+bool ReadAheadDecoder::get_span(const std::uint64_t first_frame, SourceSpan& span) noexcept{
+	const std::uint64_t chunk_index = first_frame / chunk_frames;
+
+	//Past the end of the track, an empty span tells the deck it has reached the end.
+	if(chunk_index > this->last_chunk.load(std::memory_order_acquire)){
+		span.datapoints = nullptr;
+		span.first_frame = chunk_index * chunk_frames;
+		span.frame_count = 0;
+		return true;
+	}
+
+	for(std::uint32_t i = 0; i < slot_count; i++){
+		const std::uint32_t slot_index = (this->last_found_slot + i) % slot_count;
+		const ChunkSlot& slot = this->slots[slot_index];
+		if(slot.state.load(std::memory_order_acquire) != SlotState_Ready or slot.chunk_index != chunk_index) continue;
+
+		this->last_found_slot = slot_index;
+		span.datapoints = this->slot_samples.data() + (slot_index * samples_per_chunk_slot);
+		span.first_frame = chunk_index * chunk_frames;
+		span.frame_count = slot.frame_count;
+		return true;
+	}
+
+	this->wake_condition.notify_one();
+	return false;
+}
+
+bool ReadAheadDecoder::is_chunk_wanted(const std::uint64_t chunk_index) const noexcept{
+	if(chunk_index > this->last_chunk.load(std::memory_order_acquire)) return false;
+
+	const std::uint64_t playhead_chunk_copy = this->playhead_chunk.load(std::memory_order_relaxed);
+	const std::uint64_t first_wanted_chunk = playhead_chunk_copy > chunks_behind ? playhead_chunk_copy - chunks_behind : 0;
+	if(chunk_index >= first_wanted_chunk and chunk_index <= playhead_chunk_copy + chunks_ahead) return true;
+
+	//The chunk a jump lands in and the one after it, so playback continues from there while the decoder catches up.
+	for(const std::atomic<std::int64_t>& jump_target_chunk : this->jump_target_chunks){
+		const std::int64_t jump_target_chunk_copy = jump_target_chunk.load(std::memory_order_relaxed);
+		if(jump_target_chunk_copy == no_jump_target) continue;
+		if(chunk_index >= (std::uint64_t)jump_target_chunk_copy and chunk_index <= (std::uint64_t)jump_target_chunk_copy + 1) return true;
+	}
+	return false;
+}
+
+bool ReadAheadDecoder::find_missing_chunk(std::uint64_t& chunk_index) const noexcept{
+	const auto is_decoded = [this](const std::uint64_t chunk_index) -> bool{
+		//ChunkSlot::chunk_index is only written by this thread, so it can be read while the slot is ready.
+		for(std::uint32_t slot_index = 0; slot_index < slot_count; slot_index++){
+			const ChunkSlot& slot = this->slots[slot_index];
+			if(slot.state.load(std::memory_order_acquire) == SlotState_Ready and slot.chunk_index == chunk_index) return true;
+		}
+		return false;
+	};
+	const std::uint64_t last_chunk_copy = this->last_chunk.load(std::memory_order_acquire);
+	const auto is_missing = [&](const std::uint64_t candidate) -> bool{
+		return candidate <= last_chunk_copy and not is_decoded(candidate);
+	};
+
+	//The chunk being played first, as a jump to anywhere not decoded is silent until it is, then the chunks ahead of it in playing order.
+	const std::uint64_t playhead_chunk_copy = this->playhead_chunk.load(std::memory_order_relaxed);
+	for(std::uint64_t candidate = playhead_chunk_copy; candidate <= playhead_chunk_copy + chunks_ahead; candidate++){
+		if(is_missing(candidate)){
+			chunk_index = candidate;
+			return true;
+		}
+	}
+
+	for(const std::atomic<std::int64_t>& jump_target_chunk : this->jump_target_chunks){
+		const std::int64_t jump_target_chunk_copy = jump_target_chunk.load(std::memory_order_relaxed);
+		if(jump_target_chunk_copy == no_jump_target) continue;
+		for(std::uint64_t candidate = jump_target_chunk_copy; candidate <= (std::uint64_t)jump_target_chunk_copy + 1; candidate++){
+			if(is_missing(candidate)){
+				chunk_index = candidate;
+				return true;
+			}
+		}
+	}
+
+	for(std::uint64_t behind = 1; behind <= chunks_behind and behind <= playhead_chunk_copy; behind++){
+		if(is_missing(playhead_chunk_copy - behind)){
+			chunk_index = playhead_chunk_copy - behind;
+			return true;
+		}
+	}
+	return false;
+}
+
+void ReadAheadDecoder::decode_chunks() noexcept{
+	while(not this->stop_decoding.load()){
+		std::uint64_t chunk_index;
+		std::uint32_t free_slot_index = slot_count;
+		if(this->find_missing_chunk(chunk_index)){
+			for(std::uint32_t slot_index = 0; slot_index < slot_count; slot_index++){
+				if(this->slots[slot_index].state.load(std::memory_order_acquire) == SlotState_Free){
+					free_slot_index = slot_index;
+					break;
+				}
+			}
+		}
+
+		//Nothing is missing, or every slot still holds a wanted chunk until the render thread frees some.
+		if(free_slot_index == slot_count){
+			std::unique_lock<std::mutex> wake_lock(this->wake_mutex);
+			if(not this->stop_decoding.load())
+				this->wake_condition.wait_for(wake_lock, idle_wait);
+			continue;
+		}
+
+		if(not this->decode_chunk(chunk_index, free_slot_index)){
+			this->failed.store(true, std::memory_order_release);
+			return;
+		}
+	}
+}
+
+bool ReadAheadDecoder::decode_chunk(const std::uint64_t chunk_index, const std::uint32_t slot_index) noexcept{
+	const std::uint64_t chunk_first_frame = chunk_index * chunk_frames;
+	this->file_buffer.stdaud_next_buffer_first_frame = chunk_first_frame;
+	this->file_buffer.load_buffer_callback(&(this->file_buffer));
+
+	const ntrb_AudioBufferLoad_Error load_err = this->file_buffer.load_err;
+	this->load_error.store(load_err, std::memory_order_relaxed);
+	if(load_err != ntrb_AudioBufferLoad_OK and load_err != ntrb_AudioBufferLoad_EOF)
+		return false;
+
+	ChunkSlot& slot = this->slots[slot_index];
+	const std::uint64_t frame_count = std::min<std::uint64_t>(this->file_buffer.monochannel_samples, frames_per_chunk_slot);
+	std::memcpy(this->slot_samples.data() + (slot_index * samples_per_chunk_slot), this->file_buffer.datapoints, frame_count * 2 * sizeof(float));
+	slot.chunk_index = chunk_index;
+	slot.frame_count = frame_count;
+	slot.state.store(SlotState_Ready, std::memory_order_release);
+
+	//ntrb will 0 fill its stdaud buffer past the EOF, which is kept as the end of the track, as if the PcmCache decoded it.
+	if(load_err == ntrb_AudioBufferLoad_EOF){
+		std::uint64_t last_chunk_copy = this->last_chunk.load(std::memory_order_relaxed);
+		while(chunk_index < last_chunk_copy and not this->last_chunk.compare_exchange_weak(last_chunk_copy, chunk_index, std::memory_order_release));
+	}
+	return true;
+}
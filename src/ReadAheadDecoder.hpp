@@ -0,0 +1,136 @@
+/**
+\file ReadAheadDecoder.hpp
+*/
+
+#ifndef ReadAheadDecoder_hpp
+#define ReadAheadDecoder_hpp
+
+#include "resampler.hpp"
+#include "AlignedSampleBuffer.hpp"
+
+#include "ntrb/AudioBuffer.h"
+
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <cstdint>
+#include <condition_variable>
+
+/**
+Decodes a track on its own thread, a few seconds ahead of the playhead of a deck and around the places it may jump to,
+so the render thread of the deck only ever reads frames which are already decoded.
+
+The track is split into chunks of ReadAheadDecoder::chunk_frames frames, each decoded with the first ReadAheadDecoder::chunk_margin_frames frames
+of the next chunk, so any ReadAheadDecoder::chunk_margin_frames frames of the track are contiguous in one chunk.
+Decoded chunks are handed between the threads through a fixed pool of slots, each owned by either thread at a time through an atomic state:
+the decoder only fills free slots and publishes them as ready, and only the render thread frees ready slots, once they are no longer wanted.
+Neither side locks or allocates.
+
+Which chunks are wanted is only decided by the playhead and the jump targets the render thread last published,
+the chunk holding the playhead is always decoded first, so a jump anywhere else is refilled from its new position first.
+*/
+class ReadAheadDecoder{
+	public:
+	static constexpr std::uint64_t chunk_frames = 16384;
+	static constexpr std::uint64_t chunk_margin_frames = 4096;
+	///Chunks decoded ahead of the one holding the playhead, about 3.5 seconds at 48kHz.
+	static constexpr std::uint64_t chunks_ahead = 10;
+	///Chunks kept behind the one holding the playhead, so cueing and previewing to nearby beats does not miss.
+	static constexpr std::uint64_t chunks_behind = 3;
+	///The places besides the playhead the deck may jump to, such as its cue point and loop start, which are kept decoded.
+	static constexpr std::uint8_t max_jump_targets = 4;
+	using JumpTargets = std::array<std::int64_t, max_jump_targets>;
+	///A JumpTargets entry without a place to jump to.
+	static constexpr std::int64_t no_jump_target = -1;
+
+	/**
+	Starts decoding *file_buffer* on a background thread.
+	*file_buffer* must hold ReadAheadDecoder::chunk_frames + ReadAheadDecoder::chunk_margin_frames frames, and must outlive the decoder;
+	nothing else may load it while the decoder exists.
+	*/
+	ReadAheadDecoder(ntrb_AudioBuffer& file_buffer);
+	///Stops the decoding thread.
+	~ReadAheadDecoder();
+
+	ReadAheadDecoder(const ReadAheadDecoder&) = delete;
+	ReadAheadDecoder& operator=(const ReadAheadDecoder&) = delete;
+
+	/**
+	Publishes where the deck is and may jump to, and frees the chunks which are not wanted anymore. Render thread only.
+	Spans from ReadAheadDecoder::get_span() are valid until the next call.
+	*/
+	void set_playhead(const std::uint64_t playhead_frame, const JumpTargets& jump_targets) noexcept;
+
+	/**
+	Sets *span* to the decoded chunk holding *first_frame*, which holds at least ReadAheadDecoder::chunk_margin_frames frames from it.
+	Past the end of the track, *span* is empty. Render thread only.
+
+	Returns false if the chunk is not decoded yet, in which case the decoder is woken to decode it as soon as possible.
+	*/
+	bool get_span(const std::uint64_t first_frame, SourceSpan& span) noexcept;
+
+	///Whether every chunk wanted as of the last ReadAheadDecoder::set_playhead() is decoded. Only called before a render thread reads from the decoder.
+	bool has_decoded_wanted_chunks() const noexcept{
+		std::uint64_t chunk_index;
+		return not this->find_missing_chunk(chunk_index);
+	}
+	///Whether decoding stopped on an error from the file.
+	bool has_failed() const noexcept{
+		return this->failed.load(std::memory_order_acquire);
+	}
+	ntrb_AudioBufferLoad_Error get_load_error() const noexcept{
+		return this->load_error.load(std::memory_order_relaxed);
+	}
+
+	private:
+	enum SlotState : std::uint8_t{
+		///Owned by the decoding thread.
+		SlotState_Free,
+		///Owned by the render thread.
+		SlotState_Ready
+	};
+	struct ChunkSlot{
+		std::atomic<SlotState> state = SlotState_Free;
+		///Written by the decoding thread before the slot is published as ready.
+		std::uint64_t chunk_index = 0;
+		std::uint64_t frame_count = 0;
+	};
+	static constexpr std::uint32_t slot_count = 32;
+	static constexpr std::uint64_t no_last_chunk = UINT64_MAX;
+
+	void decode_chunks() noexcept;
+	///Returns the most urgent chunk which is wanted but not in any slot, or false if every wanted chunk is decoded.
+	bool find_missing_chunk(std::uint64_t& chunk_index) const noexcept;
+	bool is_chunk_wanted(const std::uint64_t chunk_index) const noexcept;
+	bool decode_chunk(const std::uint64_t chunk_index, const std::uint32_t slot_index) noexcept;
+
+	///The first chunk which may be read to render *frame*, as the interpolation or the time-stretcher also reads frames before it.
+	static std::uint64_t first_chunk_rendering(const std::int64_t frame) noexcept{
+		return frame > (std::int64_t)chunk_margin_frames ? (frame - chunk_margin_frames) / chunk_frames : 0;
+	}
+
+	ntrb_AudioBuffer& file_buffer;
+
+	std::unique_ptr<ChunkSlot[]> slots;
+	AlignedSampleBuffer slot_samples;
+	///The slot ReadAheadDecoder::get_span() found last, checked first as consecutive blocks mostly read the same chunk.
+	std::uint32_t last_found_slot = 0;
+
+	///ReadAheadDecoder::first_chunk_rendering() of the playhead and of every jump target, as of the last ReadAheadDecoder::set_playhead().
+	std::atomic<std::uint64_t> playhead_chunk = 0;
+	std::array<std::atomic<std::int64_t>, max_jump_targets> jump_target_chunks;
+	///The last chunk of the track, known once the decoder reaches the end of the file.
+	std::atomic<std::uint64_t> last_chunk = no_last_chunk;
+
+	std::atomic_bool failed = false;
+	std::atomic<ntrb_AudioBufferLoad_Error> load_error = ntrb_AudioBufferLoad_OK;
+
+	std::atomic_bool stop_decoding = false;
+	std::mutex wake_mutex;
+	std::condition_variable wake_condition;
+	std::thread decoding_thread;
+};
+
+#endif
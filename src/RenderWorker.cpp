@@ -0,0 +1,54 @@
+#include "RenderWorker.hpp"
+#include "ui.hpp"
+
+#include <string>
+
+RenderWorker::RenderWorker(std::function<bool()> render_block, const std::chrono::microseconds idle_timeout)
+:	render_block(std::move(render_block)),
+	idle_timeout(idle_timeout),
+	worker_thread(&RenderWorker::run, this)
+{
+}
+
+RenderWorker::~RenderWorker(){
+	this->stop();
+}
+
+void RenderWorker::wake() noexcept{
+	{
+		std::lock_guard<std::mutex> _(this->wake_mutex);
+		this->wake_requested = true;
+	}
+	this->wake_condition.notify_one();
+}
+
+void RenderWorker::stop() noexcept{
+	{
+		std::lock_guard<std::mutex> _(this->wake_mutex);
+		this->stop_requested = true;
+	}
+	this->wake_condition.notify_one();
+
+	if(this->worker_thread.joinable())
+		this->worker_thread.join();
+}
+
+void RenderWorker::run() noexcept{
+	while(not this->stop_requested.load()){
+		try{
+			while((not this->stop_requested.load()) and this->render_block());
+
+			std::unique_lock<std::mutex> wake_lock(this->wake_mutex);
+			this->wake_condition.wait_for(wake_lock, this->idle_timeout, [this]{
+				return this->wake_requested or this->stop_requested.load();
+			});
+			this->wake_requested = false;
+		}
+		catch(const std::exception& excp){
+			ui::print_to_infobar(std::string("RenderWorker::run(): ") + excp.what(), UIColorPair_Error);
+		}
+		catch(...){
+			ui::print_to_infobar("RenderWorker::run(): uncaught throw.", UIColorPair_Error);
+		}
+	}
+}
@@ -0,0 +1,57 @@
+/**
+\file RenderWorker.hpp
+A long-lived thread which renders blocks of audio whenever it is woken up.
+*/
+
+#ifndef RenderWorker_hpp
+#define RenderWorker_hpp
+
+#include <mutex>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+
+/**
+A persistent render thread, replacing spawning a new std::thread for every block rendered.
+
+The worker calls its render function until it reports there is nothing left to render,
+then sleeps until RenderWorker::wake() is called or the idle timeout passes, whichever comes first.
+The idle timeout guarantees progress even if a wake up is missed.
+*/
+class RenderWorker{
+	public:
+	/**
+	Starts the worker thread.
+
+	\param[in] render_block Renders a single block, returns false if there was nothing to render.
+	\param[in] idle_timeout The longest time the worker sleeps without being woken up.
+	*/
+	RenderWorker(std::function<bool()> render_block, const std::chrono::microseconds idle_timeout);
+	///Stops and joins the worker thread.
+	~RenderWorker();
+
+	RenderWorker(const RenderWorker&) = delete;
+	RenderWorker& operator=(const RenderWorker&) = delete;
+
+	///Wakes the worker up to render. Does nothing if the worker is already rendering.
+	void wake() noexcept;
+	///Asks the worker to finish its current block and joins it. Safe to be called more than once.
+	void stop() noexcept;
+
+	private:
+	void run() noexcept;
+
+	std::function<bool()> render_block;
+	const std::chrono::microseconds idle_timeout;
+
+	std::mutex wake_mutex;
+	std::condition_variable wake_condition;
+	bool wake_requested = false;
+	std::atomic_bool stop_requested = false;
+
+	std::thread worker_thread;
+};
+
+#endif
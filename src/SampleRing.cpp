@@ -0,0 +1,62 @@
+#include "SampleRing.hpp"
+
+#include <cstring>
+#include <algorithm>
+
+SampleRing::SampleRing(const std::size_t minimum_capacity)
+:	capacity(round_up_to_power_of_2(minimum_capacity)),
+	index_mask(this->capacity - 1),
+	buffer(new float[this->capacity])
+{
+	std::memset(this->buffer.get(), 0, this->capacity * sizeof(float));
+}
+
+std::size_t SampleRing::write(const float* const samples, const std::size_t sample_count) noexcept{
+	const std::size_t current_write_index = this->write_index.load(std::memory_order_relaxed);
+	const std::size_t current_read_index = this->read_index.load(std::memory_order_acquire);
+
+	const std::size_t samples_to_write = std::min(sample_count, this->capacity - (current_write_index - current_read_index));
+	const std::size_t buffer_offset = current_write_index & this->index_mask;
+	//The write may wrap around the end of the buffer, so it is copied in two parts.
+	const std::size_t samples_before_wrap = std::min(samples_to_write, this->capacity - buffer_offset);
+
+	std::memcpy(this->buffer.get() + buffer_offset, samples, samples_before_wrap * sizeof(float));
+	std::memcpy(this->buffer.get(), samples + samples_before_wrap, (samples_to_write - samples_before_wrap) * sizeof(float));
+
+	this->write_index.store(current_write_index + samples_to_write, std::memory_order_release);
+	return samples_to_write;
+}
+
+std::size_t SampleRing::read(float* const samples, const std::size_t sample_count) noexcept{
+	const std::size_t current_read_index = this->read_index.load(std::memory_order_relaxed);
+	const std::size_t current_write_index = this->write_index.load(std::memory_order_acquire);
+
+	const std::size_t samples_to_read = std::min(sample_count, current_write_index - current_read_index);
+	const std::size_t buffer_offset = current_read_index & this->index_mask;
+	const std::size_t samples_before_wrap = std::min(samples_to_read, this->capacity - buffer_offset);
+
+	std::memcpy(samples, this->buffer.get() + buffer_offset, samples_before_wrap * sizeof(float));
+	std::memcpy(samples + samples_before_wrap, this->buffer.get(), (samples_to_read - samples_before_wrap) * sizeof(float));
+
+	this->read_index.store(current_read_index + samples_to_read, std::memory_order_release);
+	return samples_to_read;
+}
+
+void SampleRing::discard_readable() noexcept{
+	this->read_index.store(this->write_index.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+std::size_t SampleRing::readable_samples() const noexcept{
+	return this->write_index.load(std::memory_order_acquire) - this->read_index.load(std::memory_order_acquire);
+}
+
+std::size_t SampleRing::writable_samples() const noexcept{
+	return this->capacity - this->readable_samples();
+}
+
+std::size_t SampleRing::round_up_to_power_of_2(const std::size_t value) noexcept{
+	std::size_t power_of_2 = 1;
+	while(power_of_2 < value)
+		power_of_2 <<= 1;
+	return power_of_2;
+}
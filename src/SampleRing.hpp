@@ -0,0 +1,63 @@
+/**
+\file SampleRing.hpp
+A wait-free single-producer/single-consumer ring buffer of stdaud samples.
+*/
+
+#ifndef SampleRing_hpp
+#define SampleRing_hpp
+
+#include <atomic>
+#include <memory>
+#include <cstddef>
+
+/**
+A fixed capacity ring of float samples shared between exactly one producer thread and one consumer thread.
+
+Neither side ever locks, sleeps or allocates: the producer publishes with SampleRing::write()
+and the consumer drains with SampleRing::read(), each of which only moves as many samples as currently fit.
+
+The read and write indices run freely and are masked on access, so the capacity is always a power of 2.
+*/
+class SampleRing{
+	public:
+	///Allocates the ring with at least *minimum_capacity* samples, rounded up to a power of 2.
+	SampleRing(const std::size_t minimum_capacity);
+
+	SampleRing(const SampleRing&) = delete;
+	SampleRing& operator=(const SampleRing&) = delete;
+
+	/**
+	Copies up to *sample_count* samples from *samples* into the ring. Producer only.
+	Returns the amount of samples actually written, which is less than *sample_count* if the ring is full.
+	*/
+	std::size_t write(const float* const samples, const std::size_t sample_count) noexcept;
+	/**
+	Copies up to *sample_count* samples from the ring into *samples*. Consumer only.
+	Returns the amount of samples actually read, which is less than *sample_count* if the ring ran dry.
+	*/
+	std::size_t read(float* const samples, const std::size_t sample_count) noexcept;
+	///Drops every sample currently readable. Consumer only.
+	void discard_readable() noexcept;
+
+	///The amount of samples the consumer can read right now.
+	std::size_t readable_samples() const noexcept;
+	///The amount of samples the producer can write right now.
+	std::size_t writable_samples() const noexcept;
+
+	std::size_t get_capacity() const noexcept{
+		return this->capacity;
+	}
+
+	private:
+	static std::size_t round_up_to_power_of_2(const std::size_t value) noexcept;
+
+	const std::size_t capacity;
+	const std::size_t index_mask;
+	std::unique_ptr<float[]> buffer;
+
+	//Kept on separate cache lines so the producer and consumer do not invalidate each other's index.
+	alignas(64) std::atomic<std::size_t> write_index = 0;
+	alignas(64) std::atomic<std::size_t> read_index = 0;
+};
+
+#endif
@@ -16,13 +16,15 @@ void serial_listener(serial::Serial& arduino_serial, GlobalStates& global_states
 	while(not global_states.requested_exit.load()){
 		try{
 			std::vector<std::unique_ptr<Sensor>> sensors;
-			sensors.reserve(12);
+			sensors.reserve(12 + (hot_cue_count * 2));
 			sensors.emplace_back(std::make_unique<Button>(SensorID_left_playpause_button));
 			sensors.emplace_back(std::make_unique<Button>(SensorID_left_cue_button));
 			sensors.emplace_back(std::make_unique<Sensor>(SensorID_left_tempo_poten));
 			sensors.emplace_back(std::make_unique<RotaryEncoder>(SensorID_left_jogdial_rotaryenc));
 			sensors.emplace_back(std::make_unique<Button>(SensorID_left_loop_in_button));
 			sensors.emplace_back(std::make_unique<Button>(SensorID_left_loop_out_button));
+			for(std::uint8_t hot_cue_index = 0; hot_cue_index < hot_cue_count; hot_cue_index++)
+				sensors.emplace_back(std::make_unique<Button>(SensorID_left_hot_cue_1_button + hot_cue_index));
 			
 			sensors.emplace_back(std::make_unique<Button>(SensorID_right_playpause_button));
 			sensors.emplace_back(std::make_unique<Button>(SensorID_right_cue_button));
@@ -30,6 +32,8 @@ void serial_listener(serial::Serial& arduino_serial, GlobalStates& global_states
 			sensors.emplace_back(std::make_unique<RotaryEncoder>(SensorID_right_jogdial_rotaryenc));
 			sensors.emplace_back(std::make_unique<Button>(SensorID_right_loop_in_button));
 			sensors.emplace_back(std::make_unique<Button>(SensorID_right_loop_out_button));
+			for(std::uint8_t hot_cue_index = 0; hot_cue_index < hot_cue_count; hot_cue_index++)
+				sensors.emplace_back(std::make_unique<Button>(SensorID_right_hot_cue_1_button + hot_cue_index));
 			
 			std::string buffer;
 			std::thread sensor_translating_thread(_translate_sensor_changes, std::ref(sensors), std::ref(global_states));
@@ -95,10 +99,11 @@ std::optional<std::int16_t> _read_sensor(const std::vector<std::unique_ptr<Senso
 }
 
 void _translate_sensor_changes(std::vector<std::unique_ptr<Sensor>>& sensors, GlobalStates& global_states){
-	const std::unique_ptr<AudioTrack>& left_deck = global_states.audio_tracks[0];
-	const std::unique_ptr<AudioTrack>& right_deck = global_states.audio_tracks[1];
-	
 	while(not global_states.requested_exit.load()){
+		//Each side of the controller can be switched to any deck with the c(ontrol) command.
+		const std::unique_ptr<AudioTrack>& left_deck = global_states.audio_tracks[global_states.left_controlled_deck.load()];
+		const std::unique_ptr<AudioTrack>& right_deck = global_states.audio_tracks[global_states.right_controlled_deck.load()];
+		
 		for(auto& sensor : sensors){
 			std::lock_guard<std::mutex> current_sensor_access(sensor->access_mutex);
 			if(not sensor->value_changed()) continue;
@@ -106,7 +111,7 @@ void _translate_sensor_changes(std::vector<std::unique_ptr<Sensor>>& sensors, Gl
 			switch(sensor->sensor_id){
 				case SensorID_left_playpause_button:
 					if(sensor->value == ButtonState_Released){
-						if(!global_states.audio_tracks[0]->toggle_play_pause())
+						if(!left_deck->toggle_play_pause())
 							ui::print_to_infobar("SerialInterface: _translate_sensor_changes(): mutex error.", UIColorPair_Error);
 					}
 					break;
@@ -230,6 +235,18 @@ void _translate_sensor_changes(std::vector<std::unique_ptr<Sensor>>& sensors, Gl
 				case SensorID_right_loop_out_button:
 					if(sensor->value == ButtonState_Released) right_deck->cancel_loop();
 					break;
+					
+				//Hot cues act on the press rather than the release, so the jump lands where the button was hit.
+				default:{
+					if(sensor->value != ButtonState_Pressed) break;
+					const std::int16_t left_hot_cue_index = sensor->sensor_id - SensorID_left_hot_cue_1_button;
+					const std::int16_t right_hot_cue_index = sensor->sensor_id - SensorID_right_hot_cue_1_button;
+					if(left_hot_cue_index >= 0 and left_hot_cue_index < hot_cue_count)
+						left_deck->press_hot_cue(left_hot_cue_index);
+					else if(right_hot_cue_index >= 0 and right_hot_cue_index < hot_cue_count)
+						right_deck->press_hot_cue(right_hot_cue_index);
+					break;
+				}
 			}
 		}
 	}
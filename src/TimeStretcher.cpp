@@ -0,0 +1,153 @@
+#include "TimeStretcher.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+///4 independent sums, so the multiply-adds do not wait on each other.
+static float dot_product(const float* const a, const float* const b, const std::uint32_t count) noexcept{
+	float sums[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+	std::uint32_t i = 0;
+	for(; i + 4 <= count; i += 4){
+		sums[0] += a[i] * b[i];
+		sums[1] += a[i+1] * b[i+1];
+		sums[2] += a[i+2] * b[i+2];
+		sums[3] += a[i+3] * b[i+3];
+	}
+	for(; i < count; i++)
+		sums[0] += a[i] * b[i];
+	return (sums[0] + sums[1]) + (sums[2] + sums[3]);
+}
+
+TimeStretcher::TimeStretcher()
+:	window(segment_frames),
+	segment_source(source_frames_per_segment * 2),
+	overlapped_output(segment_frames * 2),
+	reference(hop_frames),
+	decimated_reference(hop_frames / decimation_factor),
+	decimated_segment_source(source_frames_per_segment / decimation_factor)
+{
+	const double pi = std::acos(-1.0);
+	for(std::uint32_t frame = 0; frame < segment_frames; frame++)
+		this->window[frame] = 0.5 - (0.5 * std::cos(2.0 * pi * frame / segment_frames));
+}
+
+void TimeStretcher::reset() noexcept{
+	std::memset(this->overlapped_output.data(), 0, this->overlapped_output.size() * sizeof(float));
+	this->rendered_hop_frames = hop_frames;
+	this->has_reference = false;
+}
+
+std::int64_t TimeStretcher::next_segment_first_frame(const PlayheadRamp& playhead) const noexcept{
+	//The centre of the segment is heard get_latency_frames() output frames from now, by when the playhead has moved on by its speed.
+	const double segment_centre = playhead.position + (playhead.speed * get_latency_frames());
+	return std::llround(segment_centre) - (std::int64_t)(segment_frames / 2) - (std::int64_t)search_frames;
+}
+
+std::uint32_t TimeStretcher::render(const SourceSpan& source, PlayheadRamp& playhead, float* const output, const std::uint32_t frame_count, const double end_position) noexcept{
+	std::uint32_t rendered_frames = 0;
+	while(rendered_frames < frame_count){
+		if(this->rendered_hop_frames == hop_frames){
+			if(not this->add_segment(source, this->next_segment_first_frame(playhead)))
+				break;
+		}
+
+		const float* const hop_output = this->overlapped_output.data();
+		for(; rendered_frames < frame_count and this->rendered_hop_frames < hop_frames; rendered_frames++, this->rendered_hop_frames++){
+			if(playhead.position >= end_position) return rendered_frames;
+			output[rendered_frames*2] = hop_output[this->rendered_hop_frames*2];
+			output[rendered_frames*2 + 1] = hop_output[this->rendered_hop_frames*2 + 1];
+			playhead.position += playhead.speed;
+			playhead.speed += playhead.speed_step;
+		}
+	}
+	return rendered_frames;
+}
+
+bool TimeStretcher::add_segment(const SourceSpan& source, const std::int64_t first_frame) noexcept{
+	const std::int64_t end_frame = first_frame + source_frames_per_segment;
+	const bool source_begins_at_track_start = source.first_frame == 0;
+	const bool source_holds_segment = (first_frame >= (std::int64_t)source.first_frame or source_begins_at_track_start)
+										and end_frame <= (std::int64_t)source.end_frame();
+	if(not source_holds_segment) return false;
+
+	//Frames before the start of the track are silent.
+	float* const segment_source = this->segment_source.data();
+	const std::uint32_t silent_frames = first_frame < 0 ? std::min<std::int64_t>(-first_frame, source_frames_per_segment) : 0;
+	std::memset(segment_source, 0, silent_frames * 2 * sizeof(float));
+	std::memcpy(segment_source + (silent_frames * 2), source.datapoints + ((first_frame + silent_frames - source.first_frame) * 2),
+				(source_frames_per_segment - silent_frames) * 2 * sizeof(float));
+
+	const std::uint32_t segment_offset = this->has_reference ? this->find_best_segment_offset() : search_frames;
+	const float* const segment = segment_source + (segment_offset * 2);
+
+	//The first half of the last segment was already rendered, its second half becomes the first half of the output.
+	float* const overlapped_output = this->overlapped_output.data();
+	std::memmove(overlapped_output, overlapped_output + (hop_frames * 2), hop_frames * 2 * sizeof(float));
+	std::memset(overlapped_output + (hop_frames * 2), 0, hop_frames * 2 * sizeof(float));
+
+	for(std::uint32_t frame = 0; frame < segment_frames; frame++){
+		//Nothing overlaps the first half of the first segment after a reset, so it is not faded in.
+		const float gain = (not this->has_reference and frame < hop_frames) ? 1.0f : this->window[frame];
+		overlapped_output[frame*2] += segment[frame*2] * gain;
+		overlapped_output[frame*2 + 1] += segment[frame*2 + 1] * gain;
+	}
+
+	//The second half of the segment, as it would continue without the next segment shifting, is what the next segment is aligned to.
+	for(std::uint32_t frame = 0; frame < hop_frames; frame++)
+		this->reference[frame] = segment[(hop_frames + frame)*2] + segment[(hop_frames + frame)*2 + 1];
+	for(std::uint32_t i = 0; i < this->decimated_reference.size(); i++)
+		this->decimated_reference[i] = this->reference[i * decimation_factor];
+
+	this->has_reference = true;
+	this->rendered_hop_frames = 0;
+	return true;
+}
+
+std::uint32_t TimeStretcher::find_best_segment_offset() noexcept{
+	const float* const segment_source = this->segment_source.data();
+	float* const decimated_segment_source = this->decimated_segment_source.data();
+	for(std::uint32_t i = 0; i < this->decimated_segment_source.size(); i++)
+		decimated_segment_source[i] = segment_source[i * decimation_factor * 2] + segment_source[i * decimation_factor * 2 + 1];
+
+	//Scored by normalised cross-correlation, so a louder candidate is not preferred over a better aligned one.
+	constexpr float energy_floor = 1e-9f;
+	constexpr std::uint32_t decimated_hop = hop_frames / decimation_factor;
+	constexpr std::uint32_t decimated_offsets = (search_frames * 2) / decimation_factor;
+
+	std::uint32_t best_decimated_offset = search_frames / decimation_factor;
+	float best_score = -INFINITY;
+	float energy = dot_product(decimated_segment_source, decimated_segment_source, decimated_hop);
+	for(std::uint32_t offset = 0; offset <= decimated_offsets; offset++){
+		const float score = dot_product(this->decimated_reference.data(), decimated_segment_source + offset, decimated_hop) / std::sqrt(energy + energy_floor);
+		if(score > best_score){
+			best_score = score;
+			best_decimated_offset = offset;
+		}
+		//Sliding the energy window by one.
+		const float leaving = decimated_segment_source[offset];
+		const float entering = offset + decimated_hop < this->decimated_segment_source.size() ? decimated_segment_source[offset + decimated_hop] : 0.0f;
+		energy += (entering * entering) - (leaving * leaving);
+		if(energy < 0.0f) energy = 0.0f;
+	}
+
+	//Refined at every frame in between the neighbouring coarse offsets.
+	float mono_candidate[hop_frames];
+	const std::int64_t coarse_offset = best_decimated_offset * decimation_factor;
+	const std::int64_t first_offset = std::max<std::int64_t>(0, coarse_offset - (decimation_factor - 1));
+	const std::int64_t last_offset = std::min<std::int64_t>(search_frames * 2, coarse_offset + (decimation_factor - 1));
+
+	std::uint32_t best_offset = coarse_offset;
+	best_score = -INFINITY;
+	for(std::int64_t offset = first_offset; offset <= last_offset; offset++){
+		for(std::uint32_t frame = 0; frame < hop_frames; frame++)
+			mono_candidate[frame] = segment_source[(offset + frame)*2] + segment_source[(offset + frame)*2 + 1];
+		const float candidate_energy = dot_product(mono_candidate, mono_candidate, hop_frames);
+		const float score = dot_product(this->reference.data(), mono_candidate, hop_frames) / std::sqrt(candidate_energy + energy_floor);
+		if(score > best_score){
+			best_score = score;
+			best_offset = offset;
+		}
+	}
+	return best_offset;
+}
@@ -0,0 +1,95 @@
+/**
+\file TimeStretcher.hpp
+*/
+
+#ifndef TimeStretcher_hpp
+#define TimeStretcher_hpp
+
+#include "resampler.hpp"
+#include "AlignedSampleBuffer.hpp"
+
+#include <cstdint>
+
+/**
+A WSOLA (waveform similarity overlap-add) time-stretcher, which plays a track at the speed of a playhead without changing its pitch.
+
+Every TimeStretcher::hop_frames output frames, a Hann windowed segment of TimeStretcher::segment_frames frames
+is copied from the track at the position of the playhead, shifted by up to TimeStretcher::search_frames
+to where it best continues the previous segment, and overlap-added at 50% with the previous one.
+The track is never resampled, so the pitch stays at 1x whatever the speed.
+
+The cost of a segment is fixed, so the CPU budget of a block only depends on its length and not on the speed or the audio.
+Every buffer is allocated at construction, TimeStretcher::render() does not allocate.
+*/
+class TimeStretcher{
+	public:
+	///The amount of output frames in between segments.
+	static constexpr std::uint32_t hop_frames = 1024;
+	static constexpr std::uint32_t segment_frames = hop_frames * 2;
+	///The furthest a segment is shifted from the playhead, in either direction, to line up with the previous segment.
+	static constexpr std::uint32_t search_frames = 512;
+	///The amount of track frames a segment is picked from, and the least a SourceSpan given to TimeStretcher::render() should hold.
+	static constexpr std::uint32_t source_frames_per_segment = segment_frames + (search_frames * 2);
+
+	TimeStretcher();
+
+	TimeStretcher(const TimeStretcher&) = delete;
+	TimeStretcher& operator=(const TimeStretcher&) = delete;
+
+	/**
+	The amount of output frames in between a frame of the track entering a segment and it being at the centre of the output.
+
+	TimeStretcher::render() already reads that far ahead of the playhead at its speed, so the output stays aligned
+	with the playhead (and the beat grid) at any speed; it is exposed for anything mapping the playhead to what is heard.
+	*/
+	static constexpr std::uint32_t get_latency_frames() noexcept{
+		return hop_frames;
+	}
+
+	///Drops every overlapping segment, so the next frame rendered begins from the playhead without fading from what was played before.
+	void reset() noexcept;
+
+	/**
+	The first frame of the track the next segment is picked from, given the playhead it would be picked at.
+	It may be negative at the start of the track, frames before the track are silent.
+	*/
+	std::int64_t next_segment_first_frame(const PlayheadRamp& playhead) const noexcept;
+
+	/**
+	Renders up to *frame_count* interleaved stereo frames to *output* from *source*, advancing *playhead* by its speed every frame.
+
+	Rendering stops early once the playhead reaches *end_position*, or once the next segment needs frames outside of *source*,
+	in which case the caller should provide a span beginning at TimeStretcher::next_segment_first_frame()
+	with at least TimeStretcher::source_frames_per_segment frames and call the function again for the remaining frames.
+
+	Returns the amount of frames written to *output*.
+	*/
+	std::uint32_t render(const SourceSpan& source, PlayheadRamp& playhead, float* const output, const std::uint32_t frame_count, const double end_position) noexcept;
+
+	private:
+	///Copies the frames around the next segment from *source* and overlap-adds the best aligned segment. Returns false if *source* does not hold them.
+	bool add_segment(const SourceSpan& source, const std::int64_t first_frame) noexcept;
+	///Returns the offset into TimeStretcher::segment_source where the segment best continues TimeStretcher::reference.
+	std::uint32_t find_best_segment_offset() noexcept;
+
+	///The Hann window of a segment, which sums to 1 across 2 segments overlapping by half.
+	AlignedSampleBuffer window;
+	///The frames of the track a segment is picked from, stereo.
+	AlignedSampleBuffer segment_source;
+	///The overlap-added output, stereo. The first TimeStretcher::hop_frames frames are complete once a segment is added.
+	AlignedSampleBuffer overlapped_output;
+	///The frames of TimeStretcher::overlapped_output already rendered since the last segment.
+	std::uint32_t rendered_hop_frames = hop_frames;
+
+	///How the last segment would have continued, downmixed to mono, which the next segment is aligned to.
+	AlignedSampleBuffer reference;
+	///Whether TimeStretcher::reference holds anything since the last reset.
+	bool has_reference = false;
+
+	///The search is done coarsely on every decimation_factor frames first, then refined around the best coarse match.
+	static constexpr std::uint32_t decimation_factor = 4;
+	AlignedSampleBuffer decimated_reference;
+	AlignedSampleBuffer decimated_segment_source;
+};
+
+#endif
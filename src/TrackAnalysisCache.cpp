@@ -0,0 +1,397 @@
+#include "TrackAnalysisCache.hpp"
+
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+#include <filesystem>
+#include <system_error>
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+#endif
+
+static constexpr char cache_file_magic[8] = {'a', 'r', 'd', 'c', 'a', 'c', 'h', 'e'};
+///Bumped whenever the layout of cache files changes, discarding the caches written before.
+static constexpr std::uint64_t cache_file_version = 1;
+///The magic, the version and the file id.
+static constexpr std::uint64_t cache_header_bytes = sizeof(cache_file_magic) + 8 + 8;
+///The payload size and checksum every record begins with.
+static constexpr std::uint64_t record_header_bytes = 8 + 8;
+///The serialised size of a WaveformBin.
+static constexpr std::uint64_t waveform_bin_bytes = 3;
+
+TrackMetadata make_track_metadata(const TrackAnalysis& analysis){
+	TrackMetadata metadata;
+	metadata.frame_count = analysis.frame_count;
+	if(analysis.beats.has_value() and analysis.beats->is_confident())
+		metadata.beat_grid = std::make_shared<const BeatGrid>(analysis.beats->first_beat_frame, analysis.beats->bpm);
+	metadata.integrated_loudness = analysis.integrated_loudness;
+	metadata.waveform = std::make_shared<const WaveformPyramid>(analysis.waveform);
+	return metadata;
+}
+
+///FNV-1a of *bytes*, which catches a record torn or overwritten in the middle.
+static std::uint64_t get_checksum(const unsigned char* const bytes, const std::uint64_t byte_count) noexcept{
+	std::uint64_t checksum = 0xcbf29ce484222325;
+	for(std::uint64_t i = 0; i < byte_count; i++){
+		checksum ^= bytes[i];
+		checksum *= 0x100000001b3;
+	}
+	return checksum;
+}
+
+template<typename T>
+static void append_value(std::string& bytes, const T value){
+	const std::size_t offset = bytes.size();
+	bytes.resize(offset + sizeof(T));
+	std::memcpy(bytes.data() + offset, &value, sizeof(T));
+}
+
+///Reads values of a record one after another, never past its end.
+struct RecordReader{
+	const unsigned char* position;
+	const unsigned char* const end;
+
+	template<typename T>
+	bool read(T& value) noexcept{
+		if(std::uint64_t(this->end - this->position) < sizeof(T)) return false;
+		std::memcpy(&value, this->position, sizeof(T));
+		this->position += sizeof(T);
+		return true;
+	}
+	bool read_bytes(const std::uint64_t byte_count, const unsigned char*& bytes) noexcept{
+		if(std::uint64_t(this->end - this->position) < byte_count) return false;
+		bytes = this->position;
+		this->position += byte_count;
+		return true;
+	}
+	///Reads a count of elements of *element_bytes* each, rejecting counts larger than what is left of the record.
+	bool read_count(std::uint64_t& count, const std::uint64_t element_bytes) noexcept{
+		return this->read(count) and count <= std::uint64_t(this->end - this->position) / element_bytes;
+	}
+};
+
+TrackAnalysisCache::TrackAnalysisCache(const std::string& cache_filename)
+:	cache_filename(cache_filename)
+{
+	std::lock_guard<std::mutex> _(this->cache_mutex);
+	this->remap();
+	const bool wasteful = this->replaced_bytes * 2 > this->indexed_bytes;
+	const bool has_torn_record = this->mapped_bytes > this->indexed_bytes;
+	if(this->mapping != nullptr and (wasteful or has_torn_record))
+		this->rewrite_compacted();
+}
+
+TrackAnalysisCache::~TrackAnalysisCache(){
+	this->unmap();
+}
+
+std::optional<std::pair<std::string, TrackAnalysisCache::TrackKey>> TrackAnalysisCache::get_track_key(const std::string& aud_filename){
+	std::error_code error;
+	std::filesystem::path path = std::filesystem::weakly_canonical(aud_filename, error);
+	if(error){
+		error.clear();
+		path = std::filesystem::absolute(aud_filename, error);
+		if(error) return std::nullopt;
+	}
+
+	TrackKey key;
+	key.file_size = std::filesystem::file_size(path, error);
+	if(error) return std::nullopt;
+	key.file_modified_time = std::filesystem::last_write_time(path, error).time_since_epoch().count();
+	if(error) return std::nullopt;
+	key.audio_info_modified_time = std::filesystem::last_write_time(get_audio_info_filename(aud_filename), error).time_since_epoch().count();
+	if(error) key.audio_info_modified_time = no_audio_info_file;
+	return std::make_pair(path.string(), key);
+}
+
+std::optional<TrackMetadata> TrackAnalysisCache::lookup(const std::string& aud_filename){
+	const std::optional<std::pair<std::string, TrackKey>> path_key = get_track_key(aud_filename);
+	if(not path_key.has_value()) return std::nullopt;
+	const TrackKey& key = path_key->second;
+
+	std::lock_guard<std::mutex> _(this->cache_mutex);
+	//Another process may have appended records, or replaced the file, since it was mapped.
+	std::error_code error;
+	const std::uintmax_t cache_file_bytes = std::filesystem::file_size(this->cache_filename, error);
+	if(not error and cache_file_bytes != this->mapped_bytes) this->remap();
+
+	const auto record = this->records.find(path_key->first);
+	if(record == this->records.end()) return std::nullopt;
+
+	RecordReader reader{this->mapping + record->second.offset, this->mapping + record->second.offset + record->second.bytes};
+	std::uint64_t payload_bytes, checksum;
+	if(not reader.read(payload_bytes) or not reader.read(checksum)) return std::nullopt;
+	if(payload_bytes > std::uint64_t(reader.end - reader.position)) return std::nullopt;
+	if(get_checksum(reader.position, payload_bytes) != checksum) return std::nullopt;
+
+	std::uint64_t path_bytes;
+	const unsigned char* path;
+	TrackKey record_key;
+	if(not reader.read_count(path_bytes, 1) or not reader.read_bytes(path_bytes, path)) return std::nullopt;
+	if(not reader.read(record_key.file_size) or not reader.read(record_key.file_modified_time) or not reader.read(record_key.audio_info_modified_time))
+		return std::nullopt;
+	const bool stale = record_key.file_size != key.file_size
+						or record_key.file_modified_time != key.file_modified_time
+						or record_key.audio_info_modified_time != key.audio_info_modified_time;
+	if(stale) return std::nullopt;
+
+	TrackMetadata metadata;
+	double integrated_loudness;
+	if(not reader.read(metadata.frame_count) or not reader.read(integrated_loudness)) return std::nullopt;
+	if(not std::isnan(integrated_loudness)) metadata.integrated_loudness = integrated_loudness;
+
+	std::uint64_t segment_count;
+	if(not reader.read_count(segment_count, sizeof(double) * 2)) return std::nullopt;
+	if(segment_count > 0){
+		std::vector<BeatGrid::Segment> segments(segment_count);
+		for(BeatGrid::Segment& segment : segments){
+			if(not reader.read(segment.first_beat_frame) or not reader.read(segment.frames_per_beat)) return std::nullopt;
+		}
+		try{
+			metadata.beat_grid = std::make_shared<const BeatGrid>(std::move(segments));
+		}
+		catch(const std::invalid_argument&){
+			return std::nullopt;
+		}
+	}
+
+	std::uint64_t cue_point_count;
+	if(not reader.read_count(cue_point_count, sizeof(double))) return std::nullopt;
+	metadata.cue_points.resize(cue_point_count);
+	for(double& cue_point : metadata.cue_points){
+		if(not reader.read(cue_point)) return std::nullopt;
+	}
+
+	std::uint64_t level_count;
+	if(not reader.read_count(level_count, sizeof(std::uint64_t))) return std::nullopt;
+	if(level_count > 0){
+		std::vector<std::vector<WaveformBin>> levels(level_count);
+		for(std::vector<WaveformBin>& level : levels){
+			std::uint64_t bin_count;
+			const unsigned char* bins;
+			if(not reader.read_count(bin_count, waveform_bin_bytes) or not reader.read_bytes(bin_count * waveform_bin_bytes, bins)) return std::nullopt;
+			level.resize(bin_count);
+			for(std::uint64_t bin = 0; bin < bin_count; bin++){
+				const unsigned char* const bin_bytes = bins + (bin * waveform_bin_bytes);
+				level[bin] = WaveformBin{std::int8_t(bin_bytes[0]), std::int8_t(bin_bytes[1]), std::uint8_t(bin_bytes[2])};
+			}
+		}
+		metadata.waveform = std::make_shared<const WaveformPyramid>(std::move(levels), metadata.frame_count);
+	}
+	return metadata;
+}
+
+bool TrackAnalysisCache::store(const std::string& aud_filename, const TrackMetadata& metadata){
+	const std::optional<std::pair<std::string, TrackKey>> path_key = get_track_key(aud_filename);
+	if(not path_key.has_value()) return false;
+	const std::string& path = path_key->first;
+	const TrackKey& key = path_key->second;
+
+	std::string payload;
+	append_value<std::uint64_t>(payload, path.size());
+	payload += path;
+	append_value(payload, key.file_size);
+	append_value(payload, key.file_modified_time);
+	append_value(payload, key.audio_info_modified_time);
+	append_value(payload, metadata.frame_count);
+	append_value(payload, metadata.integrated_loudness.value_or(NAN));
+
+	const std::vector<BeatGrid::Segment>& segments = metadata.beat_grid->get_segments();
+	append_value<std::uint64_t>(payload, segments.size());
+	for(const BeatGrid::Segment& segment : segments){
+		append_value(payload, segment.first_beat_frame);
+		append_value(payload, segment.frames_per_beat);
+	}
+
+	append_value<std::uint64_t>(payload, metadata.cue_points.size());
+	for(const double cue_point : metadata.cue_points) append_value(payload, cue_point);
+
+	const std::size_t level_count = metadata.waveform ? metadata.waveform->get_level_count() : 0;
+	append_value<std::uint64_t>(payload, level_count);
+	for(std::size_t level = 0; level < level_count; level++){
+		const std::vector<WaveformBin>& bins = metadata.waveform->get_level(level);
+		append_value<std::uint64_t>(payload, bins.size());
+		for(const WaveformBin& bin : bins){
+			payload.push_back(char(bin.min));
+			payload.push_back(char(bin.max));
+			payload.push_back(char(bin.rms));
+		}
+	}
+
+	std::string record;
+	record.reserve(record_header_bytes + payload.size());
+	append_value<std::uint64_t>(record, payload.size());
+	append_value(record, get_checksum((const unsigned char*)payload.data(), payload.size()));
+	record += payload;
+
+	std::lock_guard<std::mutex> _(this->cache_mutex);
+	this->remap();
+	//A record appended after a torn one would never be indexed, and a missing or outdated file needs its header first.
+	if(this->mapping == nullptr or this->mapped_bytes > this->indexed_bytes){
+		if(not this->rewrite_compacted()) return false;
+	}
+
+	{
+		std::ofstream cache_file(this->cache_filename, std::ios::binary | std::ios::app);
+		if(not cache_file) return false;
+		cache_file.write(record.data(), record.size());
+		if(not cache_file.flush()) return false;
+	}
+	this->remap();
+	return this->records.count(path) > 0;
+}
+
+void TrackAnalysisCache::remap(){
+	this->unmap();
+
+	#ifdef _WIN32
+	//Shared for writing and deleting, so another process can append to or replace the file while it is mapped here.
+	HANDLE file = CreateFileA(this->cache_filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+								NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	//The file was deleted, nothing indexed from it can be read anymore.
+	if(file == INVALID_HANDLE_VALUE){
+		this->forget_records();
+		return;
+	}
+	LARGE_INTEGER file_size;
+	if(GetFileSizeEx(file, &file_size) and file_size.QuadPart > 0){
+		HANDLE file_mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if(file_mapping != NULL){
+			//The view keeps the mapping alive after its handles are closed.
+			void* const view = MapViewOfFile(file_mapping, FILE_MAP_READ, 0, 0, 0);
+			if(view != NULL){
+				this->mapping = (const unsigned char*)view;
+				this->mapped_bytes = file_size.QuadPart;
+			}
+			CloseHandle(file_mapping);
+		}
+	}
+	CloseHandle(file);
+	#else
+	const int file_descriptor = open(this->cache_filename.c_str(), O_RDONLY);
+	//The file was deleted, nothing indexed from it can be read anymore.
+	if(file_descriptor == -1){
+		this->forget_records();
+		return;
+	}
+	struct stat file_status;
+	if(fstat(file_descriptor, &file_status) == 0 and file_status.st_size > 0){
+		void* const mapped = mmap(nullptr, file_status.st_size, PROT_READ, MAP_SHARED, file_descriptor, 0);
+		if(mapped != MAP_FAILED){
+			this->mapping = (const unsigned char*)mapped;
+			this->mapped_bytes = file_status.st_size;
+		}
+	}
+	close(file_descriptor);
+	#endif
+
+	const bool valid_header = this->mapped_bytes >= cache_header_bytes
+								and std::memcmp(this->mapping, cache_file_magic, sizeof(cache_file_magic)) == 0
+								and std::memcmp(this->mapping + sizeof(cache_file_magic), &cache_file_version, 8) == 0;
+	if(not valid_header){
+		//Treated as no file, which the next TrackAnalysisCache::store() replaces.
+		this->unmap();
+		this->forget_records();
+		return;
+	}
+
+	std::uint64_t mapped_file_id;
+	std::memcpy(&mapped_file_id, this->mapping + sizeof(cache_file_magic) + 8, 8);
+	//Another file replaced the one indexed, or it was truncated; nothing indexed before can be trusted.
+	if(mapped_file_id != this->file_id or this->mapped_bytes < this->indexed_bytes){
+		this->records.clear();
+		this->file_id = mapped_file_id;
+		this->indexed_bytes = cache_header_bytes;
+		this->replaced_bytes = 0;
+	}
+	this->index_records(this->indexed_bytes);
+}
+
+void TrackAnalysisCache::unmap() noexcept{
+	if(this->mapping == nullptr) return;
+	#ifdef _WIN32
+	UnmapViewOfFile(this->mapping);
+	#else
+	munmap((void*)this->mapping, this->mapped_bytes);
+	#endif
+	this->mapping = nullptr;
+	this->mapped_bytes = 0;
+}
+
+void TrackAnalysisCache::forget_records() noexcept{
+	this->records.clear();
+	this->file_id = 0;
+	this->indexed_bytes = 0;
+	this->replaced_bytes = 0;
+}
+
+void TrackAnalysisCache::index_records(std::uint64_t offset){
+	while(this->mapped_bytes - offset >= record_header_bytes){
+		RecordReader reader{this->mapping + offset, this->mapping + this->mapped_bytes};
+		std::uint64_t payload_bytes, checksum, path_bytes;
+		const unsigned char* path;
+		if(not reader.read(payload_bytes) or not reader.read(checksum)) break;
+		//A record running past the end of the file was torn, nothing after it is read.
+		if(payload_bytes > std::uint64_t(reader.end - reader.position)) break;
+		RecordReader payload_reader{reader.position, reader.position + payload_bytes};
+		if(not payload_reader.read_count(path_bytes, 1) or not payload_reader.read_bytes(path_bytes, path)) break;
+
+		const RecordLocation location{offset, record_header_bytes + payload_bytes};
+		const auto [record, inserted] = this->records.try_emplace(std::string((const char*)path, path_bytes), location);
+		if(not inserted){
+			this->replaced_bytes += record->second.bytes;
+			record->second = location;
+		}
+		offset += location.bytes;
+	}
+	this->indexed_bytes = offset;
+}
+
+bool TrackAnalysisCache::rewrite_compacted(){
+	const std::string temporary_filename = this->cache_filename + ".tmp";
+	std::uint64_t new_file_id = std::random_device()();
+	new_file_id = (new_file_id << 32) ^ std::uint64_t(std::chrono::steady_clock::now().time_since_epoch().count());
+
+	{
+		std::ofstream temporary_file(temporary_filename, std::ios::binary | std::ios::trunc);
+		if(not temporary_file) return false;
+		temporary_file.write(cache_file_magic, sizeof(cache_file_magic));
+		temporary_file.write((const char*)&cache_file_version, 8);
+		temporary_file.write((const char*)&new_file_id, 8);
+
+		//Kept in the order they were appended, so the file reads the same as before without the replaced records.
+		std::vector<RecordLocation> live_records;
+		live_records.reserve(this->records.size());
+		for(const auto& record : this->records) live_records.push_back(record.second);
+		std::sort(live_records.begin(), live_records.end(), [](const RecordLocation& a, const RecordLocation& b){
+			return a.offset < b.offset;
+		});
+		//Without a mapping there is nothing to copy, the file starts over with its header only.
+		if(this->mapping == nullptr) live_records.clear();
+		for(const RecordLocation& record : live_records)
+			temporary_file.write((const char*)(this->mapping + record.offset), record.bytes);
+		if(not temporary_file.flush()) return false;
+	}
+
+	//Windows cannot replace a mapped file.
+	this->unmap();
+	std::error_code rename_error;
+	std::filesystem::rename(temporary_filename, this->cache_filename, rename_error);
+	if(rename_error){
+		std::filesystem::remove(temporary_filename, rename_error);
+		this->remap();
+		return false;
+	}
+	this->remap();
+	return true;
+}
@@ -0,0 +1,127 @@
+/**
+\file TrackAnalysisCache.hpp
+*/
+
+#ifndef TrackAnalysisCache_hpp
+#define TrackAnalysisCache_hpp
+
+#include "BeatGrid.hpp"
+#include "WaveformPyramid.hpp"
+#include "track_analysis.hpp"
+
+#include <mutex>
+#include <memory>
+#include <string>
+#include <vector>
+#include <limits>
+#include <cstdint>
+#include <utility>
+#include <optional>
+#include <unordered_map>
+
+///Everything known about a track besides its audio, as kept in a TrackAnalysisCache.
+struct TrackMetadata{
+	///The length of the track in stdaud frames, 0 if it was never analysed.
+	std::uint64_t frame_count = 0;
+	///Never nullptr, empty if the track has no bpm.
+	std::shared_ptr<const BeatGrid> beat_grid = std::make_shared<const BeatGrid>();
+	///The integrated loudness in LUFS, std::nullopt if unknown or silent.
+	std::optional<double> integrated_loudness;
+	///The stdaud frames of the hot cues of the track in order, see get_hot_cues().
+	std::vector<double> cue_points;
+	///nullptr if the track was never analysed.
+	std::shared_ptr<const WaveformPyramid> waveform;
+};
+
+///The TrackMetadata of a track analysed by analyse_track(), without cue points, and without beats unless they are BeatEstimate::is_confident().
+TrackMetadata make_track_metadata(const TrackAnalysis& analysis);
+
+/**
+The TrackMetadata of every track analysed before, in a single file memory-mapped for reading,
+so loading a track fetches all of its analysis with one lookup instead of parsing its audio info file.
+
+The file is a header followed by records, each holding the metadata of one track along with its key:
+the absolute path of the track, its size and modification time, and the modification time of its audio info file,
+so a track or an audio info file changed since its record was written misses the cache rather than using stale data.
+Records are only ever appended, the latest record of a track replacing earlier ones;
+the file is compacted when it is opened if replaced records take up more than half of it, or it ends in a torn record.
+
+Only the path of every record is read when the file is opened, to index the records by path.
+The rest of a record is only read when it is looked up, and checked against its checksum then.
+Numbers are stored in the byte order of the machine, as the file is only a cache: a file from another version is discarded.
+
+Every method can be called from any thread. Several processes may read the same file,
+a record appended by another process is found once the file is seen to have grown.
+Two processes appending at the same time may tear a record, which ends the file at that record.
+*/
+class TrackAnalysisCache{
+	public:
+	///Kept in the working directory, which both ardcont and analyse.exe run from.
+	static constexpr const char* default_filename = "ardcont_analysis_cache.bin";
+
+	///Opens and indexes *cache_filename* if it exists, which is otherwise created by the first TrackAnalysisCache::store().
+	explicit TrackAnalysisCache(const std::string& cache_filename = default_filename);
+	///Unmaps the file.
+	~TrackAnalysisCache();
+
+	TrackAnalysisCache(const TrackAnalysisCache&) = delete;
+	TrackAnalysisCache& operator=(const TrackAnalysisCache&) = delete;
+
+	/**
+	The metadata stored for *aud_filename*, std::nullopt if there is none,
+	or the track or its audio info file changed since it was stored, or the record is corrupt.
+	*/
+	std::optional<TrackMetadata> lookup(const std::string& aud_filename);
+	/**
+	Appends *metadata* as the record of *aud_filename*, keyed by the track and its audio info file as they are now,
+	so it should be stored after the audio info file is written. Returns false if the track or the cache file could not be accessed.
+	*/
+	bool store(const std::string& aud_filename, const TrackMetadata& metadata);
+
+	private:
+	///Where the record of a track lies in the file.
+	struct RecordLocation{
+		std::uint64_t offset;
+		std::uint64_t bytes;
+	};
+	///What a record is keyed by besides the path.
+	struct TrackKey{
+		std::uint64_t file_size;
+		std::int64_t file_modified_time;
+		///TrackAnalysisCache::no_audio_info_file without one.
+		std::int64_t audio_info_modified_time;
+	};
+	static constexpr std::int64_t no_audio_info_file = std::numeric_limits<std::int64_t>::min();
+
+	///The absolute path the record of *aud_filename* is stored under, and its key as it is now. std::nullopt if the track cannot be accessed.
+	static std::optional<std::pair<std::string, TrackKey>> get_track_key(const std::string& aud_filename);
+
+	///Maps the whole file again and indexes the records appended since it was last mapped. Locked by the caller.
+	void remap();
+	///Unmaps the file. Locked by the caller.
+	void unmap() noexcept;
+	///Forgets every record indexed, as there is no valid file to read them from. Locked by the caller.
+	void forget_records() noexcept;
+	///Indexes every complete record from *offset* to the end of the mapping. Locked by the caller.
+	void index_records(std::uint64_t offset);
+	/**
+	Replaces the file with one holding only the latest record of every track indexed, under a new file id. Locked by the caller.
+	Returns false if it could not be replaced, leaving the file as it was.
+	*/
+	bool rewrite_compacted();
+
+	const std::string cache_filename;
+	std::mutex cache_mutex;
+
+	const unsigned char* mapping = nullptr;
+	std::uint64_t mapped_bytes = 0;
+	///Set when the file is created, so a file replaced by another process is indexed again from the start.
+	std::uint64_t file_id = 0;
+	///The end of the last complete record indexed, where compaction stops.
+	std::uint64_t indexed_bytes = 0;
+	///The bytes of records replaced by a later record of the same track.
+	std::uint64_t replaced_bytes = 0;
+	std::unordered_map<std::string, RecordLocation> records;
+};
+
+#endif
@@ -0,0 +1,243 @@
+#include "TrackLoader.hpp"
+#include "ui.hpp"
+#include "track_analysis.hpp"
+
+#include <chrono>
+#include <algorithm>
+
+///How long a load waits for the first seconds of the track to be decoded, before handing it to the deck anyway.
+static constexpr std::chrono::milliseconds max_predecode_wait(1000);
+///How often the loader thread checks whether the render thread swapped a TrackSource, unless it is woken earlier.
+static constexpr std::chrono::milliseconds swap_poll_interval(20);
+
+TrackLoader::TrackLoader(const std::uint8_t track_id, TrackAnalysisCache& analysis_cache)
+:	track_id(track_id),
+	analysis_cache(analysis_cache),
+	loaded_beat_grid(std::make_shared<const BeatGrid>()),
+	loader_thread(&TrackLoader::run, this)
+{
+}
+
+TrackLoader::~TrackLoader(){
+	{
+		std::lock_guard<std::mutex> _(this->request_mutex);
+		this->stop_requested = true;
+	}
+	this->request_condition.notify_one();
+	if(this->loader_thread.joinable())
+		this->loader_thread.join();
+
+	delete this->loaded_source.exchange(nullptr);
+	delete this->swapped_out_source.exchange(nullptr);
+	delete this->published_render_track_info.exchange(nullptr);
+	delete this->swapped_out_render_track_info.exchange(nullptr);
+}
+
+void TrackLoader::request_load(const std::string& filename, const PcmCacheMode pcm_cache_mode){
+	{
+		std::lock_guard<std::mutex> _(this->request_mutex);
+		this->pending_request = LoadRequest{filename, pcm_cache_mode};
+		this->loading = true;
+	}
+	this->request_condition.notify_one();
+}
+
+bool TrackLoader::swap_in_loaded_source(std::unique_ptr<TrackSource>& current_source) noexcept{
+	//The last swapped out TrackSource has not been taken yet, there is only room for one.
+	if(this->swapped_out_source.load(std::memory_order_acquire) != nullptr) return false;
+
+	TrackSource* const source = this->loaded_source.exchange(nullptr, std::memory_order_acq_rel);
+	if(source == nullptr) return false;
+
+	this->swapped_out_source.store(current_source.release(), std::memory_order_release);
+	current_source.reset(source);
+	this->request_condition.notify_one();
+	return true;
+}
+
+void TrackLoader::request_hot_cue_store(const std::string& filename, const HotCues& hot_cues){
+	{
+		std::lock_guard<std::mutex> _(this->request_mutex);
+		this->pending_hot_cue_request = HotCueRequest{filename, hot_cues};
+	}
+	this->request_condition.notify_one();
+}
+
+bool TrackLoader::swap_in_render_track_info(RenderTrackInfo& current_info) noexcept{
+	if(this->swapped_out_render_track_info.load(std::memory_order_acquire) != nullptr) return false;
+
+	RenderTrackInfo* const info = this->published_render_track_info.exchange(nullptr, std::memory_order_acq_rel);
+	if(info == nullptr) return false;
+
+	//Swapping the pointers moves no reference count to 0, the previous BeatGrid and snippets leave in the box they came in.
+	info->beat_grid.swap(current_info.beat_grid);
+	info->hot_cue_snippets.swap(current_info.hot_cue_snippets);
+	this->swapped_out_render_track_info.store(info, std::memory_order_release);
+	return true;
+}
+
+std::string TrackLoader::get_loaded_filename() const{
+	std::lock_guard<std::mutex> _(this->loaded_filename_mutex);
+	return this->loaded_filename;
+}
+
+void TrackLoader::run() noexcept{
+	while(true){
+		try{
+			std::optional<LoadRequest> request;
+			std::optional<HotCueRequest> hot_cue_request;
+			{
+				std::unique_lock<std::mutex> request_lock(this->request_mutex);
+				this->request_condition.wait_for(request_lock, swap_poll_interval, [this]{
+					return this->stop_requested or this->pending_request.has_value() or this->pending_hot_cue_request.has_value();
+				});
+				if(this->stop_requested) return;
+				request.swap(this->pending_request);
+				hot_cue_request.swap(this->pending_hot_cue_request);
+			}
+
+			this->collect_swapped_source();
+			//Before the load, as they were set on the track loaded before it.
+			if(hot_cue_request.has_value())
+				this->store_hot_cues(hot_cue_request.value());
+			if(request.has_value())
+				this->load(request.value());
+		}
+		catch(const std::exception& excp){
+			ui::print_to_infobar(std::string("TrackLoader::run(): ") + excp.what(), UIColorPair_Error);
+		}
+		catch(...){
+			ui::print_to_infobar("TrackLoader::run(): uncaught throw.", UIColorPair_Error);
+		}
+	}
+}
+
+void TrackLoader::load(const LoadRequest& request){
+	try{
+		std::unique_ptr<TrackSource> source = std::make_unique<TrackSource>(request.filename, request.pcm_cache_mode, this->analysis_cache);
+		if(source->wait_until_predecoded(max_predecode_wait)){
+			//A TrackSource loaded before, which the render thread has not swapped in yet, is replaced.
+			this->collect_swapped_source();
+			this->waiting_filename = request.filename;
+			this->waiting_beat_grid = source->get_beat_grid();
+			this->waiting_waveform = source->get_metadata().waveform;
+			this->latest_filename = request.filename;
+			this->latest_hot_cues = get_hot_cues(source->get_metadata().cue_points);
+			const bool needs_analysis = source->needs_analysis();
+			const std::shared_ptr<const BeatGrid> beat_grid = source->get_beat_grid();
+			delete this->loaded_source.exchange(source.release(), std::memory_order_acq_rel);
+			//After the TrackSource, so the render thread does not sync the track it still plays to these beats.
+			//The snippets follow shortly after, a hot cue pressed before then plays from the decoder.
+			this->render_track_info = RenderTrackInfo{beat_grid, nullptr};
+			this->publish_render_track_info();
+			this->render_track_info.hot_cue_snippets = this->decode_hot_cue_snippets();
+			if(this->render_track_info.hot_cue_snippets) this->publish_render_track_info();
+			if(needs_analysis) this->analyse_loaded_track(request.filename, beat_grid);
+		}else{
+			//The deck keeps playing what it has.
+			const std::string msg = std::string("Error decoding ") + request.filename + std::string(" for deck ") + std::to_string(this->track_id) + std::string(".");
+			ui::print_to_infobar(msg, UIColorPair_Error);
+		}
+	}
+	catch(const std::exception& e){
+		ui::print_to_infobar(e.what(), UIColorPair_Error);
+	}
+
+	//Still loading if another file was asked for in the meantime.
+	std::lock_guard<std::mutex> _(this->request_mutex);
+	this->loading = this->pending_request.has_value() or this->loaded_source.load() != nullptr;
+}
+
+void TrackLoader::analyse_loaded_track(const std::string& filename, const std::shared_ptr<const BeatGrid>& beat_grid){
+	this->analysing = true;
+	const std::optional<TrackAnalysis> analysis = analyse_track(filename, [this]{
+		this->collect_swapped_source();
+		std::lock_guard<std::mutex> _(this->request_mutex);
+		return not (this->stop_requested or this->pending_request.has_value());
+	});
+	this->analysing = false;
+	//Abandoned for another file, or not decodable, which the ReadAheadDecoder reports.
+	if(not analysis.has_value()) return;
+
+	//The beats the track was loaded with may have been corrected by hand, write_audio_info() keeps them as well.
+	TrackMetadata metadata = make_track_metadata(analysis.value());
+	const bool keeps_beats = not beat_grid->empty();
+	if(keeps_beats) metadata.beat_grid = beat_grid;
+	metadata.cue_points = get_cue_points(this->latest_hot_cues);
+	if(not write_audio_info(filename, analysis.value()))
+		ui::print_to_infobar("Could not write the audio info file of " + filename + ".", UIColorPair_Warning);
+	else if(not this->analysis_cache.store(filename, metadata))
+		ui::print_to_infobar("Could not store " + filename + " to the analysis cache.", UIColorPair_Warning);
+	if(metadata.beat_grid->empty())
+		ui::print_to_infobar("No beats found in " + filename + ". Functionalities limited.", UIColorPair_Warning);
+
+	if(not keeps_beats){
+		this->render_track_info.beat_grid = metadata.beat_grid;
+		this->publish_render_track_info();
+	}
+	//Either still waiting to be swapped in, or already the loaded track, as the analysis stops once another file is asked for.
+	if(not this->waiting_filename.empty()){
+		this->waiting_waveform = metadata.waveform;
+		if(not keeps_beats) this->waiting_beat_grid = metadata.beat_grid;
+	}else{
+		std::atomic_store(&(this->loaded_waveform), metadata.waveform);
+		if(not keeps_beats) std::atomic_store(&(this->loaded_beat_grid), metadata.beat_grid);
+	}
+}
+
+void TrackLoader::collect_swapped_source(){
+	if(not this->waiting_filename.empty() and this->loaded_source.load(std::memory_order_acquire) == nullptr){
+		{
+			std::lock_guard<std::mutex> _(this->loaded_filename_mutex);
+			this->loaded_filename = this->waiting_filename;
+		}
+		std::atomic_store(&(this->loaded_beat_grid), std::move(this->waiting_beat_grid));
+		std::atomic_store(&(this->loaded_waveform), std::move(this->waiting_waveform));
+		this->waiting_beat_grid.reset();
+		this->waiting_waveform.reset();
+		this->waiting_filename.clear();
+		std::lock_guard<std::mutex> _(this->request_mutex);
+		this->loading = this->pending_request.has_value();
+	}
+	delete this->swapped_out_source.exchange(nullptr, std::memory_order_acq_rel);
+	delete this->swapped_out_render_track_info.exchange(nullptr, std::memory_order_acq_rel);
+}
+
+void TrackLoader::store_hot_cues(const HotCueRequest& request){
+	//Set on a track replaced since, whose deck no longer shows them.
+	if(request.filename != this->latest_filename) return;
+	this->latest_hot_cues = request.hot_cues;
+
+	//A track not analysed yet gets a record without a waveform, which its analysis replaces keeping the hot cues.
+	std::optional<TrackMetadata> metadata = this->analysis_cache.lookup(request.filename);
+	if(not metadata.has_value()){
+		metadata = TrackMetadata();
+		metadata->beat_grid = this->render_track_info.beat_grid;
+	}
+	metadata->cue_points = get_cue_points(request.hot_cues);
+	if(not this->analysis_cache.store(request.filename, metadata.value()))
+		ui::print_to_infobar("Could not store the hot cues of " + request.filename + " to the analysis cache.", UIColorPair_Warning);
+
+	this->render_track_info.hot_cue_snippets = this->decode_hot_cue_snippets();
+	this->publish_render_track_info();
+}
+
+std::shared_ptr<const HotCueSnippets> TrackLoader::decode_hot_cue_snippets() const{
+	const bool has_hot_cues = std::any_of(this->latest_hot_cues.begin(), this->latest_hot_cues.end(), [](const double hot_cue){
+		return hot_cue != no_hot_cue;
+	});
+	if(not has_hot_cues) return nullptr;
+
+	try{
+		return std::make_shared<const HotCueSnippets>(this->latest_filename, this->latest_hot_cues);
+	}
+	catch(const std::exception& e){
+		//Hot cues still jump without snippets, only waiting for the decoder.
+		ui::print_to_infobar(e.what(), UIColorPair_Warning);
+		return nullptr;
+	}
+}
+
+void TrackLoader::publish_render_track_info(){
+	delete this->published_render_track_info.exchange(new RenderTrackInfo(this->render_track_info), std::memory_order_acq_rel);
+}
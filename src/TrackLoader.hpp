@@ -0,0 +1,156 @@
+/**
+\file TrackLoader.hpp
+*/
+
+#ifndef TrackLoader_hpp
+#define TrackLoader_hpp
+
+#include "TrackSource.hpp"
+#include "HotCueSnippets.hpp"
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <cstdint>
+#include <optional>
+#include <condition_variable>
+
+///What the render thread of a deck reads of its track besides the TrackSource, handed over by TrackLoader::swap_in_render_track_info().
+struct RenderTrackInfo{
+	///Never nullptr, empty if the track has no bpm.
+	std::shared_ptr<const BeatGrid> beat_grid = std::make_shared<const BeatGrid>();
+	///nullptr if the track has no hot cues.
+	std::shared_ptr<const HotCueSnippets> hot_cue_snippets;
+};
+
+/**
+The thread of a deck which opens tracks, predecodes their first seconds and reads their audio info,
+so neither the UI thread nor the render thread of the deck waits on a file.
+
+A track without a waveform in the TrackAnalysisCache is analysed after it is handed to the deck, see analyse_track(),
+its audio info file written, its record stored and its waveform published, along with its BeatGrid if it had no beats.
+Hot cues set on the deck are stored to its record from here as well, and the snippets of the hot cues decoded.
+
+A loaded TrackSource is handed to the render thread through an atomic pointer, which swaps it in between two blocks.
+The TrackSource it replaces is handed back the same way and destroyed on this thread, as that waits for its decoding threads to stop.
+The BeatGrid and the HotCueSnippets of the loaded track are handed to the render thread the same way, so the render thread never frees either.
+*/
+class TrackLoader{
+	public:
+	///Starts the loader thread. *track_id* is only used in messages. Tracks are looked up in and analysed to *analysis_cache*, which must outlive the loader.
+	TrackLoader(const std::uint8_t track_id, TrackAnalysisCache& analysis_cache);
+	///Stops the loader thread and destroys any TrackSource not swapped in.
+	~TrackLoader();
+
+	TrackLoader(const TrackLoader&) = delete;
+	TrackLoader& operator=(const TrackLoader&) = delete;
+
+	/**
+	Asks the loader thread to load *filename*, replacing any load asked for which has not started yet. Returns without waiting for it.
+	Errors are reported through the infobar by the loader thread.
+	*/
+	void request_load(const std::string& filename, const PcmCacheMode pcm_cache_mode);
+
+	/**
+	Swaps a loaded TrackSource into *current_source* if there is one, and returns true if so. Render thread only.
+	The previous TrackSource is handed to the loader thread to be destroyed, nothing is freed here.
+	*/
+	bool swap_in_loaded_source(std::unique_ptr<TrackSource>& current_source) noexcept;
+	/**
+	Asks the loader thread to store *hot_cues* as the hot cues of *filename* and decode their snippets for the render thread,
+	replacing any hot cues asked for which have not been stored yet. Ignored unless *filename* is the track loaded last.
+	*/
+	void request_hot_cue_store(const std::string& filename, const HotCues& hot_cues);
+
+	/**
+	Swaps the RenderTrackInfo last published for the render thread into *current_info* if there is a new one, and returns true if so. Render thread only.
+	The previous RenderTrackInfo is handed to the loader thread to be released, nothing is freed here.
+	*/
+	bool swap_in_render_track_info(RenderTrackInfo& current_info) noexcept;
+
+	///The file of the TrackSource the deck currently plays from.
+	std::string get_loaded_filename() const;
+	///The BeatGrid of the TrackSource the deck currently plays from, never nullptr. Never called from the render thread, as it may free the previous one.
+	std::shared_ptr<const BeatGrid> get_loaded_beat_grid() const noexcept{
+		return std::atomic_load(&(this->loaded_beat_grid));
+	}
+	///The waveform of the TrackSource the deck currently plays from, nullptr until it is analysed. Not for the render thread either.
+	std::shared_ptr<const WaveformPyramid> get_loaded_waveform() const noexcept{
+		return std::atomic_load(&(this->loaded_waveform));
+	}
+	///Whether a file asked for is being loaded or waiting to be swapped in.
+	bool is_loading() const noexcept{
+		return this->loading.load();
+	}
+	///Whether the beats of the loaded file are being analysed.
+	bool is_analysing() const noexcept{
+		return this->analysing.load();
+	}
+
+	private:
+	struct LoadRequest{
+		std::string filename;
+		PcmCacheMode pcm_cache_mode;
+	};
+	struct HotCueRequest{
+		std::string filename;
+		HotCues hot_cues;
+	};
+
+	void run() noexcept;
+	void load(const LoadRequest& request);
+	///Destroys the TrackSource the render thread swapped out, and takes the name, BeatGrid and waveform of the one it swapped in.
+	void collect_swapped_source();
+	/**
+	Analyses *filename*, the file just loaded, writes its audio info file, stores it to TrackLoader::analysis_cache and publishes its waveform.
+	*beat_grid*, the beats it was loaded with, is kept unless it is empty, otherwise the beats found are published.
+	Abandoned as soon as another file is asked for, while still collecting swapped TrackSource objects.
+	*/
+	void analyse_loaded_track(const std::string& filename, const std::shared_ptr<const BeatGrid>& beat_grid);
+	///Stores the hot cues of *request* to the record of the track loaded last, and publishes their snippets.
+	void store_hot_cues(const HotCueRequest& request);
+	///The snippets of the hot cues of the track loaded last, nullptr if it has none or they could not be decoded.
+	std::shared_ptr<const HotCueSnippets> decode_hot_cue_snippets() const;
+	///Hands TrackLoader::render_track_info to the render thread, replacing any RenderTrackInfo it has not swapped in yet.
+	void publish_render_track_info();
+
+	const std::uint8_t track_id;
+	TrackAnalysisCache& analysis_cache;
+
+	std::mutex request_mutex;
+	std::condition_variable request_condition;
+	std::optional<LoadRequest> pending_request;
+	std::optional<HotCueRequest> pending_hot_cue_request;
+	bool stop_requested = false;
+
+	///Published by the loader thread, taken by the render thread.
+	std::atomic<TrackSource*> loaded_source = nullptr;
+	///Published by the render thread, taken by the loader thread. The render thread does not swap again until it is taken.
+	std::atomic<TrackSource*> swapped_out_source = nullptr;
+	///Published by the loader thread and taken by the render thread, then handed back holding the RenderTrackInfo it replaced, as TrackLoader::loaded_source is.
+	std::atomic<RenderTrackInfo*> published_render_track_info = nullptr;
+	std::atomic<RenderTrackInfo*> swapped_out_render_track_info = nullptr;
+	std::atomic_bool loading = false;
+	std::atomic_bool analysing = false;
+	///The file of TrackLoader::loaded_source, which becomes the loaded filename once it is swapped in. Loader thread only.
+	std::string waiting_filename;
+	std::shared_ptr<const BeatGrid> waiting_beat_grid;
+	std::shared_ptr<const WaveformPyramid> waiting_waveform;
+	///The RenderTrackInfo published last, so one part of it can be published again with the other. Loader thread only.
+	RenderTrackInfo render_track_info;
+	///The file loaded last and its hot cues, whether or not it is swapped in yet. Loader thread only.
+	std::string latest_filename;
+	HotCues latest_hot_cues = get_hot_cues({});
+
+	mutable std::mutex loaded_filename_mutex;
+	std::string loaded_filename = "Track not loaded.";
+	///Only accessed with std::atomic_load() and std::atomic_store(), so they can be read without a lock.
+	std::shared_ptr<const BeatGrid> loaded_beat_grid;
+	std::shared_ptr<const WaveformPyramid> loaded_waveform;
+
+	std::thread loader_thread;
+};
+
+#endif
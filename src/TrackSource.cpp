@@ -0,0 +1,122 @@
+#include "TrackSource.hpp"
+#include "ui.hpp"
+#include "track_analysis.hpp"
+
+#include "ntrb/aud_std_fmt.h"
+
+#include <thread>
+#include <fstream>
+#include <stdexcept>
+
+///How often TrackSource::wait_until_predecoded() checks the ReadAheadDecoder.
+static constexpr std::chrono::milliseconds predecode_poll_interval(2);
+
+TrackSource::TrackSource(const std::string& filename, const PcmCacheMode pcm_cache_mode, TrackAnalysisCache& analysis_cache)
+:	filename(filename)
+{
+	//The buffer is only loaded by the ReadAheadDecoder, a chunk at a time.
+	const std::uint32_t file_buffer_frames = ReadAheadDecoder::chunk_frames + ReadAheadDecoder::chunk_margin_frames;
+	const ntrb_AudioBufferNew_Error new_file_aud_err = ntrb_AudioBuffer_new(&(this->file_buffer), filename.c_str(), file_buffer_frames);
+	if(new_file_aud_err)
+		throw std::runtime_error(std::string("Error setting the track (ntrb_AudioBufferNew_Error ") + std::to_string(new_file_aud_err) + std::string(")"));
+
+	try{
+		this->read_ahead_decoder = std::make_unique<ReadAheadDecoder>(this->file_buffer);
+	}
+	catch(...){
+		ntrb_AudioBuffer_free(&(this->file_buffer));
+		throw;
+	}
+
+	if(pcm_cache_mode != PcmCacheMode_Off){
+		try{
+			this->pcm_cache = std::make_unique<PcmCache>(filename, pcm_cache_mode);
+		}
+		catch(const std::exception& e){
+			//The deck still plays from the ReadAheadDecoder.
+			ui::print_to_infobar(std::string("PCM cache disabled for ") + filename + ": " + e.what(), UIColorPair_Error);
+		}
+	}
+
+	std::optional<TrackMetadata> cached_metadata = analysis_cache.lookup(filename);
+	if(cached_metadata.has_value())
+		this->metadata = std::move(cached_metadata.value());
+	else{
+		this->load_audio_info();
+		//Tracks without a bpm are stored once the TrackLoader analysed them.
+		if(not this->metadata.beat_grid->empty() and not analysis_cache.store(filename, this->metadata))
+			ui::print_to_infobar("Could not store " + filename + " to the analysis cache.", UIColorPair_Warning);
+	}
+}
+
+TrackSource::~TrackSource(){
+	//Stopped first, as its thread loads TrackSource::file_buffer.
+	this->read_ahead_decoder.reset();
+	ntrb_AudioBuffer_free(&(this->file_buffer));
+}
+
+bool TrackSource::wait_until_predecoded(const std::chrono::milliseconds timeout) const noexcept{
+	const std::chrono::steady_clock::time_point give_up_at = std::chrono::steady_clock::now() + timeout;
+	while(not this->read_ahead_decoder->has_decoded_wanted_chunks() and std::chrono::steady_clock::now() < give_up_at){
+		if(this->read_ahead_decoder->has_failed()) break;
+		std::this_thread::sleep_for(predecode_poll_interval);
+	}
+	return not this->read_ahead_decoder->has_failed();
+}
+
+void TrackSource::load_audio_info(){
+	std::ifstream metadata_file(get_audio_info_filename(this->filename));
+	//The TrackLoader analyses tracks without one.
+	if(!metadata_file) return;
+	
+	double bpm = 0.0;
+	double first_beat_stdaud_frame = 0.0;
+	std::string keyword, value;
+	while(metadata_file >> keyword >> value){
+		try{
+			if(keyword == "bpm") bpm = std::stod(value);
+			else if(keyword == "first_beat_frame") first_beat_stdaud_frame = std::stod(value);
+			else if(keyword == "loudness_lufs") this->metadata.integrated_loudness = std::stod(value);
+			else if(keyword == "first_beat"){
+				float seconds = 0.0;
+				const std::string::size_type minute_second_separator = value.find(':');
+				const std::string::size_type second_millisecond_separator = value.find('.');
+				
+				const bool has_minute_second_separator = minute_second_separator != std::string::npos;
+				const bool has_second_millisecond_separator = second_millisecond_separator != std::string::npos;
+
+				if(has_minute_second_separator){
+					const std::uint8_t minutes = std::stoi(value.substr(0, minute_second_separator));
+					seconds += (float)minutes * 60.0;
+					
+					if(has_second_millisecond_separator)
+						seconds += std::stoi(value.substr(minute_second_separator, second_millisecond_separator));
+					else
+						seconds += std::stoi(value.substr(minute_second_separator));					
+				}else{
+					if(has_second_millisecond_separator)
+						seconds += std::stoi(value.substr(0, second_millisecond_separator));
+					else
+						seconds += std::stoi(value);						
+				}
+				if(has_second_millisecond_separator){
+					const std::uint16_t milliseconds = std::stoi(value.substr(second_millisecond_separator+1));
+					seconds += (float)milliseconds / 1000.0;
+				}
+
+				first_beat_stdaud_frame = (double)seconds * ntrb_std_samplerate;
+			}
+		}
+		catch(const std::invalid_argument& stox_not_a_number){
+			const std::string msg = "Audio info file: data for " + keyword + " is not a number.";
+			ui::print_to_infobar(msg, UIColorPair_Warning);
+		}
+		catch(const std::out_of_range& stox_out_of_range){
+			const std::string msg = "Audio info file: data for " + keyword + " not in range.";
+			ui::print_to_infobar(msg, UIColorPair_Warning);
+		}
+	}
+	
+	if(bpm > 0.0)
+		this->metadata.beat_grid = std::make_shared<const BeatGrid>(first_beat_stdaud_frame, bpm);
+}
@@ -0,0 +1,89 @@
+/**
+\file TrackSource.hpp
+*/
+
+#ifndef TrackSource_hpp
+#define TrackSource_hpp
+
+#include "BeatGrid.hpp"
+#include "PcmCache.hpp"
+#include "ReadAheadDecoder.hpp"
+#include "TrackAnalysisCache.hpp"
+
+#include "ntrb/AudioBuffer.h"
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <cstdint>
+
+/**
+Everything a deck plays a track from: the opened file, its ReadAheadDecoder, its PcmCache if one was asked for, and its TrackMetadata.
+
+A TrackSource is built completely on a TrackLoader thread, then handed to the deck as a whole,
+so the deck never opens, probes or frees a file itself.
+*/
+class TrackSource{
+	public:
+	/**
+	Opens *filename*, starts decoding it ahead of frame 0, and to a PcmCache unless *pcm_cache_mode* is PcmCacheMode_Off,
+	then looks its metadata up in *analysis_cache*. Without a record there, its audio info file is read instead, see TrackSource::load_audio_info(),
+	and stored to *analysis_cache* if it has a bpm.
+
+	Throws std::runtime_error if *filename* could not be opened. A PcmCache which could not be created is only reported.
+	*/
+	TrackSource(const std::string& filename, const PcmCacheMode pcm_cache_mode, TrackAnalysisCache& analysis_cache);
+	///Stops decoding before freeing the file.
+	~TrackSource();
+
+	TrackSource(const TrackSource&) = delete;
+	TrackSource& operator=(const TrackSource&) = delete;
+
+	/**
+	Waits until the ReadAheadDecoder has decoded the first seconds of the track, it failed, or *timeout* passed.
+	Returns false if it failed.
+	*/
+	bool wait_until_predecoded(const std::chrono::milliseconds timeout) const noexcept;
+
+	ReadAheadDecoder& get_read_ahead_decoder() noexcept{
+		return *(this->read_ahead_decoder);
+	}
+	///nullptr without a PcmCache.
+	PcmCache* get_pcm_cache() noexcept{
+		return this->pcm_cache.get();
+	}
+	const std::string& get_filename() const noexcept{
+		return this->filename;
+	}
+	const TrackMetadata& get_metadata() const noexcept{
+		return this->metadata;
+	}
+	///Never nullptr, empty if the track has no bpm.
+	const std::shared_ptr<const BeatGrid>& get_beat_grid() const noexcept{
+		return this->metadata.beat_grid;
+	}
+	///Whether the track has no waveform, so it has never been analysed.
+	bool needs_analysis() const noexcept{
+		return not this->metadata.waveform;
+	}
+
+	private:
+	/**
+	Loads audio info file from TrackSource::filename, usually by reading from a file which has the extension of it replaced with .txt,
+	to the BeatGrid and loudness of TrackSource::metadata. Without one the BeatGrid stays empty.
+
+	Errors are displayed through the infobar.
+	*/
+	void load_audio_info();
+
+	const std::string filename;
+	///The buffer the ReadAheadDecoder loads the file through.
+	ntrb_AudioBuffer file_buffer;
+	std::unique_ptr<ReadAheadDecoder> read_ahead_decoder;
+	std::unique_ptr<PcmCache> pcm_cache;
+
+	///Its BeatGrid and waveform are shared with the threads reading them, which may outlive the TrackSource.
+	TrackMetadata metadata;
+};
+
+#endif
@@ -0,0 +1,68 @@
+#include "UnderrunConcealer.hpp"
+
+#include "ntrb/aud_std_fmt.h"
+
+#include <cstring>
+#include <algorithm>
+
+UnderrunConcealer::UnderrunConcealer(const std::size_t samples_per_block)
+:	last_complete_block(samples_per_block, 0.0)
+{
+}
+
+std::size_t UnderrunConcealer::read(SampleRing& ring, float* const samples, std::size_t sample_count, const UnderrunPolicy policy) noexcept{
+	sample_count = std::min(sample_count, this->last_complete_block.size());
+	const std::size_t samples_read = ring.read(samples, sample_count);
+
+	if(this->faded_out){
+		const std::size_t frames_read = samples_read / ntrb_std_audchannels;
+		for(std::size_t frame = 0; frame < frames_read and this->faded_in_frames < fade_frames; frame++, this->faded_in_frames++){
+			const float gain = (float)this->faded_in_frames / (float)fade_frames;
+			for(std::uint8_t channel = 0; channel < ntrb_std_audchannels; channel++)
+				samples[(frame * ntrb_std_audchannels) + channel] *= gain;
+		}
+		if(this->faded_in_frames == fade_frames){
+			this->faded_out = false;
+			this->faded_in_frames = 0;
+		}
+	}
+
+	if(samples_read == sample_count){
+		std::memcpy(this->last_complete_block.data(), samples, sample_count * sizeof(float));
+		return 0;
+	}
+
+	float* const missing_samples = samples + samples_read;
+	const std::size_t missing_sample_count = sample_count - samples_read;
+	const float* const repeated_samples = this->last_complete_block.data() + samples_read;
+
+	switch(policy){
+		case UnderrunPolicy_Repeat:
+		std::memcpy(missing_samples, repeated_samples, missing_sample_count * sizeof(float));
+		break;
+
+		case UnderrunPolicy_Fade:{
+			std::memset(missing_samples, 0, missing_sample_count * sizeof(float));
+			//Faded out from wherever a fade in got to, which is silence if it had not started.
+			const float begin_gain = this->faded_out ? (float)this->faded_in_frames / (float)fade_frames : 1.0f;
+			this->faded_out = true;
+			this->faded_in_frames = 0;
+			if(begin_gain == 0.0f) break;
+
+			const std::size_t fade_out_frames = std::min(missing_sample_count / ntrb_std_audchannels, fade_frames);
+			for(std::size_t frame = 0; frame < fade_out_frames; frame++){
+				const float gain = begin_gain * (1.0f - ((float)frame / (float)fade_out_frames));
+				for(std::uint8_t channel = 0; channel < ntrb_std_audchannels; channel++){
+					const std::size_t sample = (frame * ntrb_std_audchannels) + channel;
+					missing_samples[sample] = repeated_samples[sample] * gain;
+				}
+			}
+			break;
+		}
+
+		case UnderrunPolicy_Silence:
+		default:
+		std::memset(missing_samples, 0, missing_sample_count * sizeof(float));
+	}
+	return missing_sample_count;
+}
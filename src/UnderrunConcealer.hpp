@@ -0,0 +1,61 @@
+/**
+\file UnderrunConcealer.hpp
+*/
+
+#ifndef UnderrunConcealer_hpp
+#define UnderrunConcealer_hpp
+
+#include "SampleRing.hpp"
+
+#include <array>
+#include <vector>
+#include <cstdint>
+
+///What an output device callback plays in place of samples which a SampleRing could not provide in time.
+enum UnderrunPolicy : std::uint8_t{
+	///Play silence for the missing samples.
+	UnderrunPolicy_Silence,
+	///Play the missing samples from the last complete block again.
+	UnderrunPolicy_Repeat,
+	///Play the last complete block again while fading it out to silence, then fade back in once samples arrive.
+	UnderrunPolicy_Fade
+};
+
+constexpr std::array<const char*, (int)UnderrunPolicy_Fade+1> underrun_policy_names{
+	"Silence",
+	"Repeat",
+	"Fade",
+};
+
+/**
+Reads blocks from a SampleRing for an output device callback, and fills in whatever the ring is missing
+according to an UnderrunPolicy instead of waiting for it.
+
+Each concealer keeps a copy of the last complete block it read, allocated at construction,
+so nothing in UnderrunConcealer::read() blocks or allocates.
+*/
+class UnderrunConcealer{
+	public:
+	///\param[in] samples_per_block The most samples a single UnderrunConcealer::read() will be asked for.
+	UnderrunConcealer(const std::size_t samples_per_block);
+
+	/**
+	Reads *sample_count* samples from *ring* to *samples*, concealing any samples the ring did not have with *policy*.
+	*sample_count* is capped to the samples_per_block the concealer was constructed with.
+
+	Returns the amount of samples the ring could not provide, which should be counted as an underrun unless it is 0.
+	*/
+	std::size_t read(SampleRing& ring, float* const samples, std::size_t sample_count, const UnderrunPolicy policy) noexcept;
+
+	private:
+	///The amount of stdaud frames UnderrunPolicy_Fade fades out and back in over, every channel of a frame at the same gain.
+	static constexpr std::size_t fade_frames = 256;
+
+	std::vector<float> last_complete_block;
+	///Set after UnderrunPolicy_Fade has faded the output out, until the samples from the ring are completely faded back in.
+	bool faded_out = false;
+	///How many frames of the fade in were played, carried over callbacks which read less than UnderrunConcealer::fade_frames frames.
+	std::size_t faded_in_frames = 0;
+};
+
+#endif
@@ -0,0 +1,82 @@
+#include "WaveformPyramid.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+static std::int8_t quantise_sample(const float sample) noexcept{
+	return std::lround(std::clamp(sample, -1.0f, 1.0f) * 127.0f);
+}
+
+static std::uint8_t quantise_rms(const double rms) noexcept{
+	return std::lround(std::clamp(rms, 0.0, 1.0) * 255.0);
+}
+
+void WaveformPyramid::push_frames(const float* const stdaud_frames, const std::uint64_t frame_count) noexcept{
+	if(this->levels.empty()) this->levels.emplace_back();
+	std::vector<WaveformBin>& base_level = this->levels.front();
+
+	for(std::uint64_t frame = 0; frame < frame_count; frame++){
+		const float sample = 0.5f * (stdaud_frames[frame * 2] + stdaud_frames[(frame * 2) + 1]);
+		if(this->pending_frames == 0){
+			this->pending_min = sample;
+			this->pending_max = sample;
+		}else{
+			this->pending_min = std::min(this->pending_min, sample);
+			this->pending_max = std::max(this->pending_max, sample);
+		}
+		this->pending_square_sum += double(sample) * sample;
+		this->pending_frames++;
+
+		if(this->pending_frames == base_bin_frames){
+			base_level.push_back(WaveformBin{quantise_sample(this->pending_min), quantise_sample(this->pending_max),
+											 quantise_rms(std::sqrt(this->pending_square_sum / base_bin_frames))});
+			this->pending_square_sum = 0.0;
+			this->pending_frames = 0;
+		}
+	}
+	this->frame_count += frame_count;
+}
+
+void WaveformPyramid::finish(){
+	if(this->levels.empty()) this->levels.emplace_back();
+	if(this->pending_frames > 0){
+		this->levels.front().push_back(WaveformBin{quantise_sample(this->pending_min), quantise_sample(this->pending_max),
+												   quantise_rms(std::sqrt(this->pending_square_sum / this->pending_frames))});
+		this->pending_square_sum = 0.0;
+		this->pending_frames = 0;
+	}
+
+	this->levels.resize(1);
+	while(this->levels.back().size() > 1){
+		const std::vector<WaveformBin>& finer_level = this->levels.back();
+		std::vector<WaveformBin> coarser_level((finer_level.size() + 1) / 2);
+		for(std::size_t bin = 0; bin < coarser_level.size(); bin++){
+			const WaveformBin& first = finer_level[bin * 2];
+			//The last bin of an odd level has nothing to pair with.
+			const WaveformBin& second = (bin * 2) + 1 < finer_level.size() ? finer_level[(bin * 2) + 1] : first;
+			const double mean_square = ((double(first.rms) * first.rms) + (double(second.rms) * second.rms)) / 2.0;
+			coarser_level[bin] = WaveformBin{std::min(first.min, second.min), std::max(first.max, second.max), std::uint8_t(std::lround(std::sqrt(mean_square)))};
+		}
+		this->levels.push_back(std::move(coarser_level));
+	}
+}
+
+std::optional<WaveformBin> WaveformPyramid::summarise(const std::uint64_t first_frame, const std::uint64_t end_frame) const noexcept{
+	if(this->empty() or first_frame >= this->frame_count or end_frame <= first_frame) return std::nullopt;
+
+	std::size_t level = 0;
+	while(level + 1 < this->levels.size() and get_bin_frames(level + 1) <= end_frame - first_frame) level++;
+	const std::vector<WaveformBin>& bins = this->levels[level];
+	const std::uint64_t first_bin = first_frame / get_bin_frames(level);
+	const std::uint64_t end_bin = std::min<std::uint64_t>(bins.size(), ((end_frame - 1) / get_bin_frames(level)) + 1);
+
+	WaveformBin summary = bins[first_bin];
+	double square_sum = double(summary.rms) * summary.rms;
+	for(std::uint64_t bin = first_bin + 1; bin < end_bin; bin++){
+		summary.min = std::min(summary.min, bins[bin].min);
+		summary.max = std::max(summary.max, bins[bin].max);
+		square_sum += double(bins[bin].rms) * bins[bin].rms;
+	}
+	summary.rms = std::lround(std::sqrt(square_sum / (end_bin - first_bin)));
+	return summary;
+}
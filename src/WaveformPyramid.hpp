@@ -0,0 +1,77 @@
+/**
+\file WaveformPyramid.hpp
+*/
+
+#ifndef WaveformPyramid_hpp
+#define WaveformPyramid_hpp
+
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include <optional>
+
+///The waveform of a span of frames of a track, downmixed to mono and quantised to a byte each.
+struct WaveformBin{
+	///The lowest and highest sample, scaled from -1 to 1 to -127 to 127.
+	std::int8_t min;
+	std::int8_t max;
+	///The root mean square of the samples, scaled from 0 to 1 to 0 to 255.
+	std::uint8_t rms;
+};
+
+/**
+The waveform of a whole track as levels of WaveformBin, from WaveformPyramid::base_bin_frames frames per bin
+to a single bin for the whole track, every level having bins of twice the frames of the level before.
+
+Any span of the track is drawn from the level with bins closest to the frames per column drawn,
+so drawing costs the same whatever the length of the track or the zoom.
+*/
+class WaveformPyramid{
+	public:
+	static constexpr std::uint32_t base_bin_frames = 512;
+
+	WaveformPyramid() = default;
+	///A finished pyramid of *levels* built before, such as one read from a TrackAnalysisCache.
+	WaveformPyramid(std::vector<std::vector<WaveformBin>> levels, const std::uint64_t frame_count)
+	:	levels(std::move(levels)), frame_count(frame_count)
+	{
+	}
+
+	///Pushes the next *frame_count* interleaved stereo stdaud frames of the track into the base level.
+	void push_frames(const float* const stdaud_frames, const std::uint64_t frame_count) noexcept;
+	///Completes the last bin of the base level and builds the levels above it, once every frame was pushed.
+	void finish();
+
+	bool empty() const noexcept{
+		return this->levels.empty() or this->levels.front().empty();
+	}
+	std::uint64_t get_frame_count() const noexcept{
+		return this->frame_count;
+	}
+	std::size_t get_level_count() const noexcept{
+		return this->levels.size();
+	}
+	const std::vector<WaveformBin>& get_level(const std::size_t level) const noexcept{
+		return this->levels[level];
+	}
+	static std::uint64_t get_bin_frames(const std::size_t level) noexcept{
+		return std::uint64_t(base_bin_frames) << level;
+	}
+	/**
+	The waveform of the frames from *first_frame* to *end_frame*, read from the level with the largest bins no longer than the span,
+	so it only ever combines up to 3 bins whatever the span. std::nullopt if the span lies outside the track.
+	*/
+	std::optional<WaveformBin> summarise(const std::uint64_t first_frame, const std::uint64_t end_frame) const noexcept;
+
+	private:
+	std::vector<std::vector<WaveformBin>> levels;
+	std::uint64_t frame_count = 0;
+
+	///The base level bin being filled.
+	float pending_min = 0.0;
+	float pending_max = 0.0;
+	double pending_square_sum = 0.0;
+	std::uint32_t pending_frames = 0;
+};
+
+#endif
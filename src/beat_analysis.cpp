@@ -0,0 +1,188 @@
+#include "beat_analysis.hpp"
+#include "FFT.hpp"
+
+#include <cmath>
+#include <array>
+#include <vector>
+#include <complex>
+#include <numeric>
+#include <algorithm>
+
+///Shorter tracks have too few beats to estimate a tempo from.
+static constexpr double min_analysed_seconds = 8.0;
+///The onset strengths have their mean over this many seconds around them removed, so only peaks above the local level are left.
+static constexpr double local_mean_seconds = 0.3;
+///The tempo the autocorrelation is weighted towards, and how many octaves away the weight falls to about 0.6.
+static constexpr double tempo_prior_bpm = 120.0;
+static constexpr double tempo_prior_octaves = 1.0;
+///How many multiples of a lag are scored with it.
+static constexpr std::uint32_t scored_lag_multiples = 4;
+///The Fourier tempogram searches this ratio either side of the autocorrelation tempo, in coarse then fine steps.
+static constexpr double tempogram_search_ratio = 0.02;
+static constexpr double tempogram_coarse_step_bpm = 0.05;
+static constexpr double tempogram_fine_step_bpm = 0.005;
+static constexpr std::uint32_t beats_per_bar = 4;
+
+///*strengths* with the mean of the *half_width* strengths either side of them removed, and negative results zeroed.
+static std::vector<float> remove_local_mean(const std::vector<float>& strengths, const std::size_t half_width){
+	std::vector<double> prefix_sums(strengths.size() + 1, 0.0);
+	for(std::size_t i = 0; i < strengths.size(); i++) prefix_sums[i+1] = prefix_sums[i] + strengths[i];
+
+	std::vector<float> peaks(strengths.size());
+	for(std::size_t i = 0; i < strengths.size(); i++){
+		const std::size_t begin = i > half_width ? i - half_width : 0;
+		const std::size_t end = std::min(strengths.size(), i + half_width + 1);
+		const double local_mean = (prefix_sums[end] - prefix_sums[begin]) / (end - begin);
+		peaks[i] = std::max(0.0, strengths[i] - local_mean);
+	}
+	return peaks;
+}
+
+///The autocorrelation of *values* for every lag, divided by the amount of products summed for it. Computed with an FFT.
+static std::vector<double> autocorrelate(const std::vector<float>& values){
+	std::size_t transform_size = 2;
+	while(transform_size < values.size() * 2) transform_size <<= 1;
+
+	const FFT fft(transform_size);
+	std::vector<std::complex<float>> spectrum(transform_size, std::complex<float>(0.0f, 0.0f));
+	for(std::size_t i = 0; i < values.size(); i++) spectrum[i] = std::complex<float>(values[i], 0.0f);
+
+	fft.forward(spectrum.data());
+	for(std::complex<float>& bin : spectrum) bin = std::complex<float>(std::norm(bin), 0.0f);
+	fft.inverse(spectrum.data());
+
+	std::vector<double> autocorrelation(values.size());
+	for(std::size_t lag = 0; lag < values.size(); lag++)
+		autocorrelation[lag] = double(spectrum[lag].real()) / double(values.size() - lag);
+	return autocorrelation;
+}
+
+///The lag, in onset strengths, with the best scored autocorrelation for a tempo between min_estimated_bpm and max_estimated_bpm.
+static double estimate_beat_lag(const std::vector<double>& autocorrelation, const double onset_rate){
+	const std::size_t shortest_lag = std::floor(60.0 * onset_rate / max_estimated_bpm);
+	const std::size_t longest_lag = std::ceil(60.0 * onset_rate / min_estimated_bpm);
+	const double prior_lag = 60.0 * onset_rate / tempo_prior_bpm;
+
+	std::vector<double> scores(longest_lag + 2, 0.0);
+	for(std::size_t lag = std::max<std::size_t>(1, shortest_lag - 1); lag <= longest_lag + 1; lag++){
+		double multiples_sum = 0.0;
+		for(std::uint32_t multiple = 1; multiple <= scored_lag_multiples and lag * multiple < autocorrelation.size(); multiple++)
+			multiples_sum += autocorrelation[lag * multiple] / multiple;
+
+		const double octaves_from_prior = std::log2(lag / prior_lag) / tempo_prior_octaves;
+		scores[lag] = multiples_sum * std::exp(-0.5 * octaves_from_prior * octaves_from_prior);
+	}
+
+	std::size_t best_lag = shortest_lag;
+	for(std::size_t lag = shortest_lag; lag <= longest_lag; lag++)
+		if(scores[lag] > scores[best_lag]) best_lag = lag;
+
+	//A parabola through the best score and its neighbours finds the lag in between 2 onset strengths.
+	const double before = scores[best_lag - 1], best = scores[best_lag], after = scores[best_lag + 1];
+	const double curvature = before - (2.0 * best) + after;
+	if(curvature >= 0.0) return best_lag;
+	return best_lag + std::clamp(0.5 * (before - after) / curvature, -0.5, 0.5);
+}
+
+///The Fourier tempogram of *strengths* at *cycles_per_strength*: its strengths summed as phasors rotating at that frequency.
+static std::complex<double> tempogram_value(const std::vector<float>& strengths, const double cycles_per_strength){
+	const double pi = std::acos(-1.0);
+	const std::complex<double> rotation = std::polar(1.0, -2.0 * pi * cycles_per_strength);
+	std::complex<double> phasor(1.0, 0.0);
+	std::complex<double> sum(0.0, 0.0);
+	for(std::size_t i = 0; i < strengths.size(); i++){
+		sum += double(strengths[i]) * phasor;
+		phasor *= rotation;
+		//Keeps the rounding errors of the rotations from growing its length.
+		if((i & 1023) == 1023) phasor /= std::abs(phasor);
+	}
+	return sum;
+}
+
+///How strongly *strengths* pulse at *bpm*, with its first harmonics sharpening the peak.
+static double score_tempo(const std::vector<float>& strengths, const double bpm, const double onset_rate){
+	const double cycles_per_strength = bpm / (60.0 * onset_rate);
+	return std::abs(tempogram_value(strengths, cycles_per_strength))
+		+ (0.5 * std::abs(tempogram_value(strengths, 2.0 * cycles_per_strength)));
+}
+
+///The best scored tempo from *min_bpm* to *max_bpm* in *step_bpm* steps.
+static double search_tempo(const std::vector<float>& strengths, const double min_bpm, const double max_bpm, const double step_bpm, const double onset_rate){
+	double best_bpm = min_bpm;
+	double best_score = -1.0;
+	for(double bpm = min_bpm; bpm <= max_bpm; bpm += step_bpm){
+		const double score = score_tempo(strengths, bpm, onset_rate);
+		if(score > best_score){
+			best_score = score;
+			best_bpm = bpm;
+		}
+	}
+	return best_bpm;
+}
+
+///The largest of the strengths within 1 strength of the fractional index *position*, 0 outside of *strengths*.
+static float strength_around(const std::vector<float>& strengths, const double position){
+	const std::int64_t nearest = std::llround(position);
+	float strength = 0.0;
+	for(std::int64_t i = nearest - 1; i <= nearest + 1; i++)
+		if(i >= 0 and i < std::int64_t(strengths.size())) strength = std::max(strength, strengths[i]);
+	return strength;
+}
+
+std::optional<BeatEstimate> estimate_beats(const OnsetDetector& onset_detector){
+	const double onset_rate = onset_detector.get_onset_rate();
+	if(onset_detector.get_onset_strengths().size() < min_analysed_seconds * onset_rate) return std::nullopt;
+
+	const std::size_t local_mean_half_width = std::max(1.0, local_mean_seconds * onset_rate / 2.0);
+	const std::vector<float> strengths = remove_local_mean(onset_detector.get_onset_strengths(), local_mean_half_width);
+	const std::vector<float> low_band_strengths = remove_local_mean(onset_detector.get_low_band_onset_strengths(), local_mean_half_width);
+
+	const double strength_sum = std::accumulate(strengths.begin(), strengths.end(), 0.0);
+	if(not (strength_sum > 0.0)) return std::nullopt;
+
+	//1. Tempo from the autocorrelation.
+	const double beat_lag = estimate_beat_lag(autocorrelate(strengths), onset_rate);
+	const double autocorrelation_bpm = 60.0 * onset_rate / beat_lag;
+
+	//2. Tempo refined with the Fourier tempogram, then beats aligned to its phase.
+	const double coarse_bpm = search_tempo(strengths, autocorrelation_bpm * (1.0 - tempogram_search_ratio), autocorrelation_bpm * (1.0 + tempogram_search_ratio),
+											tempogram_coarse_step_bpm, onset_rate);
+	const double bpm = search_tempo(strengths, coarse_bpm - tempogram_coarse_step_bpm, coarse_bpm + tempogram_coarse_step_bpm,
+									tempogram_fine_step_bpm, onset_rate);
+
+	const double pi = std::acos(-1.0);
+	const double cycles_per_strength = bpm / (60.0 * onset_rate);
+	const double strengths_per_beat = 1.0 / cycles_per_strength;
+	const std::complex<double> beat_phasor = tempogram_value(strengths, cycles_per_strength);
+	//Onsets on the beats at n + k/f all rotate to the angle -2*pi*f*n.
+	double first_beat_position = std::fmod(-std::arg(beat_phasor) / (2.0 * pi * cycles_per_strength), strengths_per_beat);
+	if(first_beat_position < 0.0) first_beat_position += strengths_per_beat;
+
+	//Onsets half a beat apart cancel out in the phase, the off-beats of a hi-hat can outweigh the kicks.
+	//Beats are taken to be where the low band onsets are, as kicks are there in most music.
+	const std::size_t beat_count = (strengths.size() - first_beat_position) / strengths_per_beat;
+	double on_beat_low_band_sum = 0.0, off_beat_low_band_sum = 0.0;
+	for(std::size_t beat = 0; beat < beat_count; beat++){
+		on_beat_low_band_sum += strength_around(low_band_strengths, first_beat_position + (beat * strengths_per_beat));
+		off_beat_low_band_sum += strength_around(low_band_strengths, first_beat_position + ((beat + 0.5) * strengths_per_beat));
+	}
+	if(off_beat_low_band_sum > on_beat_low_band_sum) first_beat_position += 0.5 * strengths_per_beat;
+
+	//3. The downbeat is the beat of the bar with the strongest low band onsets.
+	std::array<double, beats_per_bar> low_band_sums{};
+	for(std::size_t beat = 0; beat + 1 < beat_count; beat++)
+		low_band_sums[beat % beats_per_bar] += strength_around(low_band_strengths, first_beat_position + (beat * strengths_per_beat));
+	const std::size_t downbeat = std::max_element(low_band_sums.begin(), low_band_sums.end()) - low_band_sums.begin();
+
+	//The first downbeat at or before the first onset stronger than average, later than half a beat before it.
+	const double mean_strength = strength_sum / strengths.size();
+	const std::size_t first_onset = std::find_if(strengths.begin(), strengths.end(), [mean_strength](const float strength){
+		return strength >= mean_strength;
+	}) - strengths.begin();
+	const double bar_position = std::ceil(((first_onset - (0.5 * strengths_per_beat) - first_beat_position) / strengths_per_beat - downbeat) / beats_per_bar);
+	double first_downbeat_position = first_beat_position + ((downbeat + (bar_position * beats_per_bar)) * strengths_per_beat);
+	//Decks do not play before frame 0.
+	while(first_downbeat_position < 0.0) first_downbeat_position += beats_per_bar * strengths_per_beat;
+
+	return BeatEstimate{bpm, first_downbeat_position * OnsetDetector::hop_frames, std::abs(beat_phasor) / strength_sum};
+}
@@ -0,0 +1,46 @@
+/**
+\file beat_analysis.hpp
+Estimating the tempo, the beats and the first downbeat of a track from its onset detection function.
+*/
+
+#ifndef BEAT_ANALYSIS_HPP
+#define BEAT_ANALYSIS_HPP
+
+#include "OnsetDetector.hpp"
+
+#include <optional>
+
+///The slowest and the fastest tempo estimate_beats() considers.
+constexpr double min_estimated_bpm = 60.0;
+constexpr double max_estimated_bpm = 200.0;
+///The least BeatEstimate::confidence of beats written to a track, drum loops score above 0.09 and noise below 0.06.
+constexpr double min_beat_confidence = 0.08;
+
+///A constant tempo beat grid estimated from the audio of a track.
+struct BeatEstimate{
+	double bpm;
+	///The stdaud frame of the first downbeat at or before the first onset of the track.
+	double first_beat_frame;
+	///How much of the onset strength lies on the beats, from 0 to 1.
+	double confidence;
+
+	///Whether the beats are confident enough to be written to the track, see min_beat_confidence.
+	bool is_confident() const noexcept{
+		return this->confidence >= min_beat_confidence;
+	}
+};
+
+/**
+Estimates the tempo and the beats of the track *onset_detector* was pushed, in 3 steps:
+
+1. The tempo is estimated from the autocorrelation of the onset strengths computed with an FFT,
+   each lag scored with its multiples and weighted towards 120 bpm to choose between tempos an octave apart.
+2. The tempo is refined with a Fourier tempogram around the estimate, to the frequency the onset strengths are the most periodic at,
+   and the phase of that frequency aligns the beats to the onsets.
+3. Of the 4 beats of a bar, the one with the strongest low band onsets is taken as the downbeat.
+
+Returns std::nullopt if the track is too short or holds no onsets.
+*/
+std::optional<BeatEstimate> estimate_beats(const OnsetDetector& onset_detector);
+
+#endif
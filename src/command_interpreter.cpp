@@ -9,10 +9,14 @@
 
 #include <thread>
 #include <cfloat>
+#include <cstdlib>
 #include <chrono>
 #include <string>
 #include <iostream>
 
+///The highest deck gain and master level the commands accept, +6 dB.
+static constexpr float max_gain = 2.0;
+
 void load_command(const std::string& args_str, GlobalStates& global_states){	
 	const std::size_t first_arg_separator_index = args_str.find(' ');
 	if(first_arg_separator_index == std::string::npos){
@@ -24,12 +28,8 @@ void load_command(const std::string& args_str, GlobalStates& global_states){
 		const std::uint8_t track_id = std::stoi(args_str.substr(0, first_arg_separator_index));
 		const std::string aud_filename = args_str.substr(first_arg_separator_index+1);
 		const std::unique_ptr<AudioTrack>& deck_ptr = global_states.audio_tracks.at(track_id);
-		const ntrb_AudioBufferNew_Error new_aud_err = deck_ptr->set_file_to_load_from(aud_filename.c_str(), global_states.get_frames_per_callback());
-		if(new_aud_err){
-			const std::string msg = std::string("Error setting the track (ntrb_AudioBufferNew_Error ") + std::to_string(new_aud_err) + std::string(")");
-			ui::print_to_infobar(msg, UIColorPair_Error);
-		}else 
-			deck_ptr->load_audio_info(aud_filename);
+		//Opened and looked up in the analysis cache on the loader thread of the deck, which reports any errors.
+		deck_ptr->set_file_to_load_from(aud_filename, global_states.pcm_cache_mode.load());
 	}
 	catch(const std::invalid_argument& stoi_fmt_err){
 		ui::print_to_infobar("Track ID not a number.", UIColorPair_Error);
@@ -135,6 +135,324 @@ void toggle_monitor_command(const std::string& args_str, GlobalStates& global_st
 	}
 }
 
+void gain_command(const std::string& args_str, GlobalStates& global_states){
+	const std::size_t first_arg_separator_index = args_str.find(' ');
+	if(first_arg_separator_index == std::string::npos){
+		ui::print_to_infobar("g(ain) command format: g track_id gain", UIColorPair_Error);
+		return;
+	}
+	
+	try{
+		const std::uint8_t track_id = std::stoi(args_str.substr(0, first_arg_separator_index));
+		const float gain = std::stof(args_str.substr(first_arg_separator_index+1));
+		global_states.audio_tracks.at(track_id)->gain = ntrb_clamp_float(gain, 0, max_gain);
+	}
+	catch(const std::invalid_argument& stox_fmt_err){
+		ui::print_to_infobar("All command arguments must be numbers.", UIColorPair_Error);
+	}
+	catch(const std::out_of_range& stox_out_of_range){
+		ui::print_to_infobar("Track ID not in range.", UIColorPair_Error);
+	}
+}
+
+void interpolation_command(const std::string& args_str, GlobalStates& global_states){
+	const std::size_t first_arg_separator_index = args_str.find(' ');
+	if(first_arg_separator_index == std::string::npos){
+		ui::print_to_infobar("i(nterpolation) command format: i track_id interpolation_id (0 linear, 1 cubic Hermite, 2 windowed sinc)", UIColorPair_Error);
+		return;
+	}
+	
+	try{
+		const std::uint8_t track_id = std::stoi(args_str.substr(0, first_arg_separator_index));
+		const int interpolation_id = std::stoi(args_str.substr(first_arg_separator_index+1));
+		if(interpolation_id < 0 or interpolation_id >= (int)resampler_interpolation_names.size()){
+			ui::print_to_infobar("i(nterpolation) command format: i track_id interpolation_id (0 linear, 1 cubic Hermite, 2 windowed sinc)", UIColorPair_Error);
+			return;
+		}
+		global_states.audio_tracks.at(track_id)->interpolation = ResamplerInterpolation(interpolation_id);
+	}
+	catch(const std::invalid_argument& stoi_fmt_err){
+		ui::print_to_infobar("All command arguments must be numbers.", UIColorPair_Error);
+	}
+	catch(const std::out_of_range& stoi_out_of_range){
+		ui::print_to_infobar("Track ID not in range.", UIColorPair_Error);
+	}
+}
+
+void key_lock_command(const std::string& args_str, GlobalStates& global_states){
+	try{
+		const std::uint8_t track_id = std::stoi(args_str);
+		std::atomic_bool& key_lock = global_states.audio_tracks.at(track_id)->key_lock;
+		key_lock = not key_lock.load();
+	}
+	catch(const std::invalid_argument& stoi_fmt_err){
+		ui::print_to_infobar("k(ey lock) command format: k track_id", UIColorPair_Error);
+	}
+	catch(const std::out_of_range& stoi_out_of_range){
+		ui::print_to_infobar("Track ID not in range.", UIColorPair_Error);
+	}
+}
+
+void pcm_cache_command(const std::string& args_str, GlobalStates& global_states){
+	try{
+		const int mode_id = std::stoi(args_str);
+		if(mode_id < 0 or mode_id >= (int)pcm_cache_mode_names.size()){
+			ui::print_to_infobar("pc(m cache) command format: pc mode_id (0 off, 1 RAM, 2 memory-mapped file)", UIColorPair_Error);
+			return;
+		}
+		global_states.pcm_cache_mode = PcmCacheMode(mode_id);
+		ui::print_to_infobar(std::string("PCM cache for tracks loaded from now: ") + pcm_cache_mode_names[mode_id], UIColorPair_Info);
+	}
+	catch(const std::invalid_argument& stoi_fmt_err){
+		ui::print_to_infobar("Mode ID not a number.", UIColorPair_Error);
+	}
+	catch(const std::out_of_range& stoi_out_of_range){
+		ui::print_to_infobar("Mode ID not in range.", UIColorPair_Error);
+	}
+}
+
+void crossfader_command(const std::string& args_str, GlobalStates& global_states){
+	try{
+		const float crossfader_position = std::stof(args_str);
+		global_states.crossfader = ntrb_clamp_float(crossfader_position, -1.0, 1.0);
+	}
+	catch(const std::invalid_argument& stof_fmt_err){
+		ui::print_to_infobar("x(crossfader) command format: x position (-1 left to 1 right)", UIColorPair_Error);
+	}
+	catch(const std::out_of_range& stof_out_of_range){
+		ui::print_to_infobar("Crossfader position not in range.", UIColorPair_Error);
+	}
+}
+
+void master_level_command(const std::string& args_str, GlobalStates& global_states){
+	try{
+		const float master_level = std::stof(args_str);
+		global_states.master_level = ntrb_clamp_float(master_level, 0, max_gain);
+	}
+	catch(const std::invalid_argument& stof_fmt_err){
+		ui::print_to_infobar("m(aster) command format: m level", UIColorPair_Error);
+	}
+	catch(const std::out_of_range& stof_out_of_range){
+		ui::print_to_infobar("Master level not in range.", UIColorPair_Error);
+	}
+}
+
+void control_deck_command(const std::string& args_str, GlobalStates& global_states){
+	const std::size_t first_arg_separator_index = args_str.find(' ');
+	const bool valid_side = first_arg_separator_index == 1 and (args_str[0] == 'l' or args_str[0] == 'r');
+	if(not valid_side){
+		ui::print_to_infobar("c(ontrol) command format: c l|r track_id", UIColorPair_Error);
+		return;
+	}
+	
+	try{
+		const int track_id = std::stoi(args_str.substr(first_arg_separator_index+1));
+		if(track_id < 0 or track_id >= (int)global_states.audio_tracks.size()){
+			ui::print_to_infobar("Track ID not in range.", UIColorPair_Error);
+			return;
+		}
+		if(args_str[0] == 'l') global_states.left_controlled_deck = track_id;
+		else global_states.right_controlled_deck = track_id;
+	}
+	catch(const std::invalid_argument& stoi_fmt_err){
+		ui::print_to_infobar("Track ID not a number.", UIColorPair_Error);
+	}
+	catch(const std::out_of_range& stoi_out_of_range){
+		ui::print_to_infobar("Track ID not in range.", UIColorPair_Error);
+	}
+}
+
+void underrun_policy_command(const std::string& args_str, GlobalStates& global_states){
+	try{
+		const int policy_id = std::stoi(args_str);
+		if(policy_id < 0 or policy_id >= (int)underrun_policy_names.size()){
+			ui::print_to_infobar("u(nderrun policy) command format: u policy_id (0 silence, 1 repeat, 2 fade)", UIColorPair_Error);
+			return;
+		}
+		global_states.underrun_policy = UnderrunPolicy(policy_id);
+		ui::print_to_infobar(std::string("Underrun policy: ") + underrun_policy_names[policy_id], UIColorPair_Info);
+	}
+	catch(const std::invalid_argument& stoi_fmt_err){
+		ui::print_to_infobar("Policy ID not a number.", UIColorPair_Error);
+	}
+	catch(const std::out_of_range& stoi_out_of_range){
+		ui::print_to_infobar("Policy ID not in range.", UIColorPair_Error);
+	}
+}
+
+void sync_command(const std::string& args_str, GlobalStates& global_states){
+	const std::size_t first_arg_separator_index = args_str.find(' ');
+	if(args_str.size() == 0){
+		ui::print_to_infobar("s(ync) command format: s track_id [master_track_id], without a master to stop syncing", UIColorPair_Error);
+		return;
+	}
+	
+	try{
+		const std::uint8_t track_id = std::stoi(args_str.substr(0, first_arg_separator_index));
+		const std::unique_ptr<AudioTrack>& deck_ptr = global_states.audio_tracks.at(track_id);
+		if(first_arg_separator_index == std::string::npos){
+			deck_ptr->sync_master = nullptr;
+			return;
+		}
+		
+		const std::uint8_t master_track_id = std::stoi(args_str.substr(first_arg_separator_index+1));
+		AudioTrack* const master_ptr = global_states.audio_tracks.at(master_track_id).get();
+		//Decks following each other in a loop would only chase each other's corrections, none following its tempo fader.
+		//Every deck follows at most one master, so the chain from the master is at most max_deck_count decks long.
+		for(const AudioTrack* master_of_master = master_ptr; master_of_master != nullptr; master_of_master = master_of_master->sync_master.load()){
+			if(master_of_master == deck_ptr.get()){
+				ui::print_to_infobar("A deck cannot sync to itself or to a deck synced to it.", UIColorPair_Error);
+				return;
+			}
+		}
+		deck_ptr->sync_master = master_ptr;
+	}
+	catch(const std::invalid_argument& stoi_fmt_err){
+		ui::print_to_infobar("Track ID not a number.", UIColorPair_Error);
+	}
+	catch(const std::out_of_range& stoi_out_of_range){
+		ui::print_to_infobar("Track ID not in range.", UIColorPair_Error);
+	}
+}
+
+void loop_crossfade_command(const std::string& args_str, GlobalStates& global_states){
+	try{
+		const std::uint8_t track_id = std::stoi(args_str);
+		std::atomic_bool& loop_crossfade = global_states.audio_tracks.at(track_id)->loop_crossfade;
+		loop_crossfade = not loop_crossfade.load();
+	}
+	catch(const std::invalid_argument& stoi_fmt_err){
+		ui::print_to_infobar("lx (loop crossfade) command format: lx track_id", UIColorPair_Error);
+	}
+	catch(const std::out_of_range& stoi_out_of_range){
+		ui::print_to_infobar("Track ID not in range.", UIColorPair_Error);
+	}
+}
+
+void slip_command(const std::string& args_str, GlobalStates& global_states){
+	try{
+		const std::uint8_t track_id = std::stoi(args_str);
+		std::atomic_bool& slip = global_states.audio_tracks.at(track_id)->slip;
+		slip = not slip.load();
+	}
+	catch(const std::invalid_argument& stoi_fmt_err){
+		ui::print_to_infobar("sl (slip mode) command format: sl track_id", UIColorPair_Error);
+	}
+	catch(const std::out_of_range& stoi_out_of_range){
+		ui::print_to_infobar("Track ID not in range.", UIColorPair_Error);
+	}
+}
+
+void speed_ramp_command(const std::string& args_str, GlobalStates& global_states, const bool spin_up){
+	const std::string format_msg = spin_up 
+									? "su (spin-up) command format: su track_id seconds (0 to 10), how long playing takes to reach the tempo"
+									: "br (brake) command format: br track_id seconds (0 to 10), how long pausing takes to halt";
+	const std::size_t first_arg_separator_index = args_str.find(' ');
+	if(first_arg_separator_index == std::string::npos){
+		ui::print_to_infobar(format_msg, UIColorPair_Error);
+		return;
+	}
+	
+	try{
+		const std::uint8_t track_id = std::stoi(args_str.substr(0, first_arg_separator_index));
+		const double seconds = std::stod(args_str.substr(first_arg_separator_index+1));
+		if(not (seconds >= 0.0 and seconds <= 10.0)){
+			ui::print_to_infobar(format_msg, UIColorPair_Error);
+			return;
+		}
+		
+		AudioTrack& audio_track = *(global_states.audio_tracks.at(track_id));
+		if(spin_up) audio_track.spin_up_seconds = seconds;
+		else audio_track.brake_seconds = seconds;
+	}
+	catch(const std::invalid_argument& stoi_fmt_err){
+		ui::print_to_infobar("All command arguments must be numbers.", UIColorPair_Error);
+	}
+	catch(const std::out_of_range& stoi_out_of_range){
+		ui::print_to_infobar("Track ID not in range.", UIColorPair_Error);
+	}
+}
+
+void quantize_command(const std::string& args_str, GlobalStates& global_states){
+	const std::size_t first_arg_separator_index = args_str.find(' ');
+	if(first_arg_separator_index == std::string::npos){
+		ui::print_to_infobar("qt (quantize) command format: qt track_id mode_id (0 off, 1 beat, 2 half beat, 3 quarter beat)", UIColorPair_Error);
+		return;
+	}
+	
+	try{
+		const std::uint8_t track_id = std::stoi(args_str.substr(0, first_arg_separator_index));
+		const int mode_id = std::stoi(args_str.substr(first_arg_separator_index+1));
+		if(mode_id < 0 or mode_id >= (int)quantize_mode_names.size()){
+			ui::print_to_infobar("qt (quantize) command format: qt track_id mode_id (0 off, 1 beat, 2 half beat, 3 quarter beat)", UIColorPair_Error);
+			return;
+		}
+		global_states.audio_tracks.at(track_id)->quantize = QuantizeMode(mode_id);
+	}
+	catch(const std::invalid_argument& stoi_fmt_err){
+		ui::print_to_infobar("All command arguments must be numbers.", UIColorPair_Error);
+	}
+	catch(const std::out_of_range& stoi_out_of_range){
+		ui::print_to_infobar("Track ID not in range.", UIColorPair_Error);
+	}
+}
+
+void beat_jump_command(const std::string& args_str, GlobalStates& global_states){
+	const std::size_t first_arg_separator_index = args_str.find(' ');
+	if(first_arg_separator_index == std::string::npos){
+		ui::print_to_infobar("bj (beat jump) command format: bj track_id beats (1, 4, 16 or 32, negative to jump back)", UIColorPair_Error);
+		return;
+	}
+	
+	try{
+		const std::uint8_t track_id = std::stoi(args_str.substr(0, first_arg_separator_index));
+		const int beats = std::stoi(args_str.substr(first_arg_separator_index+1));
+		const int beat_count = std::abs(beats);
+		if(beat_count != 1 and beat_count != 4 and beat_count != 16 and beat_count != 32){
+			ui::print_to_infobar("bj (beat jump) command format: bj track_id beats (1, 4, 16 or 32, negative to jump back)", UIColorPair_Error);
+			return;
+		}
+		if(not global_states.audio_tracks.at(track_id)->beat_jump(beats))
+			ui::print_to_infobar("Cannot beat jump, the track has no bpm.", UIColorPair_Error);
+	}
+	catch(const std::invalid_argument& stoi_fmt_err){
+		ui::print_to_infobar("All command arguments must be numbers.", UIColorPair_Error);
+	}
+	catch(const std::out_of_range& stoi_out_of_range){
+		ui::print_to_infobar("Track ID not in range.", UIColorPair_Error);
+	}
+}
+
+void hot_cue_command(const std::string& args_str, GlobalStates& global_states, const bool delete_hot_cue){
+	const std::string format_msg = delete_hot_cue 
+									? "hcd (delete hot cue) command format: hcd track_id hot_cue_number (1 to 8)"
+									: "hc (hot cue) command format: hc track_id hot_cue_number (1 to 8), sets the hot cue if it is not set, otherwise jumps to it";
+	const std::size_t first_arg_separator_index = args_str.find(' ');
+	if(first_arg_separator_index == std::string::npos){
+		ui::print_to_infobar(format_msg, UIColorPair_Error);
+		return;
+	}
+	
+	try{
+		const std::uint8_t track_id = std::stoi(args_str.substr(0, first_arg_separator_index));
+		const int hot_cue_number = std::stoi(args_str.substr(first_arg_separator_index+1));
+		if(hot_cue_number < 1 or hot_cue_number > hot_cue_count){
+			ui::print_to_infobar(format_msg, UIColorPair_Error);
+			return;
+		}
+		
+		AudioTrack& audio_track = *(global_states.audio_tracks.at(track_id));
+		if(delete_hot_cue) audio_track.delete_hot_cue(hot_cue_number - 1);
+		else audio_track.press_hot_cue(hot_cue_number - 1);
+	}
+	catch(const std::invalid_argument& stoi_fmt_err){
+		ui::print_to_infobar("All command arguments must be numbers.", UIColorPair_Error);
+	}
+	catch(const std::out_of_range& stoi_out_of_range){
+		ui::print_to_infobar("Track ID not in range.", UIColorPair_Error);
+	}
+}
+
 void interpret_command(GlobalStates& global_states, const std::string& input_text) noexcept{
 	try{
 		std::string command_str, args_str;
@@ -161,6 +479,40 @@ void interpret_command(GlobalStates& global_states, const std::string& input_tex
 			effect_command(args_str, global_states);
 		else if(command_str == "tm")
 			toggle_monitor_command(args_str, global_states);
+		else if(command_str == "u")
+			underrun_policy_command(args_str, global_states);
+		else if(command_str == "g")
+			gain_command(args_str, global_states);
+		else if(command_str == "i")
+			interpolation_command(args_str, global_states);
+		else if(command_str == "k")
+			key_lock_command(args_str, global_states);
+		else if(command_str == "pc")
+			pcm_cache_command(args_str, global_states);
+		else if(command_str == "x")
+			crossfader_command(args_str, global_states);
+		else if(command_str == "m")
+			master_level_command(args_str, global_states);
+		else if(command_str == "c")
+			control_deck_command(args_str, global_states);
+		else if(command_str == "s")
+			sync_command(args_str, global_states);
+		else if(command_str == "lx")
+			loop_crossfade_command(args_str, global_states);
+		else if(command_str == "sl")
+			slip_command(args_str, global_states);
+		else if(command_str == "br")
+			speed_ramp_command(args_str, global_states, false);
+		else if(command_str == "su")
+			speed_ramp_command(args_str, global_states, true);
+		else if(command_str == "qt")
+			quantize_command(args_str, global_states);
+		else if(command_str == "bj")
+			beat_jump_command(args_str, global_states);
+		else if(command_str == "hc")
+			hot_cue_command(args_str, global_states, false);
+		else if(command_str == "hcd")
+			hot_cue_command(args_str, global_states, true);
 		else ui::print_to_infobar("Invalid command", UIColorPair_Error);
 	}
 	catch(const std::exception& excp){
@@ -19,9 +19,6 @@
 #include <algorithm>
 
 /*
-features:
-- slip mode
-- hot cues
 issues:
 - play/pause and effect having callback delay D:
 */
@@ -87,6 +84,60 @@ std::pair<PaDeviceIndex, PaDeviceIndex> user_select_output_devices(){
 	return std::make_pair(-255, -255);
 }
 
+std::uint32_t user_select_frames_per_callback(){
+	const std::uint32_t default_frames_per_callback = GlobalStates::default_frames_per_callback();
+	
+	while(true){
+		try{
+			std::string frames_per_callback_str;
+			std::cout << "\nFrames per callback (" << GlobalStates::min_frames_per_callback << '-' << GlobalStates::max_frames_per_callback 
+						<< ", empty for " << default_frames_per_callback << "): " << std::flush;
+			std::getline(std::cin, frames_per_callback_str);
+			if(frames_per_callback_str.empty())
+				return default_frames_per_callback;
+			
+			const std::uint32_t frames_per_callback = std::stoul(frames_per_callback_str);
+			if(not GlobalStates::is_valid_frames_per_callback(frames_per_callback)){
+				std::cerr << "Frames per callback not in range.\n";
+				continue;
+			}
+			return frames_per_callback;
+		}
+		catch(const std::invalid_argument& stoul_fmt_err){
+			std::cerr << "Frames per callback is not a number.\n";
+		}
+		catch(const std::out_of_range& stoul_out_of_range){
+			std::cerr << "Frames per callback out of range.\n";
+		}
+	}
+}
+
+std::uint8_t user_select_deck_count(){
+	while(true){
+		try{
+			std::string deck_count_str;
+			std::cout << "Deck count (" << (int)GlobalStates::min_deck_count << '-' << (int)GlobalStates::max_deck_count 
+						<< ", empty for " << (int)GlobalStates::min_deck_count << "): " << std::flush;
+			std::getline(std::cin, deck_count_str);
+			if(deck_count_str.empty())
+				return GlobalStates::min_deck_count;
+			
+			const int deck_count = std::stoi(deck_count_str);
+			if(deck_count < GlobalStates::min_deck_count or deck_count > GlobalStates::max_deck_count){
+				std::cerr << "Deck count not in range.\n";
+				continue;
+			}
+			return deck_count;
+		}
+		catch(const std::invalid_argument& stoi_fmt_err){
+			std::cerr << "Deck count is not a number.\n";
+		}
+		catch(const std::out_of_range& stoi_out_of_range){
+			std::cerr << "Deck count out of range.\n";
+		}
+	}
+}
+
 int main(){
 	#ifdef NTRB_MEMDEBUG
 	ntrb_memdebug_init_with_return_value();
@@ -147,9 +198,10 @@ int main(){
 		return 0;
 	}
 
-	GlobalStates global_states;
-	global_states.audio_tracks.emplace_back(std::make_unique<AudioTrack>(global_states.get_frames_per_callback(), 0));
-	global_states.audio_tracks.emplace_back(std::make_unique<AudioTrack>(global_states.get_frames_per_callback(), 1));
+	GlobalStates global_states(user_select_frames_per_callback());
+	const std::uint8_t deck_count = user_select_deck_count();
+	for(std::uint8_t track_id = 0; track_id < deck_count; track_id++)
+		global_states.audio_tracks.emplace_back(std::make_unique<AudioTrack>(global_states.get_frames_per_callback(), global_states.get_callbacks_rendered_ahead(), track_id, global_states.analysis_cache));
 	
 	const auto [audience_output_device_id, monitor_output_device_id] = user_select_output_devices();
 	OutputDevicesInterface devices_interface(audience_output_device_id, monitor_output_device_id, global_states);
@@ -183,11 +235,19 @@ int main(){
 	ui::draw_center_text(main_window, "Ardcont", 0);
 	refresh();
 
-	const std::uint16_t deck_info_window_width = (main_window_width/2) - 1;
-	ui::left_deck_info_window = newwin(ui::deck_info_height, deck_info_window_width, 1, 1);
-	ui::right_deck_info_window = newwin(ui::deck_info_height, deck_info_window_width, 1, 1 + deck_info_window_width);
-	ui::keyboard_input_window = newwin(ui::input_window_height, main_window_width-2, 1 + ui::deck_info_height, 1);
-	ui::stdout_window = newwin(ui::stdout_window_height, main_window_width-2, 1 + ui::deck_info_height + ui::input_window_height, 1);
+	//Decks are laid out in rows of at most ui::max_deck_info_windows_per_row.
+	const std::uint8_t deck_info_windows_per_row = std::min(deck_count, ui::max_deck_info_windows_per_row);
+	const std::uint8_t deck_info_rows = (deck_count + deck_info_windows_per_row - 1) / deck_info_windows_per_row;
+	const std::uint16_t deck_info_window_width = ((main_window_width - 2) / deck_info_windows_per_row);
+	const std::uint16_t deck_info_total_height = deck_info_rows * ui::deck_info_height;
+	
+	for(std::uint8_t track_id = 0; track_id < deck_count; track_id++){
+		const std::uint16_t window_row = track_id / deck_info_windows_per_row;
+		const std::uint16_t window_column = track_id % deck_info_windows_per_row;
+		ui::deck_info_windows.push_back(newwin(ui::deck_info_height, deck_info_window_width, 1 + (window_row * ui::deck_info_height), 1 + (window_column * deck_info_window_width)));
+	}
+	ui::keyboard_input_window = newwin(ui::input_window_height, main_window_width-2, 1 + deck_info_total_height, 1);
+	ui::stdout_window = newwin(ui::stdout_window_height, main_window_width-2, 1 + deck_info_total_height + ui::input_window_height, 1);
 	
 	if(use_serial){
 		std::thread serial_thread(serial_listener, std::ref(arduino_serial), std::ref(global_states));
@@ -196,14 +256,14 @@ int main(){
 	
 	//global_states.audio_tracks[0]->set_file_to_load_from("../mixaud/bolo.flac", global_states.get_frames_per_callback());
 	
-	std::thread output_devices_interface_thread(devices_interface.run, &devices_interface);
+	std::thread output_devices_interface_thread(&OutputDevicesInterface::run, &devices_interface);
 	std::thread ui_renderer_thread(ui::render_ui, std::ref(global_states));
 	
 	output_devices_interface_thread.join();
 	ui_renderer_thread.join();
 	
-	global_states.audio_tracks[0].reset(nullptr);
-	global_states.audio_tracks[1].reset(nullptr);
+	for(std::unique_ptr<AudioTrack>& track : global_states.audio_tracks)
+		track.reset(nullptr);
 	
 	const PaError portaudio_terminate_error = Pa_Terminate();
 	if(portaudio_terminate_error != paNoError){
@@ -215,8 +275,8 @@ int main(){
 	ntrb_memdebug_uninit(true);
 	#endif
 	
-	delwin(ui::left_deck_info_window);
-	delwin(ui::right_deck_info_window);	
+	for(WINDOW* const deck_info_window : ui::deck_info_windows)
+		delwin(deck_info_window);
 	delwin(ui::keyboard_input_window);
 	delwin(ui::stdout_window);
 	endwin();
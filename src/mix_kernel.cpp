@@ -0,0 +1,137 @@
+#include "mix_kernel.hpp"
+
+#include <cstring>
+#include <algorithm>
+
+#if defined(__GNUC__) and (defined(__x86_64__) or defined(__i386__))
+	#define MIX_KERNEL_X86
+	#include <immintrin.h>
+#endif
+
+/*
+Inputs are summed in groups of at most inputs_per_pass,
+so the gains of a group stay in registers and the output is only written once per group.
+With up to inputs_per_pass decks, this is a single pass over the output.
+*/
+static constexpr std::size_t inputs_per_pass = 8;
+
+void mix_stereo_buffers_scalar(float* const output, const float* const* const inputs,
+								const float* const left_gains, const float* const right_gains,
+								const std::size_t input_count, const std::size_t frame_count) noexcept
+{
+	std::memset(output, 0, frame_count * 2 * sizeof(float));
+
+	for(std::size_t first_input = 0; first_input < input_count; first_input += inputs_per_pass){
+		const std::size_t last_input = std::min(input_count, first_input + inputs_per_pass);
+		for(std::size_t frame = 0; frame < frame_count; frame++){
+			float left = output[frame*2];
+			float right = output[frame*2 + 1];
+			for(std::size_t input = first_input; input < last_input; input++){
+				left += inputs[input][frame*2] * left_gains[input];
+				right += inputs[input][frame*2 + 1] * right_gains[input];
+			}
+			output[frame*2] = left;
+			output[frame*2 + 1] = right;
+		}
+	}
+}
+
+#ifdef MIX_KERNEL_X86
+
+__attribute__((target("sse2")))
+static void mix_stereo_buffers_sse2(float* const output, const float* const* const inputs,
+									const float* const left_gains, const float* const right_gains,
+									const std::size_t input_count, const std::size_t frame_count) noexcept
+{
+	//2 stereo frames per vector.
+	const std::size_t vectorised_frames = frame_count & ~std::size_t(1);
+	std::memset(output, 0, frame_count * 2 * sizeof(float));
+
+	for(std::size_t first_input = 0; first_input < input_count; first_input += inputs_per_pass){
+		const std::size_t group_size = std::min(input_count - first_input, inputs_per_pass);
+		__m128 gains[inputs_per_pass];
+		for(std::size_t i = 0; i < group_size; i++)
+			gains[i] = _mm_setr_ps(left_gains[first_input+i], right_gains[first_input+i], left_gains[first_input+i], right_gains[first_input+i]);
+
+		for(std::size_t frame = 0; frame < vectorised_frames; frame += 2){
+			__m128 sum = _mm_loadu_ps(output + frame*2);
+			for(std::size_t i = 0; i < group_size; i++)
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(inputs[first_input+i] + frame*2), gains[i]));
+			_mm_storeu_ps(output + frame*2, sum);
+		}
+		for(std::size_t frame = vectorised_frames; frame < frame_count; frame++){
+			for(std::size_t i = 0; i < group_size; i++){
+				output[frame*2] += inputs[first_input+i][frame*2] * left_gains[first_input+i];
+				output[frame*2 + 1] += inputs[first_input+i][frame*2 + 1] * right_gains[first_input+i];
+			}
+		}
+	}
+}
+
+__attribute__((target("avx2")))
+static void mix_stereo_buffers_avx2(float* const output, const float* const* const inputs,
+									const float* const left_gains, const float* const right_gains,
+									const std::size_t input_count, const std::size_t frame_count) noexcept
+{
+	//4 stereo frames per vector.
+	const std::size_t vectorised_frames = frame_count & ~std::size_t(3);
+	std::memset(output, 0, frame_count * 2 * sizeof(float));
+
+	for(std::size_t first_input = 0; first_input < input_count; first_input += inputs_per_pass){
+		const std::size_t group_size = std::min(input_count - first_input, inputs_per_pass);
+		__m256 gains[inputs_per_pass];
+		for(std::size_t i = 0; i < group_size; i++){
+			const float left_gain = left_gains[first_input+i];
+			const float right_gain = right_gains[first_input+i];
+			gains[i] = _mm256_setr_ps(left_gain, right_gain, left_gain, right_gain, left_gain, right_gain, left_gain, right_gain);
+		}
+
+		for(std::size_t frame = 0; frame < vectorised_frames; frame += 4){
+			__m256 sum = _mm256_loadu_ps(output + frame*2);
+			for(std::size_t i = 0; i < group_size; i++)
+				sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_loadu_ps(inputs[first_input+i] + frame*2), gains[i]));
+			_mm256_storeu_ps(output + frame*2, sum);
+		}
+		for(std::size_t frame = vectorised_frames; frame < frame_count; frame++){
+			for(std::size_t i = 0; i < group_size; i++){
+				output[frame*2] += inputs[first_input+i][frame*2] * left_gains[first_input+i];
+				output[frame*2 + 1] += inputs[first_input+i][frame*2 + 1] * right_gains[first_input+i];
+			}
+		}
+	}
+	_mm256_zeroupper();
+}
+
+#endif
+
+using MixStereoBuffersFunction = void (*)(float* const, const float* const* const, const float* const, const float* const, const std::size_t, const std::size_t) noexcept;
+
+struct MixKernel{
+	MixStereoBuffersFunction function;
+	const char* name;
+};
+
+static MixKernel select_mix_kernel() noexcept{
+	#ifdef MIX_KERNEL_X86
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx2"))
+		return MixKernel{mix_stereo_buffers_avx2, "AVX2"};
+	if(__builtin_cpu_supports("sse2"))
+		return MixKernel{mix_stereo_buffers_sse2, "SSE2"};
+	#endif
+	return MixKernel{mix_stereo_buffers_scalar, "scalar"};
+}
+
+///Selected once, before main(), so the first call from an audio thread does not pay for the CPU detection.
+static const MixKernel dispatched_mix_kernel = select_mix_kernel();
+
+void mix_stereo_buffers(float* const output, const float* const* const inputs,
+						const float* const left_gains, const float* const right_gains,
+						const std::size_t input_count, const std::size_t frame_count) noexcept
+{
+	dispatched_mix_kernel.function(output, inputs, left_gains, right_gains, input_count, frame_count);
+}
+
+const char* mix_kernel_name() noexcept{
+	return dispatched_mix_kernel.name;
+}
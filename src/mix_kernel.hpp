@@ -0,0 +1,30 @@
+/**
+\file mix_kernel.hpp
+The kernel summing deck buffers into a bus, dispatched at runtime to AVX2, SSE2 or scalar code.
+*/
+
+#ifndef MIX_KERNEL_HPP
+#define MIX_KERNEL_HPP
+
+#include <cstddef>
+
+/**
+Overwrites *output* with the sum of every buffer in *inputs*, each scaled by its own left and right channel gain, in a single pass over *output*.
+
+Every buffer is interleaved stereo stdaud of *frame_count* frames.
+*left_gains* and *right_gains* hold one gain per buffer in *inputs*.
+The buffers do not need to be aligned. *output* is zero filled if *input_count* is 0.
+*/
+void mix_stereo_buffers(float* const output, const float* const* const inputs,
+						const float* const left_gains, const float* const right_gains,
+						const std::size_t input_count, const std::size_t frame_count) noexcept;
+
+///The name of the implementation mix_stereo_buffers() dispatches to on this CPU.
+const char* mix_kernel_name() noexcept;
+
+///The plain C++ implementation, exposed so it can be compared against the dispatched one.
+void mix_stereo_buffers_scalar(float* const output, const float* const* const inputs,
+								const float* const left_gains, const float* const right_gains,
+								const std::size_t input_count, const std::size_t frame_count) noexcept;
+
+#endif
@@ -1,6 +1,7 @@
 #include "output_device.hpp"
 #include "OutputDeviceData.hpp"
 #include "ui.hpp"
+#include "NoAllocationScope.hpp"
 
 #include "ntrb/audeng_wrapper.h"
 #include "ntrb/aud_std_fmt.h"
@@ -19,41 +20,22 @@ static int stream_audio(const void *, void *output_void, unsigned long frameCoun
 {
 	OutputDeviceData* const device_data = (OutputDeviceData*)OutputDeviceData_ptr;
 	try{
+		NoAllocationScope no_allocation("stream_audio()");
 		float* mixed_output = (float*)output_void;
 		const unsigned long stdaud_sample_count = frameCount * ntrb_std_audchannels;
 		std::memset(mixed_output, 0, stdaud_sample_count * sizeof(float));
 
 		GlobalStates& global_states = device_data->global_states;
-		
-		std::atomic_uint8_t* status;
-		if(device_data->is_monitor_device)
-			status = &(global_states.monitor_output_device_status);
-		else status = &(global_states.audience_output_device_status);
-		
 		if(global_states.requested_exit.load()) return paComplete;
 		
-		while(true){
-			const std::uint8_t loaded_status = status->load();
-			const bool can_read_audiotracks 
-				= loaded_status == AudioTrackAccess_ReadyForReading 
-				or loaded_status == AudioTrackAccess_BeingRead;
-				
-			if(can_read_audiotracks or global_states.requested_exit.load()) break;
-			std::this_thread::sleep_for(std::chrono::milliseconds(10));
-		}
-
-		if(status->load() == AudioTrackAccess_ReadyForReading)
-			status->store(AudioTrackAccess_BeingRead);
-		
-		for(const std::unique_ptr<AudioTrack>& track : global_states.audio_tracks){
-			if(device_data->is_monitor_device and (not track->output_to_monitor.load()))
-				continue;
-			const std::vector<float>& track_samples = track->get_samples();
-			for(size_t i = 0; i < stdaud_sample_count; i++)
-				mixed_output[i] += track_samples[i];
+		//The decks are mixed once by the Mixer, each device only copies its bus, concealing it instead of waiting if it is late.
+		SampleRing& bus_ring = device_data->is_monitor_device ? device_data->mixer.get_cue_ring() : device_data->mixer.get_master_ring();
+		const bool underrun = device_data->underrun_concealer.read(bus_ring, mixed_output, stdaud_sample_count, global_states.underrun_policy.load()) > 0;
+		if(underrun){
+			if(device_data->is_monitor_device) global_states.monitor_underrun_count.fetch_add(1, std::memory_order_relaxed);
+			else global_states.audience_underrun_count.fetch_add(1, std::memory_order_relaxed);
 		}
 		
-		status->store(AudioTrackAccess_FinishedReading);
 		return paContinue;
 	}
 	catch(const std::exception& excp){
@@ -80,7 +62,7 @@ void run_output_device(OutputDeviceData device_data) noexcept{
 			if(pa_error) goto close_stream;
 
 			while(device_data.global_states.requested_exit.load() == false){
-				std::this_thread::sleep_for(std::chrono::milliseconds(device_data.global_states.msecs_per_callback));
+				std::this_thread::sleep_for(std::chrono::milliseconds(100));
 			}
 			Pa_StopStream(output_stream);
 			
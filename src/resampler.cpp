@@ -0,0 +1,274 @@
+#include "resampler.hpp"
+
+#include <cmath>
+
+#if defined(__GNUC__) and (defined(__x86_64__) or defined(__i386__))
+	#define RESAMPLER_X86
+	#include <immintrin.h>
+#endif
+
+/*
+Each interpolator reads taps = frames_before + 1 + frames_after consecutive interleaved stereo frames,
+starting frames_before frames before the floored playhead, and writes one stereo frame.
+*/
+
+struct LinearInterpolator{
+	static constexpr std::uint32_t frames_before = 0;
+	static constexpr std::uint32_t frames_after = 1;
+
+	static void interpolate(const float* const frames, const float fraction, float* const output) noexcept{
+		output[0] = frames[0] + fraction * (frames[2] - frames[0]);
+		output[1] = frames[1] + fraction * (frames[3] - frames[1]);
+	}
+};
+
+struct CubicHermiteInterpolator{
+	static constexpr std::uint32_t frames_before = 1;
+	static constexpr std::uint32_t frames_after = 2;
+
+	static void interpolate(const float* const frames, const float fraction, float* const output) noexcept{
+		for(std::uint8_t channel = 0; channel < 2; channel++){
+			const float previous = frames[channel];
+			const float current = frames[2 + channel];
+			const float next = frames[4 + channel];
+			const float after_next = frames[6 + channel];
+
+			const float c1 = 0.5f * (next - previous);
+			const float c2 = previous - (2.5f * current) + (2.0f * next) - (0.5f * after_next);
+			const float c3 = (0.5f * (after_next - previous)) + (1.5f * (current - next));
+			output[channel] = ((((c3 * fraction) + c2) * fraction + c1) * fraction) + current;
+		}
+	}
+};
+
+namespace windowed_sinc{
+	constexpr std::uint32_t taps = 16;
+	constexpr std::uint32_t frames_before = (taps / 2) - 1;
+	constexpr std::uint32_t frames_after = taps / 2;
+
+	/*
+	The fraction of the playhead is split into phase_count phases,
+	and the coefficients are linearly interpolated in between the 2 nearest phases.
+	*/
+	constexpr std::uint32_t phase_count = 128;
+
+	/*
+	The cutoff as a ratio of the Nyquist frequency. Playing at 1.125x (the edge of the tempo fader)
+	folds anything above 1/1.125 of the Nyquist frequency back down, so the cutoff sits just below it.
+	*/
+	constexpr double cutoff = 0.875;
+
+	/*
+	Each coefficient is stored twice in a row, once for the left sample and once for the right sample,
+	so a phase is multiplied against the interleaved frames directly without shuffling.
+	*/
+	constexpr std::uint32_t coefficients_per_phase = taps * 2;
+
+	struct CoefficientTable{
+		alignas(16) float coefficients[phase_count][coefficients_per_phase];
+		///The difference from the coefficients of a phase to the next phase.
+		alignas(16) float deltas[phase_count][coefficients_per_phase];
+	};
+
+	static void compute_phase(const double fraction, double* const phase_coefficients) noexcept{
+		const double pi = std::acos(-1.0);
+		const double half_window = taps / 2;
+		double coefficient_sum = 0.0;
+
+		for(std::uint32_t tap = 0; tap < taps; tap++){
+			//The distance from the tap to the playhead, in frames.
+			const double distance = ((double)tap - frames_before) - fraction;
+			const double sinc_x = pi * cutoff * distance;
+			const double sinc = std::fabs(sinc_x) < 1e-9 ? 1.0 : std::sin(sinc_x) / sinc_x;
+			const double blackman_window = 0.42 + (0.5 * std::cos(pi * distance / half_window)) + (0.08 * std::cos(2.0 * pi * distance / half_window));
+
+			phase_coefficients[tap] = sinc * blackman_window;
+			coefficient_sum += phase_coefficients[tap];
+		}
+		//Unity gain for DC at every phase.
+		for(std::uint32_t tap = 0; tap < taps; tap++)
+			phase_coefficients[tap] /= coefficient_sum;
+	}
+
+	static CoefficientTable compute_coefficient_table() noexcept{
+		CoefficientTable table;
+		double phase_coefficients[taps], next_phase_coefficients[taps];
+		compute_phase(0.0, phase_coefficients);
+
+		for(std::uint32_t phase = 0; phase < phase_count; phase++){
+			compute_phase((double)(phase + 1) / phase_count, next_phase_coefficients);
+			for(std::uint32_t tap = 0; tap < taps; tap++){
+				const float coefficient = phase_coefficients[tap];
+				const float delta = next_phase_coefficients[tap] - phase_coefficients[tap];
+				table.coefficients[phase][tap*2] = table.coefficients[phase][tap*2 + 1] = coefficient;
+				table.deltas[phase][tap*2] = table.deltas[phase][tap*2 + 1] = delta;
+				phase_coefficients[tap] = next_phase_coefficients[tap];
+			}
+		}
+		return table;
+	}
+
+	///Computed once at static initialisation, so no deck pays for it while playing.
+	static const CoefficientTable coefficient_table = compute_coefficient_table();
+
+	static void split_fraction(const float fraction, std::uint32_t& phase, float& phase_fraction) noexcept{
+		const float phase_position = fraction * phase_count;
+		phase = phase_position;
+		if(phase >= phase_count) phase = phase_count - 1;
+		phase_fraction = phase_position - phase;
+	}
+}
+
+struct WindowedSincScalarInterpolator{
+	static constexpr std::uint32_t frames_before = windowed_sinc::frames_before;
+	static constexpr std::uint32_t frames_after = windowed_sinc::frames_after;
+
+	static void interpolate(const float* const frames, const float fraction, float* const output) noexcept{
+		std::uint32_t phase;
+		float phase_fraction;
+		windowed_sinc::split_fraction(fraction, phase, phase_fraction);
+		const float* const coefficients = windowed_sinc::coefficient_table.coefficients[phase];
+		const float* const deltas = windowed_sinc::coefficient_table.deltas[phase];
+
+		float left = 0.0f, right = 0.0f;
+		for(std::uint32_t i = 0; i < windowed_sinc::coefficients_per_phase; i += 2){
+			left += frames[i] * (coefficients[i] + (phase_fraction * deltas[i]));
+			right += frames[i+1] * (coefficients[i+1] + (phase_fraction * deltas[i+1]));
+		}
+		output[0] = left;
+		output[1] = right;
+	}
+};
+
+#ifdef RESAMPLER_X86
+struct WindowedSincSse2Interpolator{
+	static constexpr std::uint32_t frames_before = windowed_sinc::frames_before;
+	static constexpr std::uint32_t frames_after = windowed_sinc::frames_after;
+
+	__attribute__((target("sse2")))
+	static void interpolate(const float* const frames, const float fraction, float* const output) noexcept{
+		std::uint32_t phase;
+		float phase_fraction;
+		windowed_sinc::split_fraction(fraction, phase, phase_fraction);
+		const float* const coefficients = windowed_sinc::coefficient_table.coefficients[phase];
+		const float* const deltas = windowed_sinc::coefficient_table.deltas[phase];
+		const __m128 phase_fractions = _mm_set1_ps(phase_fraction);
+
+		//2 stereo taps per vector, accumulating as left, right, left, right.
+		__m128 sum = _mm_setzero_ps();
+		for(std::uint32_t i = 0; i < windowed_sinc::coefficients_per_phase; i += 4){
+			const __m128 tap_coefficients = _mm_add_ps(_mm_load_ps(coefficients + i), _mm_mul_ps(phase_fractions, _mm_load_ps(deltas + i)));
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(frames + i), tap_coefficients));
+		}
+		sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+		_mm_storel_pi((__m64*)output, sum);
+	}
+};
+#endif
+
+template<typename Interpolator>
+static std::uint32_t resample_with(const SourceSpan& source, PlayheadRamp& playhead, float* const output, const std::uint32_t frame_count, const double end_position) noexcept{
+	constexpr std::uint32_t frames_before = Interpolator::frames_before;
+	constexpr std::uint32_t frames_after = Interpolator::frames_after;
+	constexpr std::uint32_t taps = frames_before + 1 + frames_after;
+
+	//Kept in locals so the loop does not write through the reference every frame.
+	double position = playhead.position;
+	double speed = playhead.speed;
+	const double speed_step = playhead.speed_step;
+
+	const float* const datapoints = source.datapoints;
+	const std::uint64_t first_frame = source.first_frame;
+	const std::uint64_t end_frame = source.end_frame();
+	const bool source_begins_at_track_start = first_frame == 0;
+
+	std::uint32_t rendered_frames = 0;
+	for(; rendered_frames < frame_count; rendered_frames++){
+		if(position >= end_position) break;
+
+		const std::uint64_t floored_frame = position;
+		const float fraction = position - (double)floored_frame;
+		if(floored_frame < first_frame or floored_frame + frames_after >= end_frame) break;
+
+		if(floored_frame >= first_frame + frames_before)
+			Interpolator::interpolate(datapoints + ((floored_frame - frames_before - first_frame) * 2), fraction, output + (rendered_frames * 2));
+		else if(source_begins_at_track_start){
+			//The first frames of the track have taps before the track begins, which are silent.
+			float padded_frames[taps * 2];
+			for(std::uint32_t tap = 0; tap < taps; tap++){
+				const bool before_track_start = floored_frame + tap < frames_before;
+				const std::uint64_t tap_frame = floored_frame + tap - frames_before;
+				padded_frames[tap*2] = before_track_start ? 0.0f : datapoints[tap_frame * 2];
+				padded_frames[tap*2 + 1] = before_track_start ? 0.0f : datapoints[tap_frame * 2 + 1];
+			}
+			Interpolator::interpolate(padded_frames, fraction, output + (rendered_frames * 2));
+		}
+		else break;
+
+		position += speed;
+		speed += speed_step;
+	}
+
+	playhead.position = position;
+	playhead.speed = speed;
+	return rendered_frames;
+}
+
+using ResampleFunction = std::uint32_t (*)(const SourceSpan&, PlayheadRamp&, float* const, const std::uint32_t, const double) noexcept;
+
+struct WindowedSincKernel{
+	ResampleFunction function;
+	const char* name;
+};
+
+#ifdef RESAMPLER_X86
+__attribute__((target("sse2")))
+static std::uint32_t resample_windowed_sinc_sse2(const SourceSpan& source, PlayheadRamp& playhead, float* const output, const std::uint32_t frame_count, const double end_position) noexcept{
+	return resample_with<WindowedSincSse2Interpolator>(source, playhead, output, frame_count, end_position);
+}
+#endif
+
+static WindowedSincKernel select_windowed_sinc_kernel() noexcept{
+	#ifdef RESAMPLER_X86
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("sse2"))
+		return WindowedSincKernel{resample_windowed_sinc_sse2, "SSE2"};
+	#endif
+	return WindowedSincKernel{resample_with<WindowedSincScalarInterpolator>, "scalar"};
+}
+
+///As dispatched_mix_kernel in mix_kernel.cpp.
+static const WindowedSincKernel dispatched_windowed_sinc_kernel = select_windowed_sinc_kernel();
+
+std::uint32_t interpolation_frames_before(const ResamplerInterpolation interpolation) noexcept{
+	switch(interpolation){
+		case ResamplerInterpolation_CubicHermite: return CubicHermiteInterpolator::frames_before;
+		case ResamplerInterpolation_WindowedSinc: return windowed_sinc::frames_before;
+		default: return LinearInterpolator::frames_before;
+	}
+}
+
+std::uint32_t interpolation_frames_after(const ResamplerInterpolation interpolation) noexcept{
+	switch(interpolation){
+		case ResamplerInterpolation_CubicHermite: return CubicHermiteInterpolator::frames_after;
+		case ResamplerInterpolation_WindowedSinc: return windowed_sinc::frames_after;
+		default: return LinearInterpolator::frames_after;
+	}
+}
+
+std::uint32_t resample_block(const SourceSpan& source, PlayheadRamp& playhead, float* const output, const std::uint32_t frame_count,
+							const double end_position, const ResamplerInterpolation interpolation) noexcept
+{
+	switch(interpolation){
+		case ResamplerInterpolation_CubicHermite:
+		return resample_with<CubicHermiteInterpolator>(source, playhead, output, frame_count, end_position);
+		case ResamplerInterpolation_WindowedSinc:
+		return dispatched_windowed_sinc_kernel.function(source, playhead, output, frame_count, end_position);
+		default:
+		return resample_with<LinearInterpolator>(source, playhead, output, frame_count, end_position);
+	}
+}
+
+const char* windowed_sinc_kernel_name() noexcept{
+	return dispatched_windowed_sinc_kernel.name;
+}
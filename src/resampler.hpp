@@ -0,0 +1,80 @@
+/**
+\file resampler.hpp
+Block based varispeed playback of stdaud frames.
+*/
+
+#ifndef RESAMPLER_HPP
+#define RESAMPLER_HPP
+
+#include <array>
+#include <cstdint>
+
+///A read only span of interleaved stereo stdaud frames of a track, starting at a frame of the track.
+struct SourceSpan{
+	const float* datapoints;
+	///The frame of the track which SourceSpan::datapoints begins at.
+	std::uint64_t first_frame;
+	std::uint64_t frame_count;
+
+	std::uint64_t end_frame() const noexcept{
+		return this->first_frame + this->frame_count;
+	}
+};
+
+/**
+The playhead of a deck while a block is rendered.
+
+It is copied out of the atomics of the deck once at the beginning of a block, advanced frame by frame by resample_block(),
+and published back once at the end of the block.
+*/
+struct PlayheadRamp{
+	///The fractional frame of the track to render next.
+	double position;
+	///The amount of frames PlayheadRamp::position advances per rendered frame.
+	double speed;
+	///The amount PlayheadRamp::speed changes per rendered frame, ramping the speed smoothly across a block.
+	double speed_step;
+};
+
+///How resample_block() computes a frame in between the frames of the track, from the cheapest to the least aliasing.
+enum ResamplerInterpolation : std::uint8_t{
+	///Straight line between the 2 nearest frames.
+	ResamplerInterpolation_Linear,
+	///Catmull-Rom cubic Hermite spline through the 4 nearest frames.
+	ResamplerInterpolation_CubicHermite,
+	/**
+	16 tap Blackman windowed-sinc from a precomputed polyphase coefficient table,
+	low passed below the Nyquist frequency so speeding up to the edge of the tempo fader does not alias.
+	*/
+	ResamplerInterpolation_WindowedSinc
+};
+
+constexpr std::array<const char*, (int)ResamplerInterpolation_WindowedSinc+1> resampler_interpolation_names{
+	"Linear",
+	"Cubic Hermite",
+	"Windowed sinc",
+};
+
+///The amount of frames before the floored playhead which *interpolation* reads.
+std::uint32_t interpolation_frames_before(const ResamplerInterpolation interpolation) noexcept;
+///The amount of frames after the floored playhead which *interpolation* reads.
+std::uint32_t interpolation_frames_after(const ResamplerInterpolation interpolation) noexcept;
+
+/**
+Renders up to *frame_count* interleaved stereo frames to *output*, interpolating *source* with *interpolation*
+at the position of *playhead* and advancing it.
+
+Rendering stops early once the playhead reaches *end_position*, or once the next frame would need a frame beyond *source*,
+in which case the caller should provide a span starting interpolation_frames_before() frames before the playhead
+and call the function again for the remaining frames.
+Frames before the first frame of the track are read as silence if *source* begins at the first frame of the track.
+
+Returns the amount of frames written to *output*.
+*/
+std::uint32_t resample_block(const SourceSpan& source, PlayheadRamp& playhead, float* const output, const std::uint32_t frame_count,
+							const double end_position, const ResamplerInterpolation interpolation) noexcept;
+
+///Returns the instruction set ResamplerInterpolation_WindowedSinc was dispatched to for this CPU.
+const char* windowed_sinc_kernel_name() noexcept;
+
+#endif
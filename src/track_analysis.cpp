@@ -0,0 +1,143 @@
+#include "track_analysis.hpp"
+#include "LoudnessMeter.hpp"
+
+#include "ntrb/AudioBuffer.h"
+#include "ntrb/aud_std_fmt.h"
+
+#include <vector>
+#include <utility>
+#include <fstream>
+#include <algorithm>
+#include <sstream>
+#include <filesystem>
+
+///Bumped whenever the layout of waveform files changes.
+static constexpr std::uint64_t waveform_file_version = 1;
+///The frames decoded at once by analyse_track().
+static constexpr std::uint32_t frames_per_decode = 65536;
+///The longest track analysed, longer tracks are only analysed up to this length.
+static constexpr std::uint64_t max_analysed_frames = std::uint64_t(4) * 60 * 60 * 48000;
+
+std::optional<TrackAnalysis> analyse_track(const std::string& filename, const std::function<bool()>& keep_going){
+	ntrb_AudioBuffer decoding_buffer;
+	if(ntrb_AudioBuffer_new(&decoding_buffer, filename.c_str(), frames_per_decode) != ntrb_AudioBufferNew_OK)
+		return std::nullopt;
+
+	OnsetDetector onset_detector(ntrb_std_samplerate);
+	LoudnessMeter loudness_meter(ntrb_std_samplerate);
+	WaveformPyramid waveform;
+	std::uint64_t next_frame = 0;
+	bool decoded = true;
+	while(next_frame < max_analysed_frames){
+		if(not keep_going()){
+			decoded = false;
+			break;
+		}
+
+		decoding_buffer.stdaud_next_buffer_first_frame = next_frame;
+		decoding_buffer.load_buffer_callback(&decoding_buffer);
+		const ntrb_AudioBufferLoad_Error load_err = decoding_buffer.load_err;
+		if(load_err != ntrb_AudioBufferLoad_OK and load_err != ntrb_AudioBufferLoad_EOF){
+			decoded = false;
+			break;
+		}
+
+		const std::uint64_t frame_count = std::min<std::uint64_t>(decoding_buffer.monochannel_samples, max_analysed_frames - next_frame);
+		onset_detector.push_frames(decoding_buffer.datapoints, frame_count);
+		loudness_meter.push_frames(decoding_buffer.datapoints, frame_count);
+		waveform.push_frames(decoding_buffer.datapoints, frame_count);
+		next_frame += frame_count;
+
+		//ntrb will 0 fill its stdaud buffer past the EOF, which is analysed as silence at the end of the track.
+		if(load_err == ntrb_AudioBufferLoad_EOF or frame_count == 0)
+			break;
+	}
+	ntrb_AudioBuffer_free(&decoding_buffer);
+
+	if(not decoded) return std::nullopt;
+	waveform.finish();
+	return TrackAnalysis{next_frame, estimate_beats(onset_detector), loudness_meter.get_integrated_loudness(), std::move(waveform)};
+}
+
+///*aud_filename* with its extension replaced by *extension*.
+static std::string replace_extension(const std::string& aud_filename, const char* const extension){
+	const std::size_t filetype_separator_index = aud_filename.rfind('.');
+	if(filetype_separator_index == std::string::npos)
+		return aud_filename + extension;
+	return aud_filename.substr(0, filetype_separator_index) + extension;
+}
+
+std::string get_audio_info_filename(const std::string& aud_filename){
+	return replace_extension(aud_filename, ".txt");
+}
+
+std::string get_waveform_filename(const std::string& aud_filename){
+	return replace_extension(aud_filename, ".waveform");
+}
+
+///Writes *contents* to *filename* through a temporary file renamed over it, so an interrupted write leaves the old file.
+static bool replace_file(const std::string& filename, const std::string& contents){
+	const std::string temporary_filename = filename + ".tmp";
+	{
+		std::ofstream temporary_file(temporary_filename, std::ios::binary | std::ios::trunc);
+		if(not temporary_file) return false;
+		temporary_file.write(contents.data(), contents.size());
+		if(not temporary_file.flush()) return false;
+	}
+	std::error_code rename_error;
+	std::filesystem::rename(temporary_filename, filename, rename_error);
+	if(rename_error){
+		std::filesystem::remove(temporary_filename, rename_error);
+		return false;
+	}
+	return true;
+}
+
+bool write_audio_info(const std::string& aud_filename, const TrackAnalysis& analysis){
+	const std::string audio_info_filename = get_audio_info_filename(aud_filename);
+
+	std::vector<std::pair<std::string, std::string>> keyword_values;
+	bool has_beats = false;
+	{
+		std::ifstream audio_info_file(audio_info_filename);
+		std::string keyword, value;
+		while(audio_info_file >> keyword >> value){
+			if(keyword == "loudness_lufs") continue;
+			if(keyword == "bpm") has_beats = true;
+			keyword_values.emplace_back(keyword, value);
+		}
+	}
+
+	std::ostringstream contents;
+	contents.precision(10);
+	for(const std::pair<std::string, std::string>& keyword_value : keyword_values)
+		contents << keyword_value.first << ' ' << keyword_value.second << '\n';
+	if(not has_beats and analysis.beats.has_value() and analysis.beats->is_confident()){
+		contents << "bpm " << analysis.beats->bpm << '\n';
+		contents << "first_beat_frame " << analysis.beats->first_beat_frame << '\n';
+	}
+	if(analysis.integrated_loudness.has_value())
+		contents << "loudness_lufs " << analysis.integrated_loudness.value() << '\n';
+
+	return replace_file(audio_info_filename, contents.str());
+}
+
+bool write_waveform_file(const std::string& aud_filename, const TrackAnalysis& analysis){
+	if(analysis.waveform.empty()) return false;
+	const std::vector<WaveformBin>& base_level = analysis.waveform.get_level(0);
+
+	//"ardcwave", the version, the frames per bin and of the track, then every bin of the base level as min, max and rms bytes.
+	std::string contents("ardcwave");
+	const auto append_u64 = [&contents](const std::uint64_t value){
+		for(std::uint8_t byte = 0; byte < 8; byte++) contents.push_back(char((value >> (byte * 8)) & 0xff));
+	};
+	append_u64(waveform_file_version);
+	append_u64(WaveformPyramid::base_bin_frames);
+	append_u64(analysis.waveform.get_frame_count());
+	for(const WaveformBin& bin : base_level){
+		contents.push_back(char(bin.min));
+		contents.push_back(char(bin.max));
+		contents.push_back(char(bin.rms));
+	}
+	return replace_file(get_waveform_filename(aud_filename), contents);
+}
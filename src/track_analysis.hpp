@@ -0,0 +1,58 @@
+/**
+\file track_analysis.hpp
+Analysing a whole track offline, and the files its results are kept in next to the track.
+*/
+
+#ifndef TRACK_ANALYSIS_HPP
+#define TRACK_ANALYSIS_HPP
+
+#include "beat_analysis.hpp"
+#include "WaveformPyramid.hpp"
+
+#include <string>
+#include <cstdint>
+#include <optional>
+#include <functional>
+
+///What analyse_track() found out about a track.
+struct TrackAnalysis{
+	std::uint64_t frame_count;
+	///std::nullopt if no beats could be estimated.
+	std::optional<BeatEstimate> beats;
+	///The integrated loudness in LUFS, std::nullopt for silence.
+	std::optional<double> integrated_loudness;
+	WaveformPyramid waveform;
+};
+
+/**
+Decodes *filename* from start to end with its own ntrb_AudioBuffer and analyses its beats, loudness and waveform.
+What it holds at once only grows with the length of the track, up to a few MB for the longest track analysed.
+
+*keep_going* is called between every decoded buffer, the analysis is abandoned if it returns false.
+Returns std::nullopt if the file could not be decoded or the analysis was abandoned.
+*/
+std::optional<TrackAnalysis> analyse_track(const std::string& filename, const std::function<bool()>& keep_going);
+
+///The audio info file of *aud_filename*: the same file with its extension replaced by .txt.
+std::string get_audio_info_filename(const std::string& aud_filename);
+
+///The waveform file of *aud_filename*: the same file with its extension replaced by .waveform.
+std::string get_waveform_filename(const std::string& aud_filename);
+
+/**
+Writes *analysis* to the audio info file of *aud_filename*, creating it if needed:
+its beats as the bpm and first_beat_frame keywords TrackSource reads, unless they are not BeatEstimate::is_confident(),
+and its loudness as loudness_lufs.
+
+Beats already in the file are kept, so beats corrected by hand are not replaced, as are keywords it does not write.
+The file is replaced at once through a temporary file. Returns false if it could not be written.
+*/
+bool write_audio_info(const std::string& aud_filename, const TrackAnalysis& analysis);
+
+/**
+Writes the base level of the waveform of *analysis* to the waveform file of *aud_filename*.
+Returns false if it could not be written.
+*/
+bool write_waveform_file(const std::string& aud_filename, const TrackAnalysis& analysis);
+
+#endif
@@ -1,9 +1,12 @@
 #include "ui.hpp"
 #include "command_interpreter.hpp"
 
+#include <cmath>
 #include <thread>
 #include <string>
 #include <cstring>
+#include <optional>
+#include <algorithm>
 
 std::string ui::filename_from_filepath(const std::string& filepath){
 	const std::string::size_type last_directory_separator_index = filepath.rfind('/');
@@ -40,18 +43,87 @@ std::string ui::ms_to_mm_ss_mss_str(std::uint32_t ms){
 	return return_str;
 }
 
+/**
+Draws *waveform* across the width of *window* inside its border, ui::waveform_height rows from *first_row*, 
+one column for every *frames_per_column* frames from *first_frame* on, which may lie before the track.
+Each column shows its peaks with '|' around its RMS with '#', the column holding *playhead_frame* is drawn reversed.
+
+Every column is summarised from the level of the pyramid closest to *frames_per_column*, so this costs the same whatever the length of the track.
+*/
+static void draw_waveform(WINDOW* const window, const WaveformPyramid& waveform, const std::uint16_t first_row, 
+							const double first_frame, const double frames_per_column, const double playhead_frame)
+{
+	const std::uint16_t column_count = ui::get_window_width(window) - 2;
+	//Rows away from the middle row a column reaches, the middle row always being drawn for anything but silence.
+	const double half_height = (ui::waveform_height + 1) / 2.0;
+	const std::uint16_t middle_row = first_row + (ui::waveform_height / 2);
+	
+	for(std::uint16_t column = 0; column < column_count; column++){
+		const double column_first_frame = first_frame + (column * frames_per_column);
+		const double column_end_frame = column_first_frame + frames_per_column;
+		const bool holds_playhead = playhead_frame >= column_first_frame and playhead_frame < column_end_frame;
+		
+		std::optional<WaveformBin> bin;
+		if(column_end_frame > 0.0)
+			bin = waveform.summarise(std::uint64_t(std::max(0.0, column_first_frame)), std::uint64_t(column_end_frame));
+		const double peak = bin.has_value() ? std::max(std::abs(bin->min), std::abs(bin->max)) / 127.0 : 0.0;
+		const double rms = bin.has_value() ? bin->rms / 255.0 : 0.0;
+		
+		if(holds_playhead) wattron(window, A_REVERSE);
+		for(std::uint16_t row = first_row; row < first_row + ui::waveform_height; row++){
+			const double rows_from_middle = std::abs(int(row) - int(middle_row));
+			char glyph = ' ';
+			if(rms * half_height > rows_from_middle) glyph = '#';
+			else if(peak * half_height > rows_from_middle) glyph = '|';
+			mvwaddch(window, row, column + 1, glyph);
+		}
+		if(holds_playhead) wattroff(window, A_REVERSE);
+	}
+}
+
+/**
+Marks every hot cue of *audiotrack* with its number on the top row of the waveform drawn from *first_row*,
+with the same *first_frame* and *frames_per_column*. Hot cues outside the waveform are not marked.
+*/
+static void draw_hot_cue_markers(WINDOW* const window, const std::unique_ptr<AudioTrack>& audiotrack, const std::uint16_t first_row,
+									const double first_frame, const double frames_per_column)
+{
+	const std::uint16_t column_count = ui::get_window_width(window) - 2;
+	for(std::uint8_t hot_cue_index = 0; hot_cue_index < hot_cue_count; hot_cue_index++){
+		const double hot_cue = audiotrack->get_hot_cue(hot_cue_index);
+		if(hot_cue == no_hot_cue) continue;
+		
+		const double column = std::floor((hot_cue - first_frame) / frames_per_column);
+		if(column >= 0.0 and column < column_count)
+			mvwaddch(window, first_row, int(column) + 1, '1' + hot_cue_index);
+	}
+}
+
 static void draw_audiotrack_info_to_deck_window(WINDOW* const window, const std::unique_ptr<AudioTrack>& audiotrack){
 	const std::uint32_t current_ms = ui::stdaud_frames_to_ms(audiotrack->get_current_stdaud_frame());
 	
 	mvwprintw(window, 1, 1, ui::filename_from_filepath(audiotrack->get_filename()).c_str());
+	if(audiotrack->is_loading_track()) wprintw(window, " (loading)");
+	else if(audiotrack->is_analysing_track()) wprintw(window, " (analysing)");
 	mvwprintw(window, 2, 1, "%s", ui::ms_to_mm_ss_mss_str(current_ms).c_str());
+	if(audiotrack->get_play_mode() == AudioTrack_slowdown_to_halt)
+		wprintw(window, " Braking");
+	if(audiotrack->slip.load()){
+		wprintw(window, " Slip");
+		if(audiotrack->is_slipping())
+			wprintw(window, " (returning to %s)", ui::ms_to_mm_ss_mss_str(ui::stdaud_frames_to_ms(audiotrack->get_shadow_frame())).c_str());
+	}
 	mvwprintw(window, 3, 1, "BPM: %.2f (%.2fx)", audiotrack->get_bpm() * audiotrack->destination_speed_multiplier.load(), audiotrack->destination_speed_multiplier.load());
 	if(audiotrack->is_loop_queued()){
 		const std::uint32_t loop_begin_ms = ui::stdaud_frames_to_ms(audiotrack->get_loop_frame_begin());
 		const std::uint32_t loop_end_ms = ui::stdaud_frames_to_ms(audiotrack->get_loop_frame_end());
 
-		mvwprintw(window, 4, 1, "Loop %s - %s (%.2f beats)", ui::ms_to_mm_ss_mss_str(loop_begin_ms).c_str(), ui::ms_to_mm_ss_mss_str(loop_end_ms).c_str(), audiotrack->get_beats_per_loop());
+		const char* const loop_cache_state = audiotrack->loop_cache_complete.load() ? (audiotrack->loop_crossfade.load() ? ", cached, crossfaded" : ", cached") : "";
+		mvwprintw(window, 4, 1, "Loop %s - %s (%.2f beats%s)", ui::ms_to_mm_ss_mss_str(loop_begin_ms).c_str(), ui::ms_to_mm_ss_mss_str(loop_end_ms).c_str(), audiotrack->get_beats_per_loop(), loop_cache_state);
 	}
+	const QuantizeMode quantize = audiotrack->quantize.load();
+	if(quantize != QuantizeMode_Off)
+		mvwprintw(window, 5, 1, "Quantize: %s", quantize_mode_names[quantize]);
 	
 	const EffectType effect_type = audiotrack->effect_type;
 	const EffectContainer& effect_container = audiotrack->get_effect_container();
@@ -75,6 +147,37 @@ static void draw_audiotrack_info_to_deck_window(WINDOW* const window, const std:
 	
 	if(audiotrack->output_to_monitor.load())
 		mvwprintw(window, 9, 1, "Monitored");
+	mvwprintw(window, 10, 1, "Underruns: %u", audiotrack->get_underrun_count());
+	mvwprintw(window, 11, 1, "Gain: %.2f", audiotrack->gain.load());
+	mvwprintw(window, 12, 1, "Interpolation: %s", resampler_interpolation_names[audiotrack->interpolation.load()]);
+	if(audiotrack->key_lock.load())
+		mvwprintw(window, 13, 1, "Key lock");
+	if(audiotrack->pcm_cache_complete.load())
+		mvwprintw(window, 14, 1, "PCM cached");
+	else if(audiotrack->pcm_cached_frames.load())
+		mvwprintw(window, 14, 1, "PCM caching: %.1fs", (double)audiotrack->pcm_cached_frames.load() / ntrb_std_samplerate);
+	const AudioTrack* const sync_master = audiotrack->sync_master.load();
+	if(sync_master)
+		mvwprintw(window, 15, 1, "Synced to deck %d", (int)sync_master->get_track_id());
+	
+	const std::shared_ptr<const WaveformPyramid> waveform = audiotrack->get_waveform();
+	const std::uint16_t waveform_columns = ui::get_window_width(window) - 2;
+	if(waveform and not waveform->empty() and waveform_columns > 0){
+		const double current_frame = audiotrack->get_current_stdaud_frame();
+		const double zoomed_frames_per_column = double(ui::zoomed_waveform_frames) / waveform_columns;
+		//Scrolled to keep the playhead in the middle column.
+		const double zoomed_first_frame = current_frame - ((waveform_columns / 2) * zoomed_frames_per_column);
+		const double overview_frames_per_column = double(waveform->get_frame_count()) / waveform_columns;
+		draw_waveform(window, *waveform, ui::zoomed_waveform_row, zoomed_first_frame, zoomed_frames_per_column, current_frame);
+		draw_waveform(window, *waveform, ui::overview_waveform_row, 0.0, overview_frames_per_column, current_frame);
+		draw_hot_cue_markers(window, audiotrack, ui::zoomed_waveform_row, zoomed_first_frame, zoomed_frames_per_column);
+		draw_hot_cue_markers(window, audiotrack, ui::overview_waveform_row, 0.0, overview_frames_per_column);
+	}
+	
+	//Between the waveforms, the number of every hot cue set.
+	mvwprintw(window, ui::overview_waveform_row - 1, 1, "Hot cues:");
+	for(std::uint8_t hot_cue_index = 0; hot_cue_index < hot_cue_count; hot_cue_index++)
+		wprintw(window, " %c", audiotrack->get_hot_cue(hot_cue_index) == no_hot_cue ? '-' : char('1' + hot_cue_index));
 }
 
 void ui::print_to_infobar(const std::string& msg, UIColorPairIndex message_color){
@@ -89,17 +192,21 @@ void ui::render_ui(GlobalStates& global_states) noexcept{
 	
 	while(not global_states.requested_exit.load()){
 		try{
-			werase(ui::left_deck_info_window);
-			box(ui::left_deck_info_window, 0, 0);
-			ui::draw_center_text(ui::left_deck_info_window, "Left Deck", 0);
-			draw_audiotrack_info_to_deck_window(ui::left_deck_info_window, global_states.audio_tracks[0]);
-			wrefresh(ui::left_deck_info_window);
+			const std::uint8_t left_controlled_deck = global_states.left_controlled_deck.load();
+			const std::uint8_t right_controlled_deck = global_states.right_controlled_deck.load();
 			
-			werase(ui::right_deck_info_window);
-			box(ui::right_deck_info_window, 0, 0);
-			ui::draw_center_text(ui::right_deck_info_window, "Right Deck", 0);
-			draw_audiotrack_info_to_deck_window(ui::right_deck_info_window, global_states.audio_tracks[1]);
-			wrefresh(ui::right_deck_info_window);
+			for(std::size_t deck_index = 0; deck_index < ui::deck_info_windows.size(); deck_index++){
+				WINDOW* const deck_info_window = ui::deck_info_windows[deck_index];
+				std::string deck_title = std::string("Deck ") + std::to_string(deck_index);
+				if(deck_index == left_controlled_deck) deck_title += " (L)";
+				if(deck_index == right_controlled_deck) deck_title += " (R)";
+				
+				werase(deck_info_window);
+				box(deck_info_window, 0, 0);
+				ui::draw_center_text(deck_info_window, deck_title.c_str(), 0);
+				draw_audiotrack_info_to_deck_window(deck_info_window, global_states.audio_tracks[deck_index]);
+				wrefresh(deck_info_window);
+			}
 			
 			werase(ui::stdout_window);
 			const bool last_message_timed_out = std::chrono::steady_clock::now() - std::get<2>(ui::last_infobar_message) > ui::infobar_timeout;
@@ -113,6 +220,9 @@ void ui::render_ui(GlobalStates& global_states) noexcept{
 				attroff(A_REVERSE);
 			}else
 				mvwprintw(ui::stdout_window, 0, 3, " ");					
+			mvwprintw(ui::stdout_window, 1, 3, "Crossfader: %.2f Master: %.2f Underruns: audience %u, monitor %u", 
+						global_states.crossfader.load(), global_states.master_level.load(),
+						global_states.audience_underrun_count.load(), global_states.monitor_underrun_count.load());
 			
 			wrefresh(ui::stdout_window);
 			
@@ -7,6 +7,7 @@
 
 #include <cstring>
 #include <chrono>
+#include <vector>
 #include <utility>
 
 enum UIColorPairIndex: uint8_t{
@@ -17,8 +18,8 @@ enum UIColorPairIndex: uint8_t{
 };
 
 namespace ui{
-	inline WINDOW* left_deck_info_window;
-	inline WINDOW* right_deck_info_window;
+	///One window for each deck, indexed the same as GlobalStates::audio_tracks.
+	inline std::vector<WINDOW*> deck_info_windows;
 	inline WINDOW* keyboard_input_window;
 	inline WINDOW* stdout_window;
 	
@@ -27,7 +28,14 @@ namespace ui{
 
 	inline constexpr std::uint16_t input_window_height = 3;
 	inline constexpr std::uint16_t stdout_window_height = 2;
-	inline constexpr std::uint16_t deck_info_height = 20;
+	inline constexpr std::uint16_t deck_info_height = 24;
+	///The rows of the deck windows the waveform around the playhead and the waveform of the whole track are drawn from, 3 rows each.
+	inline constexpr std::uint16_t zoomed_waveform_row = 16;
+	inline constexpr std::uint16_t overview_waveform_row = 20;
+	inline constexpr std::uint16_t waveform_height = 3;
+	///The length of track shown across the waveform around the playhead, 6 seconds.
+	inline constexpr std::uint32_t zoomed_waveform_frames = 6 * 48000;
+	inline constexpr std::uint8_t max_deck_info_windows_per_row = 4;
 	inline std::uint16_t deck_info_window_width = 20;
 	inline bool has_colors = false;
 	